@@ -3,6 +3,7 @@
 
 #include "buntils/buntils.h"
 #include "buntils/INIentry.h"
+#include "buntils/Serializer.h"
 #include <iomanip>
 #include <sstream>
 #include <stdlib.h>
@@ -57,11 +58,13 @@ void INIentry::SetInt(int64_t i)
 {
   _ivalue = i;
   _dvalue = (double)i;
-  _svalue = std::to_string(i);
+  _svalue.clear();
+  AppendNumber(_svalue, i);
 }
 void INIentry::SetFloat(double d)
 {
   _ivalue = (int64_t)d;
   _dvalue = d;
-  _svalue = std::to_string(d);
+  _svalue.clear();
+  AppendNumber(_svalue, d);
 }
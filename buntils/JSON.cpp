@@ -0,0 +1,988 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "buntils/buntils.h"
+#include "buntils/JSON.h"
+#include "buntils/Hash.h"
+#include <bit>
+#include <charconv>
+#include <string.h>
+#ifdef BUN_SSE_ENABLED
+  #include <immintrin.h>
+#endif
+
+#if defined(BUN_COMPILER_GCC) || defined(BUN_COMPILER_CLANG)
+  #define BUN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define BUN_TARGET_AVX2
+#endif
+
+using namespace bun;
+
+namespace {
+  // Bitmasks describing a 64 byte block of JSON, where bit i is set if byte i is that kind of character
+  struct JSONBlock
+  {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op; // { } [ ] : ,
+    uint64_t ws; // space, \t, \n, \r
+  };
+
+  // Everything stage 1 needs to carry over from one block to the next
+  struct JSONIndexState
+  {
+    uint64_t oddBackslash = 0; // 1 if the last block ended in an odd number of backslashes
+    uint64_t inString     = 0; // All ones if the last block ended inside a string
+    uint64_t scalar       = 0; // 1 if the last block ended partway through a number or literal
+  };
+
+  // Sets each bit to the XOR of itself and every bit below it, which turns quote positions into string regions
+  BUN_FORCEINLINE uint64_t PrefixXor(uint64_t m)
+  {
+    m ^= m << 1;
+    m ^= m << 2;
+    m ^= m << 4;
+    m ^= m << 8;
+    m ^= m << 16;
+    m ^= m << 32;
+    return m;
+  }
+
+  // Returns the characters that are escaped, meaning they come right after an odd length run of backslashes. Adding the
+  // start of each run to the run carries through it and lands one past its end, so the parity of where a run starts and
+  // where that carry lands tells us if its length was odd.
+  BUN_FORCEINLINE uint64_t FindEscaped(uint64_t backslash, uint64_t& oddBackslash)
+  {
+    const uint64_t even = 0x5555555555555555ULL;
+    const uint64_t odd  = ~even;
+
+    uint64_t starts     = backslash & ~(backslash << 1);
+    uint64_t evenMask   = even ^ oddBackslash; // A run continued from the last block flips which starts count as even
+    uint64_t evenStarts = starts & evenMask;
+    uint64_t oddStarts  = starts & ~evenMask;
+    uint64_t evenEnds   = (backslash + evenStarts) & ~backslash;
+    uint64_t oddCarries = backslash + oddStarts;
+    bool overflow       = oddCarries < backslash;
+    uint64_t oddEnds    = (oddCarries | oddBackslash) & ~backslash;
+    oddBackslash        = overflow;
+    return (evenEnds & odd) | (oddEnds & even);
+  }
+
+  BUN_FORCEINLINE void GrowIndex(std::vector<uint32_t>& index, size_t n)
+  {
+    if(index.size() < n + 64)
+      index.resize(bun_max(index.size() * 2, n + 64));
+  }
+
+  // Finds the structural characters in one block and appends their offsets to index
+  BUN_FORCEINLINE void IndexBlock(const JSONBlock& b, JSONIndexState& s, size_t offset, std::vector<uint32_t>& index,
+                                  size_t& n)
+  {
+    uint64_t quote    = b.quote & ~FindEscaped(b.backslash, s.oddBackslash);
+    uint64_t inString = PrefixXor(quote) ^ s.inString; // Includes the opening quote but not the closing one
+    s.inString        = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+    // Scalars are numbers and literals, and only their first character is structural
+    uint64_t scalar   = ~(b.op | b.ws);
+    uint64_t nonquote = scalar & ~quote;
+    uint64_t follows  = (nonquote << 1) | s.scalar;
+    s.scalar          = nonquote >> 63;
+
+    uint64_t bits = (b.op | (scalar & ~follows)) & ~(inString ^ quote);
+
+    GrowIndex(index, n);
+    uint32_t* out = index.data() + n;
+    n += std::popcount(bits);
+    for(; bits; bits &= bits - 1)
+      *(out++) = static_cast<uint32_t>(offset + std::countr_zero(bits));
+  }
+
+  BUN_FORCEINLINE uint64_t ScalarMask(const char* p, char c)
+  {
+    uint64_t m = 0;
+    for(int i = 0; i < 64; ++i)
+      m |= uint64_t(p[i] == c) << i;
+    return m;
+  }
+
+  inline JSONBlock LoadScalar(const char* p)
+  {
+    JSONBlock b;
+    b.quote     = ScalarMask(p, '"');
+    b.backslash = ScalarMask(p, '\\');
+    b.op        = ScalarMask(p, '{') | ScalarMask(p, '}') | ScalarMask(p, '[') | ScalarMask(p, ']') | ScalarMask(p, ':') |
+           ScalarMask(p, ',');
+    b.ws        = ScalarMask(p, ' ') | ScalarMask(p, '\t') | ScalarMask(p, '\n') | ScalarMask(p, '\r');
+    return b;
+  }
+
+#ifdef BUN_SSE_ENABLED
+  inline JSONBlock LoadSSE2(const char* p)
+  {
+    JSONBlock b = { 0 };
+    for(int i = 0; i < 4; ++i)
+    {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+      __m128i l = _mm_or_si128(x, _mm_set1_epi8(0x20)); // Folds [ and ] onto { and }
+      __m128i op =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('{')), _mm_cmpeq_epi8(l, _mm_set1_epi8('}'))),
+                     _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(':')), _mm_cmpeq_epi8(x, _mm_set1_epi8(','))));
+      __m128i ws =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\t'))),
+                     _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+
+      b.quote |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('"'))))) << (i * 16);
+      b.backslash |= uint64_t(uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\\'))))) << (i * 16);
+      b.op |= uint64_t(uint32_t(_mm_movemask_epi8(op))) << (i * 16);
+      b.ws |= uint64_t(uint32_t(_mm_movemask_epi8(ws))) << (i * 16);
+    }
+    return b;
+  }
+
+  BUN_TARGET_AVX2 inline JSONBlock LoadAVX2(const char* p)
+  {
+    JSONBlock b = { 0 };
+    for(int i = 0; i < 2; ++i)
+    {
+      __m256i x  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i * 32));
+      __m256i l  = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+      __m256i op = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(l, _mm256_set1_epi8('}'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(','))));
+      __m256i ws = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r'))));
+
+      b.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('"'))))) << (i * 32);
+      b.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\'))))) << (i * 32);
+      b.op |= uint64_t(uint32_t(_mm256_movemask_epi8(op))) << (i * 32);
+      b.ws |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << (i * 32);
+    }
+    return b;
+  }
+#endif
+
+  // Runs stage 1 over buf. The last partial block is copied into a buffer padded with spaces, so the loads never read
+  // past the end of buf.
+  template<JSONBlock (*LOAD)(const char*)>
+  BUN_FORCEINLINE void IndexAll(std::span<const char> buf, std::vector<uint32_t>& index)
+  {
+    assert(buf.size() <= UINT32_MAX);
+    JSONIndexState s;
+    size_t n = index.size();
+    size_t i = 0;
+    index.resize(n + (buf.size() / 8) + 64); // Most documents have fewer structural characters than this
+
+    for(; i + 64 <= buf.size(); i += 64)
+      IndexBlock(LOAD(buf.data() + i), s, i, index, n);
+
+    if(i < buf.size())
+    {
+      char tail[64];
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, buf.data() + i, buf.size() - i);
+      IndexBlock(LOAD(tail), s, i, index, n);
+    }
+    index.resize(n);
+  }
+
+  // Stage 2: builds a JSONValue by walking the structural index from stage 1
+  class JSONIndexWalker
+  {
+  public:
+    JSONIndexWalker(std::span<const char> buf, std::span<const uint32_t> index) : _buf(buf), _index(index), _i(0) {}
+
+    bool Value(JSONValue& v)
+    {
+      if(_i >= _index.size())
+        return false;
+
+      switch(_buf[_index[_i]])
+      {
+      case '{':
+      {
+        v         = JSONValue::JSONObject();
+        auto& obj = v.get<JSONValue::JSONObject>();
+        ++_i;
+        while(_peek() != '}')
+        {
+          Str key;
+          if(_peek() != '"' || !_string(key) || _peek() != ':')
+            return false;
+          ++_i;
+          auto k = obj.AddConstruct(std::move(key), JSONValue());
+          if(_peek() != ',' && _peek() != '}' && !Value(obj[k].second))
+            return false;
+          if(_peek() == ',')
+            ++_i;
+          else if(_peek() != '}')
+            return false;
+        }
+        ++_i;
+        return true;
+      }
+      case '[':
+      {
+        v         = JSONValue::JSONArray();
+        auto& arr = v.get<JSONValue::JSONArray>();
+        ++_i;
+        while(_peek() != ']')
+        {
+          auto k = arr.AddConstruct();
+          if(_peek() != ',' && !Value(arr[k]))
+            return false;
+          if(_peek() == ',')
+            ++_i;
+          else if(_peek() != ']')
+            return false;
+        }
+        ++_i;
+        return true;
+      }
+      case '"':
+        v = Str();
+        return _string(v.get<Str>());
+      default: return _scalar(v);
+      }
+    }
+
+  protected:
+    // Returns the structural character we're on, or 0 if we ran out
+    BUN_FORCEINLINE char _peek() const { return (_i < _index.size()) ? _buf[_index[_i]] : 0; }
+    bool _string(std::string& s)
+    {
+      const char* cur = _buf.data() + _index[_i++] + 1;
+      JSONBufferReader r(cur, _buf.data() + _buf.size());
+      JSONEngine::ParseJSONString(s, r); // The closing quote isn't indexed, so this still has to scan for it
+      return r.get() == '"';
+    }
+    BUN_FORCEINLINE static bool _literal(const char* p, const char* end, std::string_view s)
+    {
+      return static_cast<size_t>(end - p) == s.size() && !memcmp(p, s.data(), s.size());
+    }
+    bool _scalar(JSONValue& v)
+    {
+      const char* p   = _buf.data() + _index[_i++];
+      const char* end = (_i < _index.size()) ? _buf.data() + _index[_i] : _buf.data() + _buf.size();
+      while(end > p && isspace(static_cast<unsigned char>(end[-1])))
+        --end;
+
+      if(_literal(p, end, "null")) // null is left as an empty value
+        return true;
+      if(_literal(p, end, "true") || _literal(p, end, "false"))
+      {
+        v = (*p == 't');
+        return true;
+      }
+
+      if(std::find_if(p, end, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) == end)
+      {
+        int64_t i;
+        auto [ptr, ec] = std::from_chars(p, end, i);
+        if(ec == std::errc() && ptr == end)
+        {
+          v = i;
+          return true;
+        }
+      }
+
+      double d;
+      auto [ptr, ec] = std::from_chars(p, end, d);
+      if(ec != std::errc() || ptr != end)
+        return false;
+      v = d;
+      return true;
+    }
+
+    std::span<const char> _buf;
+    std::span<const uint32_t> _index;
+    size_t _i;
+  };
+}
+
+void bun::internal::JSONStructuralIndexScalar(std::span<const char> buf, std::vector<uint32_t>& index)
+{
+  IndexAll<&LoadScalar>(buf, index);
+}
+
+#ifdef BUN_SSE_ENABLED
+void bun::internal::JSONStructuralIndexSSE2(std::span<const char> buf, std::vector<uint32_t>& index)
+{
+  IndexAll<&LoadSSE2>(buf, index);
+}
+
+BUN_TARGET_AVX2 void bun::internal::JSONStructuralIndexAVX2(std::span<const char> buf, std::vector<uint32_t>& index)
+{
+  IndexAll<&LoadAVX2>(buf, index);
+}
+#endif
+
+void bun::JSONStructuralIndex(std::span<const char> buf, std::vector<uint32_t>& index)
+{
+#ifdef BUN_SSE_ENABLED
+  static const bool avx2 = bunGetCPUInfo().sse >= bunCPUInfo::SSE_AVX2;
+  if(avx2)
+    internal::JSONStructuralIndexAVX2(buf, index);
+  else
+    internal::JSONStructuralIndexSSE2(buf, index);
+#else
+  internal::JSONStructuralIndexScalar(buf, index);
+#endif
+}
+
+bool bun::ParseJSONIndexed(JSONValue& value, std::span<const char> buf)
+{
+  std::vector<uint32_t> index;
+  JSONStructuralIndex(buf, index);
+  return JSONIndexWalker(buf, index).Value(value);
+}
+
+JSONDocument::Node JSONDocument::Node::operator[](size_t i) const
+{
+  if(i >= size())
+    return Node();
+  auto it = begin();
+  while(i--)
+    ++it;
+  return *it;
+}
+
+JSONDocument::Node JSONDocument::Node::operator[](std::string_view key) const
+{
+  if(!IsObject())
+    return Node();
+  uint32_t t = _doc->_find(_t, key);
+  return t ? Node(_doc, t) : Node();
+}
+
+void JSONDocument::Node::CopyTo(JSONValue& v) const
+{
+  if(IsObject())
+  {
+    v         = JSONValue::JSONObject();
+    auto& obj = v.get<JSONValue::JSONObject>();
+    for(auto n : *this)
+    {
+      std::string_view key = n.Key();
+      auto k               = obj.AddConstruct(Str(key.data(), key.size()), JSONValue());
+      n.CopyTo(obj[k].second);
+    }
+  }
+  else if(IsArray())
+  {
+    v         = JSONValue::JSONArray();
+    auto& arr = v.get<JSONValue::JSONArray>();
+    for(auto n : *this)
+      n.CopyTo(arr[arr.AddConstruct()]);
+  }
+  else if(is<std::string_view>())
+  {
+    std::string_view s = get<std::string_view>();
+    v                  = Str(s.data(), s.size());
+  }
+  else if(is<bool>())
+    v = get<bool>();
+  else if(is<int64_t>())
+    v = get<int64_t>();
+  else if(is<double>())
+    v = get<double>();
+  else
+    v = JSONValue::BASE();
+}
+
+bool JSONDocument::Parse(std::span<const char> buf)
+{
+  _clear();
+  if(buf.size() >= UINT32_MAX)
+    return false;
+
+  std::vector<uint32_t> index;
+  JSONStructuralIndex(buf, index);
+  _src = _arena.AllocT<char>(buf.size());
+  _len = buf.size();
+  MEMCPY(_src, _len, buf.data(), buf.size());
+  _tape = _arena.AllocT<Entry>(index.size()); // Every entry starts at a different structural character
+
+  size_t i = 0;
+  if(!_build(index, i))
+  {
+    _clear();
+    return false;
+  }
+  return true;
+}
+
+void JSONDocument::_clear()
+{
+  _arena.Clear();
+  _src   = nullptr;
+  _len   = 0;
+  _tape  = nullptr;
+  _count = 0;
+  _strings.clear();
+  _tables.clear();
+}
+
+bool JSONDocument::_build(std::span<const uint32_t> index, size_t& i)
+{
+  if(i >= index.size())
+    return false;
+
+  auto peek  = [&]() -> char { return (i < index.size()) ? _src[index[i]] : 0; };
+  auto next  = [&]() -> uint32_t { return (i < index.size()) ? index[i] : static_cast<uint32_t>(_len); };
+  uint32_t t = _count++;
+  Entry& e   = _tape[t];
+  e          = { index[i], 0, 0, 0 };
+
+  switch(_src[index[i++]])
+  {
+  case '{':
+    while(peek() != '}')
+    {
+      if(peek() != '"')
+        return false;
+      uint32_t key    = index[i++];
+      _tape[_count++] = { key, next(), 0, 0 };
+      if(peek() != ':')
+        return false;
+      ++i;
+      if(peek() == ',' || peek() == '}') // A missing value points at whatever comes after it, which reads as null
+        _tape[_count++] = { index[i], index[i], 0, 0 };
+      else if(!_build(index, i))
+        return false;
+      ++e.size;
+      if(peek() == ',')
+        ++i;
+      else if(peek() != '}')
+        return false;
+    }
+    ++i;
+    e.end = _count;
+    return true;
+  case '[':
+    while(peek() != ']')
+    {
+      if(peek() == ',')
+        _tape[_count++] = { index[i], index[i], 0, 0 };
+      else if(!_build(index, i))
+        return false;
+      ++e.size;
+      if(peek() == ',')
+        ++i;
+      else if(peek() != ']')
+        return false;
+    }
+    ++i;
+    e.end = _count;
+    return true;
+  case '"': e.end = next(); return true;
+  case 't':
+  case 'f':
+  case 'n':
+  {
+    e.end              = next();
+    std::string_view s = _token(t);
+    return s == "true" || s == "false" || s == "null";
+  }
+  case '-':
+  case '0':
+  case '1':
+  case '2':
+  case '3':
+  case '4':
+  case '5':
+  case '6':
+  case '7':
+  case '8':
+  case '9': e.end = next(); return true; // The rest of the number isn't checked until it's read
+  }
+  return false;
+}
+
+std::string_view JSONDocument::_token(uint32_t t) const
+{
+  const char* p   = _src + _tape[t].offset;
+  const char* end = _src + _tape[t].end;
+  while(end > p && isspace(static_cast<unsigned char>(end[-1])))
+    --end;
+  return std::string_view(p, end - p);
+}
+
+bool JSONDocument::_integral(uint32_t t) const
+{
+  return _token(t).find_first_of(".eE") == std::string_view::npos;
+}
+
+int64_t JSONDocument::_int(uint32_t t) const
+{
+  std::string_view s = _token(t);
+  int64_t i;
+  auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), i);
+  return (ec == std::errc() && ptr == s.data() + s.size()) ? i : static_cast<int64_t>(_double(t));
+}
+
+double JSONDocument::_double(uint32_t t) const
+{
+  std::string_view s = _token(t);
+  double d;
+  auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), d);
+  return (ec == std::errc() && ptr == s.data() + s.size()) ? d : 0.0;
+}
+
+std::string_view JSONDocument::_string(uint32_t t) const
+{
+  Entry& e = _tape[t];
+  if(e.cache)
+    return _strings[e.cache - 1];
+
+  const char* cur = _src + e.offset + 1;
+  const char* end = _src + e.end; // The closing quote has to come before the next structural character
+  const char* p   = JSONBufferReader::FindQuote(cur, end);
+  if(p >= end || *p == '"')
+    return std::string_view(cur, p - cur); // Without escapes, the string is already sitting in the source
+
+  // Only strings with escape sequences are decoded into the arena and cached
+  std::string buf(cur, p);
+  cur = p;
+  JSONBufferReader r(cur, end);
+  JSONEngine::ParseJSONString(buf, r);
+  char* s = _arena.AllocT<char>(buf.size());
+  MEMCPY(s, buf.size(), buf.data(), buf.size());
+  _strings.emplace_back(s, buf.size());
+  e.cache = static_cast<uint32_t>(_strings.size());
+  return _strings.back();
+}
+
+uint32_t JSONDocument::_find(uint32_t t, std::string_view key) const
+{
+  Entry& e = _tape[t];
+  if(e.size <= 8) // Hashing every key isn't worth it for small objects
+  {
+    for(uint32_t k = t + 1; k < e.end; k = _skip(k + 1))
+      if(_string(k) == key)
+        return k + 1;
+    return 0;
+  }
+
+  uint32_t mask = std::bit_ceil(e.size * 2) - 1;
+  if(!e.cache)
+  {
+    uint32_t* table = _arena.AllocT<uint32_t>(mask + 1);
+    memset(table, 0, (mask + 1) * sizeof(uint32_t));
+    for(uint32_t k = t + 1; k < e.end; k = _skip(k + 1)) // Tape index 0 is always the root, so it marks empty slots
+    {
+      std::string_view s = _string(k);
+      uint32_t h         = KH_STR_HASH<char, false>(s.data(), s.size()) & mask;
+      while(table[h])
+        h = (h + 1) & mask;
+      table[h] = k;
+    }
+    _tables.push_back(table);
+    e.cache = static_cast<uint32_t>(_tables.size());
+  }
+
+  const uint32_t* table = _tables[e.cache - 1];
+  for(uint32_t h = KH_STR_HASH<char, false>(key.data(), key.size()) & mask; table[h]; h = (h + 1) & mask)
+    if(_string(table[h]) == key)
+      return table[h] + 1;
+  return 0;
+}
+
+JSONReader::JSONReader() { Reset(); }
+
+void JSONReader::Reset()
+{
+  _cur      = nullptr;
+  _end      = nullptr;
+  _state    = STATE_ROOT;
+  _token    = TOKEN_NONE;
+  _finished = false;
+  _pending  = false;
+  _escaped  = false;
+  _bool     = false;
+  _int      = 0;
+  _double   = 0.0;
+  _str      = std::string_view();
+  _stack.clear();
+  _partial.clear();
+  _decoded.clear();
+}
+
+void JSONReader::Feed(std::span<const char> chunk)
+{
+  assert(_cur >= _end);
+  _cur = chunk.data();
+  _end = chunk.data() + chunk.size();
+}
+
+void JSONReader::Finish() { _finished = true; }
+
+JSONEvent JSONReader::Next()
+{
+  if(_state == STATE_ERROR)
+    return JSONEvent::Error;
+  if(_token != TOKEN_NONE)
+    return _resume();
+
+  for(;;)
+  {
+    _cur = JSONBufferReader::SkipWhitespace(_cur, _end);
+    if(_cur >= _end)
+    {
+      if(!_finished)
+        return JSONEvent::NeedMore;
+      return (_state == STATE_ROOT) ? JSONEvent::End : _error();
+    }
+
+    switch(_state)
+    {
+    case STATE_KEY: // A } here closes an empty object or follows a trailing comma
+      if(*_cur == '}')
+      {
+        ++_cur;
+        return _close('{');
+      }
+      if(*_cur++ != '"')
+        return _error();
+      return _string(TOKEN_KEY);
+    case STATE_COLON:
+      if(*_cur++ != ':')
+        return _error();
+      _state = STATE_VALUE;
+      break;
+    case STATE_NEXT:
+      switch(*_cur++)
+      {
+      case ',': _state = (_stack.back() == '{') ? STATE_KEY : STATE_VALUE; break;
+      case '}': return _close('{');
+      case ']': return _close('[');
+      default: return _error();
+      }
+      break;
+    default: return _value(*_cur);
+    }
+  }
+}
+
+JSONEvent JSONReader::_value(char c)
+{
+  switch(c)
+  {
+  case '{':
+    ++_cur;
+    _stack += '{';
+    _state = STATE_KEY;
+    return JSONEvent::StartObject;
+  case '[':
+    ++_cur;
+    _stack += '[';
+    _state = STATE_VALUE;
+    return JSONEvent::StartArray;
+  case '"': ++_cur; return _string(TOKEN_STRING);
+  case ']': // Closes an empty array or follows a trailing comma
+    if(_state != STATE_VALUE || _stack.back() != '[')
+      return _error();
+    ++_cur;
+    return _close('[');
+  case ',':
+  case '}': // A missing value, which is left for STATE_NEXT to consume
+    if(_state != STATE_VALUE || (c == '}' && _stack.back() != '{'))
+      return _error();
+    _state = STATE_NEXT;
+    return JSONEvent::Null;
+  case ':': return _error();
+  }
+  return _scalar();
+}
+
+const char* JSONReader::_findQuote(const char* p, bool& escaped)
+{
+  if(_pending && p < _end)
+  {
+    _pending = false;
+    ++p;
+  }
+  for(;;)
+  {
+    p = JSONBufferReader::FindQuote(p, _end);
+    if(p >= _end || *p == '"')
+      return p;
+    escaped = true;
+    if(p + 1 >= _end) // The escaped character is in the next chunk
+    {
+      _pending = true;
+      return _end;
+    }
+    p += 2;
+  }
+}
+
+const char* JSONReader::_endScalar(const char* p) const
+{
+  while(p < _end && !isspace(static_cast<unsigned char>(*p)) && *p != ',' && *p != ']' && *p != '}' && *p != ':' &&
+        *p != '"' && *p != '[' && *p != '{')
+    ++p;
+  return p;
+}
+
+JSONEvent JSONReader::_string(TOKEN token)
+{
+  bool escaped  = false;
+  const char* p = _findQuote(_cur, escaped);
+  if(p < _end)
+  {
+    std::string_view raw(_cur, p - _cur);
+    _cur = p + 1;
+    return _emitString(token, raw, escaped);
+  }
+
+  _partial.assign(_cur, _end);
+  _escaped = escaped;
+  _token   = token;
+  _cur     = _end;
+  return _finished ? _error() : JSONEvent::NeedMore;
+}
+
+JSONEvent JSONReader::_scalar()
+{
+  const char* p = _endScalar(_cur);
+  if(p < _end || _finished)
+  {
+    std::string_view s(_cur, p - _cur);
+    _cur = p;
+    return _emitScalar(s);
+  }
+
+  _partial.assign(_cur, _end); // The number might keep going in the next chunk
+  _token = TOKEN_SCALAR;
+  _cur   = _end;
+  return JSONEvent::NeedMore;
+}
+
+JSONEvent JSONReader::_resume()
+{
+  TOKEN token = _token;
+  const char* p;
+  if(token == TOKEN_SCALAR)
+    p = _endScalar(_cur);
+  else
+    p = _findQuote(_cur, _escaped);
+  _partial.append(_cur, p);
+
+  if(p >= _end && (token != TOKEN_SCALAR || !_finished))
+  {
+    _cur = _end;
+    if(!_finished)
+      return JSONEvent::NeedMore;
+    return _error();
+  }
+
+  _token = TOKEN_NONE;
+  if(token == TOKEN_SCALAR)
+  {
+    _cur = p;
+    return _emitScalar(_partial);
+  }
+  _cur = p + 1;
+  return _emitString(token, _partial, _escaped);
+}
+
+JSONEvent JSONReader::_emitString(TOKEN token, std::string_view raw, bool escaped)
+{
+  if(escaped)
+  {
+    const char* cur = raw.data();
+    JSONBufferReader r(cur, raw.data() + raw.size());
+    _decoded.clear();
+    JSONEngine::ParseJSONString(_decoded, r);
+    raw = _decoded;
+  }
+  _str = raw;
+
+  if(token == TOKEN_KEY)
+  {
+    _state = STATE_COLON;
+    return JSONEvent::Key;
+  }
+  _next();
+  return JSONEvent::String;
+}
+
+JSONEvent JSONReader::_emitScalar(std::string_view s)
+{
+  _next();
+  if(s == "true" || s == "false")
+  {
+    _bool = s[0] == 't';
+    return JSONEvent::Bool;
+  }
+  if(s == "null")
+    return JSONEvent::Null;
+  if(s.empty() || !(s[0] == '-' || (s[0] >= '0' && s[0] <= '9')))
+    return _error();
+
+  const char* end = s.data() + s.size();
+  if(s.find_first_of(".eE") == std::string_view::npos)
+  {
+    auto [ptr, ec] = std::from_chars(s.data(), end, _int);
+    if(ec == std::errc() && ptr == end)
+    {
+      _double = static_cast<double>(_int);
+      return JSONEvent::Int;
+    }
+  }
+
+  auto [ptr, ec] = std::from_chars(s.data(), end, _double);
+  if(ec != std::errc() || ptr != end)
+    return _error();
+  return JSONEvent::Double;
+}
+
+JSONEvent JSONReader::_close(char open)
+{
+  if(_stack.empty() || _stack.back() != open)
+    return _error();
+  _stack.pop_back();
+  _next();
+  return (open == '{') ? JSONEvent::EndObject : JSONEvent::EndArray;
+}
+
+JSONEvent JSONReader::_error()
+{
+  _state = STATE_ERROR;
+  return JSONEvent::Error;
+}
+
+JSONWriter::JSONWriter(std::ostream* out, size_t flush) : _out(out), _flush(flush), _depth(0), _comma(false)
+{
+  _buf.reserve(flush + 64);
+}
+
+JSONWriter::~JSONWriter() { Flush(); }
+
+void JSONWriter::StartObject()
+{
+  _begin();
+  _buf += '{';
+  ++_depth;
+  _comma = false;
+}
+
+void JSONWriter::EndObject()
+{
+  _buf += '}';
+  --_depth;
+  _end();
+}
+
+void JSONWriter::StartArray()
+{
+  _begin();
+  _buf += '[';
+  ++_depth;
+  _comma = false;
+}
+
+void JSONWriter::EndArray()
+{
+  _buf += ']';
+  --_depth;
+  _end();
+}
+
+void JSONWriter::Key(std::string_view key)
+{
+  _begin();
+  _escape(key);
+  _buf += ':';
+  _comma = false;
+}
+
+void JSONWriter::String(std::string_view s)
+{
+  _begin();
+  _escape(s);
+  _end();
+}
+
+void JSONWriter::Int(int64_t i)
+{
+  _begin();
+  AppendNumber(_buf, i);
+  _end();
+}
+
+void JSONWriter::UInt(uint64_t i)
+{
+  _begin();
+  AppendNumber(_buf, i);
+  _end();
+}
+
+void JSONWriter::Double(double d)
+{
+  _begin();
+  if(std::isfinite(d))
+    AppendNumber(_buf, d);
+  else
+    _buf += "null";
+  _end();
+}
+
+void JSONWriter::Bool(bool b)
+{
+  _begin();
+  _buf += b ? "true" : "false";
+  _end();
+}
+
+void JSONWriter::Null()
+{
+  _begin();
+  _buf += "null";
+  _end();
+}
+
+void JSONWriter::Flush()
+{
+  if(_out && !_buf.empty())
+  {
+    _out->write(_buf.data(), _buf.size());
+    _buf.clear();
+  }
+}
+
+void JSONWriter::_escape(std::string_view s)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  _buf += '"';
+  const char* run = s.data();
+  const char* end = s.data() + s.size();
+  for(const char* p = run; p < end; ++p)
+  {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if(c >= 0x20 && c != '"' && c != '\\' && c != '/')
+      continue;
+    _buf.append(run, p); // Everything that doesn't need escaping is copied in one go
+    run = p + 1;
+    switch(c)
+    {
+    case '"': _buf += "\\\""; break;
+    case '\\': _buf += "\\\\"; break;
+    case '/': _buf += "\\/"; break;
+    case '\b': _buf += "\\b"; break;
+    case '\f': _buf += "\\f"; break;
+    case '\n': _buf += "\\n"; break;
+    case '\r': _buf += "\\r"; break;
+    case '\t': _buf += "\\t"; break;
+    default:
+    {
+      const char u[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+      _buf.append(u, 6);
+    }
+    }
+  }
+  _buf.append(run, end);
+  _buf += '"';
+}
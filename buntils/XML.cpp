@@ -166,7 +166,7 @@ bool XMLNode::RemoveNode(size_t index)
   _nodes.Remove(index);
   return true;
 }
-bool XMLNode::RemoveNode(const char* name) { return RemoveNode(_nodehash[name]); }
+bool XMLNode::RemoveNode(const char* name) { return RemoveNode(_nodehash.Get(_view(name))); }
 bool XMLNode::RemoveAttribute(size_t index)
 {
   if(index >= _nodes.size())
@@ -175,18 +175,20 @@ bool XMLNode::RemoveAttribute(size_t index)
   _nodes.Remove(index);
   return true;
 }
-bool XMLNode::RemoveAttribute(const char* name) { return RemoveAttribute(_attrhash[name]); }
+bool XMLNode::RemoveAttribute(const char* name) { return RemoveAttribute(_attrhash.Get(_view(name))); }
 void XMLNode::SetValue(double value)
 {
   _value.Float   = value;
   _value.Integer = (int64_t)value;
-  _value.String  = std::to_string(value);
+  _value.String.clear();
+  AppendNumber(_value.String, value);
 }
 void XMLNode::SetValue(int64_t value)
 {
   _value.Integer = value;
   _value.Float   = (double)value;
-  _value.String  = std::to_string(value);
+  _value.String.clear();
+  AppendNumber(_value.String, value);
 }
 void XMLNode::SetValue(const char* value)
 {
@@ -16,6 +16,7 @@
   #include <unistd.h> // for sysconf
   #include <cpuid.h>
   #include <stdio.h>
+  #include <sys/mman.h>
   #include <sys/resource.h>
 #endif
 
@@ -74,6 +75,22 @@ struct bunCPUInfo bunGetCPUInfo()
     assert(r.sse == SSE_SSE4_2);
     r.sse = SSE_AVX;
   }
+  if(r.sse == SSE_AVX && (info[2] & T_GETBIT(unsigned int, 27)))
+  { // AVX2 is in leaf 7, and can only be used if the OS saves the AVX registers (OSXSAVE, then XCR0 bits 1 and 2)
+    unsigned int ext[4]     = { 0 };
+    unsigned long long xcr0 = 0;
+#ifdef BUN_COMPILER_MSC
+    __cpuidex((int*)ext, 7, 0);
+    xcr0 = _xgetbv(0);
+#elif defined(BUN_COMPILER_GCC)
+    unsigned int lo, hi;
+    __get_cpuid_count(7, 0, ext + 0, ext + 1, ext + 2, ext + 3);
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = ((unsigned long long)hi << 32) | lo;
+#endif
+    if((ext[1] & T_GETBIT(unsigned int, 5)) && (xcr0 & 6) == 6)
+      r.sse = SSE_AVX2;
+  }
   r.flags |= (((info[3] & T_GETBIT(unsigned int, 8)) != 0) << 0);  // cmpxchg8b support
   r.flags |= (((info[2] & T_GETBIT(unsigned int, 13)) != 0) << 1); // cmpxchg16b support
   r.flags |= (((info[2] & T_GETBIT(unsigned int, 6)) != 0) << 2);  // SSE4a support
@@ -132,6 +149,56 @@ extern size_t GetPeakWorkingSet()
 #endif
 }
 
+extern void* bun_HugeAlloc(size_t size)
+{
+  if(size < BUN_HUGE_PAGE_SIZE)
+    return malloc(size);
+#ifdef BUN_PLATFORM_WIN32
+  // Large pages require the SeLockMemoryPrivilege, so this usually falls back to normal pages
+  SIZE_T large = GetLargePageMinimum();
+  if(large > 0)
+  {
+    void* p =
+      VirtualAlloc(0, (size + large - 1) & ~(large - 1), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if(p)
+      return p;
+  }
+  return VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  size_t rounded = (size + BUN_HUGE_PAGE_SIZE - 1) & ~(size_t)(BUN_HUGE_PAGE_SIZE - 1);
+  void* p;
+  #ifdef MAP_HUGETLB
+  // Only succeeds if huge pages were reserved ahead of time in /proc/sys/vm/nr_hugepages
+  p = mmap(0, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if(p != MAP_FAILED)
+    return p;
+  #endif
+  p = mmap(0, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(p == MAP_FAILED)
+    return 0;
+  #ifdef MADV_HUGEPAGE
+  madvise(p, rounded, MADV_HUGEPAGE); // Otherwise, ask for transparent huge pages
+  #endif
+  return p;
+#endif
+}
+
+extern void bun_HugeFree(void* p, size_t size)
+{
+  if(!p)
+    return;
+  if(size < BUN_HUGE_PAGE_SIZE)
+    free(p);
+  else
+  {
+#ifdef BUN_PLATFORM_WIN32
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, (size + BUN_HUGE_PAGE_SIZE - 1) & ~(size_t)(BUN_HUGE_PAGE_SIZE - 1));
+#endif
+  }
+}
+
 size_t UTF8toUTF16(const char* BUN_RESTRICT input, ptrdiff_t srclen, wchar_t* BUN_RESTRICT output, size_t buflen)
 {
 #ifdef BUN_PLATFORM_WIN32
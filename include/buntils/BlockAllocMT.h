@@ -6,6 +6,7 @@
 
 #include "BlockAlloc.h"
 #include "lockless.h"
+#include <atomic>
 
 namespace bun {
   /* Multi-producer multi-consumer lockless fixed size allocator */
@@ -224,7 +225,232 @@ namespace bun {
 
     LocklessBlockPolicy& operator=(LocklessBlockPolicy&&) = default;
   };
-  
+
+  namespace internal {
+    // Gives each thread a small sequential ID, used to pick a magazine cache
+    inline size_t MagazineThreadID()
+    {
+      static std::atomic<size_t> count = 0;
+      thread_local size_t id           = count.fetch_add(1, std::memory_order_relaxed);
+      return id;
+    }
+  }
+
+  /* Multi-producer multi-consumer fixed size allocator that keeps per-thread magazines of free blocks in front of a
+   * LocklessBlockAllocator, following Bonwick's magazine design. Each thread allocates from and frees to its own loaded
+   * magazine, keeping a second one around so it can bounce between allocating and freeing without going anywhere else.
+   * Only when both are full or both are empty does it trade a whole magazine with the shared depot, and only if the depot
+   * has nothing to give does it fall back to the lockless freelist. Threads map onto a fixed set of caches, each with its
+   * own lock, so a cache is only ever contended if there are more than CACHES threads. */
+  class MagazineBlockAllocator
+  {
+    struct Magazine
+    {
+      Magazine* next;
+      size_t count;
+
+      BUN_FORCEINLINE void** rounds() { return reinterpret_cast<void**>(this + 1); }
+    };
+
+    struct alignas(64) Cache
+    {
+      std::atomic_flag lock;
+      Magazine* loaded;
+      Magazine* previous;
+    };
+
+    MagazineBlockAllocator(const MagazineBlockAllocator&)            = delete;
+    MagazineBlockAllocator& operator=(const MagazineBlockAllocator&) = delete;
+
+  public:
+    // Counts how often threads had to go past their own cache
+    struct Stats
+    {
+      uint64_t loads;     // Full magazines taken from the depot
+      uint64_t unloads;   // Full magazines given to the depot
+      uint64_t misses;    // Allocations that fell through to the shared freelist
+      uint64_t magazines; // Magazines allocated so far
+    };
+
+    static constexpr size_t CACHES         = 32;
+    static constexpr size_t DEFAULT_ROUNDS = 32;
+
+    inline MagazineBlockAllocator(size_t blocksize, size_t init = 8, size_t rounds = DEFAULT_ROUNDS) :
+      _backing(blocksize, init), _rounds(rounds), _full(nullptr), _empty(nullptr), _stats{ 0, 0, 0, 0 }, _misses(0)
+    {
+      assert(rounds > 0);
+      for(auto& cache : _caches)
+      {
+        cache.lock.clear(std::memory_order_relaxed);
+        cache.loaded = cache.previous = nullptr;
+      }
+      _depotlock.clear(std::memory_order_relaxed);
+    }
+    inline ~MagazineBlockAllocator() { _freeMagazines(); }
+
+    inline void* alloc(size_t blocks, void* p = nullptr, [[maybe_unused]] size_t old = 0) noexcept
+    {
+      assert(blocks == 1 && !p);
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      return _backing.alloc(blocks);
+#endif
+      Cache& cache = _lockCache();
+      if(!cache.loaded->count)
+      {
+        if(cache.previous->count)
+          std::swap(cache.loaded, cache.previous);
+        else
+        { // Both magazines are empty, so trade the previous one for a full magazine from the depot
+          _lock(_depotlock);
+          if(Magazine* full = _full)
+          {
+            _full                = full->next;
+            cache.previous->next = _empty;
+            _empty               = cache.previous;
+            cache.previous       = cache.loaded;
+            cache.loaded         = full;
+            ++_stats.loads;
+          }
+          _depotlock.clear(std::memory_order_release);
+        }
+
+        if(!cache.loaded->count)
+        {
+          cache.lock.clear(std::memory_order_release);
+          _misses.fetch_add(1, std::memory_order_relaxed);
+          return _backing.alloc(1);
+        }
+      }
+
+      void* r = cache.loaded->rounds()[--cache.loaded->count];
+      cache.lock.clear(std::memory_order_release);
+      return r;
+    }
+    inline void dealloc(void* p, [[maybe_unused]] size_t num = 0) noexcept
+    {
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      _backing.dealloc(p);
+      return;
+#endif
+      Cache& cache = _lockCache();
+      if(cache.loaded->count == _rounds)
+      {
+        if(!cache.previous->count)
+          std::swap(cache.loaded, cache.previous);
+        else
+        { // Both magazines are full, so give the previous one to the depot in exchange for an empty one
+          _lock(_depotlock);
+          cache.previous->next = _full;
+          _full                = cache.previous;
+          cache.previous       = cache.loaded;
+          cache.loaded         = _popEmpty();
+          ++_stats.unloads;
+          _depotlock.clear(std::memory_order_release);
+        }
+      }
+
+      cache.loaded->rounds()[cache.loaded->count++] = p;
+      cache.lock.clear(std::memory_order_release);
+    }
+
+    // Only safe to call when no other thread is using the allocator
+    inline void Clear() noexcept
+    {
+      _freeMagazines();
+      for(auto& cache : _caches)
+        cache.loaded = cache.previous = nullptr;
+      _full = _empty = nullptr;
+      _backing.Clear();
+    }
+    inline Stats GetStats()
+    {
+      _lock(_depotlock);
+      Stats stats = _stats;
+      _depotlock.clear(std::memory_order_release);
+      stats.misses = _misses.load(std::memory_order_relaxed);
+      return stats;
+    }
+    size_t GetBlockSize() const noexcept { return _backing.GetBlockSize(); }
+
+  protected:
+    BUN_FORCEINLINE static void _lock(std::atomic_flag& flag)
+    {
+      while(flag.test_and_set(std::memory_order_acquire))
+        CPU_Pause();
+    }
+    inline Cache& _lockCache()
+    {
+      Cache& cache = _caches[internal::MagazineThreadID() % CACHES];
+      _lock(cache.lock);
+      if(!cache.loaded)
+      {
+        _lock(_depotlock);
+        cache.loaded   = _popEmpty();
+        cache.previous = _popEmpty();
+        _depotlock.clear(std::memory_order_release);
+      }
+      return cache;
+    }
+    // Must be called while holding the depot lock
+    inline Magazine* _popEmpty()
+    {
+      Magazine* m = _empty;
+      if(m)
+        _empty = m->next;
+      else
+      {
+        m = reinterpret_cast<Magazine*>(malloc(sizeof(Magazine) + (sizeof(void*) * _rounds)));
+        assert(m != 0);
+        ++_stats.magazines;
+      }
+      m->next  = nullptr;
+      m->count = 0;
+      return m;
+    }
+    inline void _freeMagazines()
+    {
+      for(auto& cache : _caches)
+      {
+        free(cache.loaded);
+        free(cache.previous);
+      }
+      for(Magazine* list : { _full, _empty })
+      {
+        while(Magazine* m = list)
+        {
+          list = m->next;
+          free(m);
+        }
+      }
+    }
+
+    Cache _caches[CACHES];
+    LocklessBlockAllocator _backing; // The blocks in the magazines belong to this allocator and are freed along with it
+    size_t _rounds;
+    alignas(64) std::atomic_flag _depotlock;
+    Magazine* _full;
+    Magazine* _empty;
+    Stats _stats;
+    std::atomic<uint64_t> _misses;
+  };
+
+  template<class T>
+    requires((sizeof(T) >= sizeof(void*)) && (sizeof(bun_PTag<void>) == (sizeof(void*) * 2)))
+  class MagazineBlockPolicy : public MagazineBlockAllocator
+  {
+  public:
+    inline explicit MagazineBlockPolicy(size_t init = 8, size_t rounds = DEFAULT_ROUNDS) :
+      MagazineBlockAllocator(sizeof(T), init, rounds)
+    {}
+    inline ~MagazineBlockPolicy() {}
+
+    inline T* allocate(size_t num, T* p = nullptr, size_t old = 0) noexcept
+    {
+      return reinterpret_cast<T*>(MagazineBlockAllocator::alloc(num, p, old));
+    }
+    inline void deallocate(T* p, size_t num = 0) noexcept { MagazineBlockAllocator::dealloc(p, num); }
+  };
+
   template<size_t MAXSIZE = sizeof(void*) * 32, class = std::make_index_sequence<bun_Log2(MAXSIZE / sizeof(void*)) + 1>>
   class BUN_COMPILER_DLLEXPORT LocklessBlockCollection;
 
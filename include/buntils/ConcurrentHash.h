@@ -0,0 +1,304 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#ifndef __CONCURRENT_HASH_H__BUN__
+#define __CONCURRENT_HASH_H__BUN__
+
+#include "DynArray.h"
+#include "Hash.h"
+#include "RWLock.h"
+#include <atomic>
+
+namespace bun {
+  // Thread-safe hash map that stripes the key space across SHARDS independently resizable Hash tables, each guarded by its
+  // own cache-line aligned RWLock, so writers only contend with other writers that land on the same shard. If both the
+  // key and value are trivially copyable, lookups are optimistic: a reader samples the shard's version, searches the table
+  // without locking anything, then checks the version again and retries if a writer got in the way, so readers never
+  // write to shared memory. To make this safe, a shard never frees a table a reader might still be searching: growing
+  // builds a new table and retires the old one, which is only destroyed by Reclaim(), Clear() or the destructor. Retired
+  // tables never add up to more than the current ones, since every retired table is at most half the size of the next.
+  // Other types fall back to taking the read lock. Values are always returned by copy, since a reference into the table
+  // could be invalidated by another thread at any time.
+  template<class Key, class Data, khint_t (*HashFunc)(const Key&) = &KH_AUTO_HASH<Key, false>,
+           bool (*HashEqual)(const Key&, const Key&) = &KH_AUTO_EQUAL<Key, false>,
+           typename Alloc = StandardAllocator<std::byte>, size_t SHARDS = 64>
+  class ConcurrentHash
+  {
+    static_assert(!std::is_void_v<Data>, "ConcurrentHash must map keys to values");
+    static_assert(SHARDS > 0 && !(SHARDS & (SHARDS - 1)), "SHARDS must be a power of two");
+    ConcurrentHash(const ConcurrentHash&)            = delete;
+    ConcurrentHash& operator=(const ConcurrentHash&) = delete;
+
+    using HASH = Hash<Key, Data, HashFunc, HashEqual, Alloc>;
+
+    struct Table : HASH
+    {
+      explicit Table(khint_t nbuckets) : HASH(nbuckets), retired(nullptr) {}
+      // True if the next insertion would make the underlying Hash resize itself
+      BUN_FORCEINLINE bool Full() const { return this->n_occupied >= this->upper_bound; }
+
+      Table* retired;
+    };
+
+    struct alignas(64) Shard
+    {
+      RWLock lock;
+      std::atomic<size_t> version; // Odd while a writer is modifying the shard
+      std::atomic<Table*> table;
+    };
+
+  public:
+    static constexpr bool Optimistic = std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Data>;
+    static constexpr int RETRIES     = 16; // Failed optimistic reads before a reader gives up and takes the read lock
+
+    inline explicit ConcurrentHash(size_t capacity = 0)
+    {
+      for(auto& s : _shards)
+      {
+        s.version.store(0, std::memory_order_relaxed);
+        s.table.store(new Table((khint_t)(capacity / SHARDS)), std::memory_order_relaxed);
+      }
+    }
+    inline ~ConcurrentHash()
+    {
+      for(auto& s : _shards)
+        _destroy(s.table.load(std::memory_order_relaxed));
+    }
+
+    // Copies the value for key into out and returns true, or returns false if the key isn't in the map.
+    inline bool Get(const Key& key, Data& out) const
+    {
+      return _read(_shard(key), [&](const Table& t) {
+        khiter_t i = t.Iterator(key);
+        if(!t.ExistsIter(i))
+          return false;
+        out = t.Value(i);
+        return true;
+      });
+    }
+    inline bool Exists(const Key& key) const
+    {
+      return _read(_shard(key), [&](const Table& t) { return t.ExistsIter(t.Iterator(key)); });
+    }
+
+    // Inserts key or overwrites its current value. Returns true if the key wasn't already in the map.
+    template<typename D> inline bool Insert(const Key& key, D&& value)
+    {
+      return _write(_shard(key), [&](Table& t) {
+        khiter_t i = t.Iterator(key);
+        if(t.ExistsIter(i))
+        {
+          t.Value(i) = std::forward<D>(value);
+          return false;
+        }
+        t.Insert(key, std::forward<D>(value));
+        return true;
+      });
+    }
+
+    // Returns the value for key, inserting value first if the key isn't in the map yet. If several threads race to insert
+    // the same key, only the first one wins and all of them get its value back.
+    template<typename D>
+      requires std::is_constructible_v<Data, D&&>
+    inline Data GetOrInsert(const Key& key, D&& value)
+    {
+      return GetOrInsert(key, [&]() -> Data { return Data(std::forward<D>(value)); });
+    }
+
+    // Same as above, but only calls make() to construct the value if the key is missing.
+    template<typename F>
+      requires std::is_invocable_r_v<Data, F&>
+    inline Data GetOrInsert(const Key& key, F&& make)
+    {
+      Shard& s = _shard(key);
+      Data out;
+      if(_read(s, [&](const Table& t) {
+           khiter_t i = t.Iterator(key);
+           if(!t.ExistsIter(i))
+             return false;
+           out = t.Value(i);
+           return true;
+         }))
+        return out;
+
+      _write(s, [&](Table& t) {
+        khiter_t i = t.Iterator(key);
+        if(!t.ExistsIter(i))
+          i = t.Insert(key, make());
+        out = t.Value(i);
+        return true;
+      });
+      return out;
+    }
+
+    // Calls fn(Data&) on the value for key while holding its shard's write lock, so read-modify-write operations are
+    // atomic. Returns false without calling fn if the key isn't in the map.
+    template<typename F> inline bool Update(const Key& key, F&& fn)
+    {
+      return _write(_shard(key), [&](Table& t) {
+        khiter_t i = t.Iterator(key);
+        if(!t.ExistsIter(i))
+          return false;
+        fn(t.Value(i));
+        return true;
+      });
+    }
+
+    inline bool Remove(const Key& key)
+    {
+      return _write(_shard(key), [&](Table& t) { return t.Remove(key); });
+    }
+
+    // Calls fn(const Key&, const Data&) on every item. Each shard is copied while holding its read lock and fn is called on
+    // the copy afterwards, so fn can safely modify the map, and every shard is seen in a consistent state, but changes to
+    // one shard can still happen while another is being copied.
+    template<typename F> inline void ForEach(F&& fn) const
+    {
+      DynArray<std::pair<Key, Data>, size_t> snapshot;
+      for(auto& s : _shards)
+      {
+        snapshot.Clear();
+        s.lock.RLock();
+        const Table& t = *s.table.load(std::memory_order_relaxed);
+        for(khiter_t i = t.Front(); i != t.Back(); ++i)
+          if(t.ExistsIter(i))
+            snapshot.Add(std::pair<Key, Data>(t.GetKey(i), t.Value(i)));
+        s.lock.RUnlock();
+
+        for(auto& [k, v] : snapshot)
+          fn(k, v);
+      }
+    }
+
+    // Counts the items in every shard. This is only a snapshot if no other threads are modifying the map.
+    inline size_t size() const
+    {
+      size_t n = 0;
+      for(auto& s : _shards)
+      {
+        s.lock.RLock();
+        n += s.table.load(std::memory_order_relaxed)->size();
+        s.lock.RUnlock();
+      }
+      return n;
+    }
+
+    // Removes everything and frees all retired tables. Like Reclaim(), no other thread can be using the map.
+    inline void Clear()
+    {
+      for(auto& s : _shards)
+      {
+        Table* t = s.table.load(std::memory_order_relaxed);
+        _destroy(t->retired);
+        t->retired = nullptr;
+        t->Clear();
+      }
+    }
+
+    // Frees every table retired by a shard growing. This is not thread-safe, because optimistic readers don't announce
+    // themselves, so it must only be called while no other thread is using the map.
+    inline void Reclaim()
+    {
+      for(auto& s : _shards)
+      {
+        Table* t = s.table.load(std::memory_order_relaxed);
+        _destroy(t->retired);
+        t->retired = nullptr;
+      }
+    }
+
+  protected:
+    BUN_FORCEINLINE Shard& _shard(const Key& key) const
+    {
+      if constexpr(SHARDS == 1)
+        return _shards[0];
+      else // The buckets use the low bits of the hash, so the shard is picked from the high bits of a fibonacci hash
+        return _shards[(uint32_t(HashFunc(key)) * 0x9E3779B9u) >> (32 - std::countr_zero(SHARDS))];
+    }
+
+    template<typename F> inline bool _read(Shard& s, F&& f) const
+    {
+      if constexpr(Optimistic)
+      {
+        for(int tries = 0; tries < RETRIES; ++tries)
+        {
+          size_t version = s.version.load(std::memory_order_acquire);
+          if(version & 1)
+          {
+            CPU_Pause();
+            continue;
+          }
+
+          bool r = f(std::as_const(*s.table.load(std::memory_order_acquire)));
+          std::atomic_thread_fence(std::memory_order_acquire);
+          if(s.version.load(std::memory_order_relaxed) == version)
+            return r;
+        }
+      }
+
+      s.lock.RLock();
+      bool r = f(std::as_const(*s.table.load(std::memory_order_relaxed)));
+      s.lock.RUnlock();
+      return r;
+    }
+
+    template<typename F> inline bool _write(Shard& s, F&& f)
+    {
+      s.lock.Lock();
+      size_t version = s.version.load(std::memory_order_relaxed);
+      s.version.store(version + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      Table* t = s.table.load(std::memory_order_relaxed);
+      if constexpr(Optimistic)
+      {
+        if(t->Full())
+          t = _grow(s, t);
+      }
+      bool r = f(*t);
+
+      s.version.store(version + 2, std::memory_order_release);
+      s.lock.Unlock();
+      return r;
+    }
+
+    // Makes room for at least one more insertion without freeing anything a reader could be looking at. If most of the
+    // occupied buckets are deleted, the table is rebuilt in place, which keeps its arrays. Otherwise, the items are copied
+    // into a new table twice as large and the old one is retired.
+    inline Table* _grow(Shard& s, Table* t)
+    {
+      DynArray<std::pair<Key, Data>, size_t> items(t->size());
+      for(khiter_t i = t->Front(); i != t->Back(); ++i)
+        if(t->ExistsIter(i))
+          items.Add(std::pair<Key, Data>(t->GetKey(i), t->Value(i)));
+
+      if(t->Capacity() > (t->size() << 1))
+        t->Clear();
+      else
+      {
+        Table* n   = new Table(t->Capacity() ? t->Capacity() << 1 : 32);
+        n->retired = t;
+        s.table.store(n, std::memory_order_release);
+        t = n;
+      }
+
+      for(auto& [k, v] : items)
+        t->Insert(k, v);
+      return t;
+    }
+
+    static inline void _destroy(Table* t)
+    {
+      while(t)
+      {
+        Table* next = t->retired;
+        delete t;
+        t = next;
+      }
+    }
+
+    mutable Shard _shards[SHARDS];
+  };
+}
+
+#endif
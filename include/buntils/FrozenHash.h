@@ -0,0 +1,559 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#ifndef __FROZEN_HASH_H__BUN__
+#define __FROZEN_HASH_H__BUN__
+
+#include "Hash.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+
+namespace bun {
+  namespace internal {
+    // Refers to a string stored in a FrozenHash's string pool. The offset is in bytes from the start of the pool.
+    struct FrozenStr
+    {
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    template<class T> using FrozenChar = typename HashChar<T>::type;
+    template<class T> using FrozenRep  = std::conditional_t<std::is_void_v<FrozenChar<T>>, T, FrozenStr>;
+
+    template<class K, class D> struct FrozenEntry
+    {
+      FrozenRep<K> key;
+      FrozenRep<D> value;
+    };
+    template<class K> struct FrozenEntry<K, void>
+    {
+      FrozenRep<K> key;
+    };
+
+    struct FrozenHeader
+    {
+      uint32_t magic;
+      uint32_t format;
+      uint32_t count;
+      uint32_t buckets;
+      uint64_t seed;
+      uint64_t size; // Size of the entire blob in bytes, including this header
+    };
+
+    // Seeded 64-bit hash used to build the perfect hash function. Unlike HashFunc, this has to be reseeded if two keys
+    // collide, and it must never change, because saved tables depend on it.
+    template<class K, bool INS> inline uint64_t FrozenHashKey(const K& k, uint64_t seed)
+    {
+      if constexpr(!std::is_void_v<FrozenChar<K>>)
+        return HashView64<FrozenChar<K>, INS>(HashKeyView<FrozenChar<K>>(k), seed);
+      else if constexpr(std::has_unique_object_representations_v<K>)
+        return HashBytes<false>(reinterpret_cast<const char*>(&k), sizeof(K), seed);
+      else // Keys like floats can't be hashed by their bytes, so this falls back to the 32-bit KH_AUTO_HASH
+        return HashMix(KH_AUTO_HASH<K, INS>(k) ^ seed, 0x9E3779B97F4A7C15ULL);
+    }
+  }
+
+  // Immutable hash table for lookup tables that are built once and then only read. Keys are placed with a minimal
+  // perfect hash function (compress, hash and displace), so every lookup hashes the key, reads one displacement, and
+  // compares exactly one key. The whole table is a single flat blob: a header, one 32-bit displacement per bucket of
+  // roughly three keys, the key/value entries, and a pool holding any strings. String keys and values (Str,
+  // std::string, std::string_view, char pointers or a HashedKey of one) are copied into the pool, everything else must
+  // be trivially copyable. The blob can be written with Save() and used in place with Load(), for example on a memory
+  // mapped file, as long as it's 8-byte aligned and was made by the same FrozenHash type on a machine with the same
+  // endianness. Load() only validates the header, so the blob must come from a trusted source.
+  template<class Key, class Data = void, bool INS = false> class BUN_COMPILER_DLLEXPORT FrozenHash
+  {
+    using Entry  = internal::FrozenEntry<Key, Data>;
+    using Header = internal::FrozenHeader;
+
+    template<class T> struct _DataChar
+    {
+      using type = internal::FrozenChar<T>;
+    };
+    template<class T>
+      requires std::is_void_v<T>
+    struct _DataChar<T>
+    {
+      using type = void;
+    };
+
+  public:
+    static constexpr bool IsMap        = !std::is_void_v<Data>;
+    static constexpr bool IsStringKey  = !std::is_void_v<internal::FrozenChar<Key>>;
+    static constexpr bool IsStringData = !std::is_void_v<typename _DataChar<Data>::type>;
+    using KEY                          = Key;
+    using DATA                         = Data;
+    using CHAR                         = std::conditional_t<IsStringKey, internal::FrozenChar<Key>, char>;
+    using VIEW                         = std::basic_string_view<CHAR>;
+    using DATAVIEW = std::basic_string_view<std::conditional_t<IsStringData, typename _DataChar<Data>::type, char>>;
+    // String keys and values are returned as views into the string pool, which are always null-terminated
+    using GETKEY = std::conditional_t<IsStringKey, VIEW, const Key&>;
+    using GET    = std::conditional_t<IsStringData, DATAVIEW, const std::conditional_t<IsMap, Data, std::byte>*>;
+
+    static constexpr uint32_t MAGIC  = 'B' | ('U' << 8) | ('N' << 16) | ('F' << 24);
+    // Identifies the layout of the blob, so Load() can reject blobs made by a different FrozenHash type
+    static constexpr uint32_t FORMAT =
+      1 | ((uint32_t(sizeof(Entry)) & 0xFF) << 8) | ((uint32_t(sizeof(internal::FrozenRep<Key>)) & 0x3F) << 16) |
+      (uint32_t(IsStringKey) << 22) | (uint32_t(IsStringData) << 23) | (uint32_t(INS) << 24) |
+      (uint32_t(sizeof(CHAR)) << 25) | (uint32_t(sizeof(typename DATAVIEW::value_type)) << 28);
+    static constexpr uint32_t KEYS_PER_BUCKET = 3;
+    static constexpr uint32_t MAX_DISPLACE    = 1 << 20; // Displacements tried for one bucket before picking a new seed
+    static constexpr uint32_t MAX_SEEDS       = 16;
+
+    static_assert(IsStringKey || std::is_trivially_copyable_v<Key>,
+                  "FrozenHash keys must be strings or trivially copyable");
+    static_assert(!IsMap || IsStringData || std::is_trivially_copyable_v<Data>,
+                  "FrozenHash values must be strings or trivially copyable");
+    static_assert(alignof(Entry) <= alignof(uint64_t), "FrozenHash entries can't be aligned to more than 8 bytes");
+
+    inline FrozenHash() { _attach(nullptr); }
+    inline FrozenHash(const FrozenHash& copy) { *this = copy; }
+    inline FrozenHash(FrozenHash&& mov) { *this = std::move(mov); }
+    // Builds the table from every item in a Hash. If the build fails, the table is empty.
+    template<class H>
+      requires std::is_same_v<typename H::KEY, Key> && std::is_same_v<typename H::DATA, Data>
+    inline explicit FrozenHash(const H& hash)
+    {
+      _attach(nullptr);
+      Build(hash);
+    }
+    // Builds the table from a range of std::pair<Key, Data>, or a range of keys if Data is void.
+    template<std::forward_iterator It> inline FrozenHash(It begin, It end)
+    {
+      _attach(nullptr);
+      Build(begin, end);
+    }
+    // Uses an existing blob in place without copying it. If the blob is invalid, the table is empty.
+    inline explicit FrozenHash(std::span<const std::byte> blob)
+    {
+      _attach(nullptr);
+      Load(blob);
+    }
+
+    template<class H>
+      requires std::is_same_v<typename H::KEY, Key> && std::is_same_v<typename H::DATA, Data>
+    bool Build(const H& hash)
+    {
+      std::unique_ptr<khiter_t[]> items(new khiter_t[hash.size()]);
+      uint32_t n = 0;
+      for(khiter_t i = hash.Front(); i != hash.Back(); ++i)
+        if(hash.ExistsIter(i))
+          items[n++] = i;
+
+      if constexpr(IsMap)
+        return _build(
+          n, [&](uint32_t i) -> const Key& { return hash.GetKey(items[i]); },
+          [&](uint32_t i) -> const Data& { return hash.Value(items[i]); });
+      else
+        return _build(n, [&](uint32_t i) -> const Key& { return hash.GetKey(items[i]); }, nullptr);
+    }
+
+    // Builds the table from a range. Returns false and leaves the table empty if the range has duplicate keys, or if no
+    // perfect hash function could be found, which only happens if the keys can't be hashed by their contents.
+    template<std::forward_iterator It> bool Build(It begin, It end)
+    {
+      std::unique_ptr<It[]> items(new It[std::distance(begin, end)]);
+      uint32_t n = 0;
+      for(; begin != end; ++begin)
+        items[n++] = begin;
+
+      if constexpr(IsMap)
+        return _build(
+          n, [&](uint32_t i) -> const Key& { return items[i]->first; },
+          [&](uint32_t i) -> const Data& { return items[i]->second; });
+      else
+        return _build(n, [&](uint32_t i) -> const Key& { return *items[i]; }, nullptr);
+    }
+
+    // Points the table at a blob made by Save() without copying it, so the blob must outlive the table.
+    bool Load(std::span<const std::byte> blob)
+    {
+      Clear();
+      if(blob.size() < sizeof(Header) || (reinterpret_cast<uintptr_t>(blob.data()) & (alignof(uint64_t) - 1)) != 0)
+        return false;
+
+      const Header* h = reinterpret_cast<const Header*>(blob.data());
+      if(!_validate(*h) || h->size > blob.size())
+        return false;
+      _attach(blob.data());
+      return true;
+    }
+    // Reads a blob made by Save() into memory owned by the table
+    bool Load(std::istream& s)
+    {
+      Clear();
+      Header h;
+      if(!s.read(reinterpret_cast<char*>(&h), sizeof(Header)) || !_validate(h))
+        return false;
+
+      std::unique_ptr<uint64_t[]> buf(new uint64_t[h.size / sizeof(uint64_t)]);
+      memcpy(buf.get(), &h, sizeof(Header));
+      if(!s.read(reinterpret_cast<char*>(buf.get()) + sizeof(Header), h.size - sizeof(Header)))
+        return false;
+      _owned = std::move(buf);
+      _attach(reinterpret_cast<const std::byte*>(_owned.get()));
+      return true;
+    }
+    inline void Save(std::ostream& s) const
+    {
+      auto blob = Blob();
+      s.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+    }
+    // The entire table as a flat blob that can be saved and later passed to Load()
+    inline std::span<const std::byte> Blob() const
+    {
+      if(!_data)
+        return std::span<const std::byte>();
+      return std::span<const std::byte>(_data, reinterpret_cast<const Header*>(_data)->size);
+    }
+    inline void Clear()
+    {
+      _owned.reset();
+      _attach(nullptr);
+    }
+
+    // Returns size() if the key isn't in the table
+    inline size_t Iterator(const Key& key) const
+    {
+      if constexpr(IsStringKey)
+        return _find(internal::HashKeyView<CHAR>(key));
+      else
+      {
+        if(!_count)
+          return 0;
+        uint32_t i = _slot(internal::FrozenHashKey<Key, INS>(key, _seed));
+        return KH_AUTO_EQUAL<Key, INS>(reinterpret_cast<const Key&>(_entries[i].key), key) ? i : _count;
+      }
+    }
+    // Finds a string key from borrowed characters
+    template<class V>
+      requires(IsStringKey && std::is_same_v<V, VIEW>)
+    inline size_t Iterator(const V& key) const
+    {
+      return _find(key);
+    }
+    inline size_t Iterator(const CHAR* s, size_t len) const
+      requires IsStringKey
+    {
+      return _find(VIEW(s, len));
+    }
+
+    inline bool Exists(const Key& key) const { return Iterator(key) != _count; }
+    template<class V>
+      requires(IsStringKey && std::is_same_v<V, VIEW>)
+    inline bool Exists(const V& key) const
+    {
+      return _find(key) != _count;
+    }
+    inline bool Exists(const CHAR* s, size_t len) const
+      requires IsStringKey
+    {
+      return _find(VIEW(s, len)) != _count;
+    }
+
+    // Returns a pointer to the value, or a view if the values are strings. Returns null or an empty view with a null data
+    // pointer if the key isn't in the table.
+    inline GET Get(const Key& key) const
+      requires IsMap
+    {
+      return GetValue(Iterator(key));
+    }
+    template<class V>
+      requires(IsMap && IsStringKey && std::is_same_v<V, VIEW>)
+    inline GET Get(const V& key) const
+    {
+      return GetValue(_find(key));
+    }
+    inline GET Get(const CHAR* s, size_t len) const
+      requires(IsMap && IsStringKey)
+    {
+      return GetValue(_find(VIEW(s, len)));
+    }
+    inline GET GetValue(size_t i) const
+      requires IsMap
+    {
+      if(i >= _count)
+        return GET();
+      if constexpr(IsStringData)
+        return _str<typename DATAVIEW::value_type>(_entries[i].value);
+      else
+        return reinterpret_cast<const Data*>(&_entries[i].value);
+    }
+    inline GETKEY GetKey(size_t i) const
+    {
+      assert(i < _count);
+      if constexpr(IsStringKey)
+        return _str<CHAR>(_entries[i].key);
+      else
+        return reinterpret_cast<const Key&>(_entries[i].key);
+    }
+
+    BUN_FORCEINLINE size_t size() const { return _count; }
+    BUN_FORCEINLINE bool IsOwner() const { return _owned != nullptr; }
+
+    FrozenHash& operator=(const FrozenHash& copy)
+    {
+      if(this == &copy)
+        return *this;
+      _owned.reset();
+      if(!copy._owned)
+        _attach(copy._data); // Borrowed blobs are shared, since whoever owns them has to keep them alive anyway
+      else
+      {
+        size_t words = reinterpret_cast<const Header*>(copy._data)->size / sizeof(uint64_t);
+        _owned.reset(new uint64_t[words]);
+        memcpy(_owned.get(), copy._owned.get(), words * sizeof(uint64_t));
+        _attach(reinterpret_cast<const std::byte*>(_owned.get()));
+      }
+      return *this;
+    }
+    FrozenHash& operator=(FrozenHash&& mov)
+    {
+      _owned = std::move(mov._owned);
+      _attach(mov._data);
+      mov._attach(nullptr);
+      return *this;
+    }
+
+  protected:
+    static constexpr uint32_t DIRECT = 0x80000000; // Marks a displacement that stores the slot of a single key directly
+
+    // The blob is laid out as the header, the displacements, the entries, and then the string pool, each starting on an
+    // 8-byte boundary.
+    BUN_FORCEINLINE static size_t _align(size_t x) { return (x + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1); }
+    BUN_FORCEINLINE static size_t _entryOffset(uint32_t buckets)
+    {
+      return _align(sizeof(Header) + sizeof(uint32_t) * buckets);
+    }
+    BUN_FORCEINLINE static size_t _poolOffset(uint32_t count, uint32_t buckets)
+    {
+      return _align(_entryOffset(buckets) + sizeof(Entry) * count);
+    }
+    BUN_FORCEINLINE static uint32_t _range(uint32_t x, uint32_t n) { return uint32_t((uint64_t(x) * n) >> 32); }
+    BUN_FORCEINLINE static uint32_t _place(uint64_t h, uint32_t d, uint32_t n)
+    {
+      return _range(uint32_t(((h ^ (d * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL) >> 32), n);
+    }
+    BUN_FORCEINLINE uint32_t _slot(uint64_t h) const
+    {
+      uint32_t d = _disp[_range(uint32_t(h), _buckets)];
+      return (d & DIRECT) ? (d & ~DIRECT) : _place(h, d, _count);
+    }
+    inline size_t _find(VIEW key) const
+      requires IsStringKey
+    {
+      if(!_count)
+        return 0;
+      uint32_t i = _slot(internal::HashView64<CHAR, INS>(key, _seed));
+      return internal::HashViewEqual<CHAR, INS>(_str<CHAR>(_entries[i].key), key) ? i : _count;
+    }
+    template<class C> BUN_FORCEINLINE std::basic_string_view<C> _str(const internal::FrozenStr& s) const
+    {
+      return std::basic_string_view<C>(reinterpret_cast<const C*>(_pool + s.offset), s.length);
+    }
+
+    static bool _validate(const Header& h)
+    {
+      return h.magic == MAGIC && h.format == FORMAT && h.count < DIRECT && (h.buckets > 0 || !h.count) &&
+             h.size >= _poolOffset(h.count, h.buckets) && !(h.size & (alignof(uint64_t) - 1));
+    }
+    inline void _attach(const std::byte* data)
+    {
+      _data = data;
+      if(!data)
+      {
+        _count = _buckets = 0;
+        _seed             = 0;
+        _disp             = nullptr;
+        _entries          = nullptr;
+        _pool             = nullptr;
+        return;
+      }
+      const Header* h = reinterpret_cast<const Header*>(data);
+      _count          = h->count;
+      _buckets        = h->buckets;
+      _seed           = h->seed;
+      _disp           = reinterpret_cast<const uint32_t*>(data + sizeof(Header));
+      _entries        = reinterpret_cast<const Entry*>(data + _entryOffset(_buckets));
+      _pool           = data + _poolOffset(_count, _buckets);
+    }
+
+    // Finds a displacement for every bucket, starting with the largest buckets while the table is still mostly empty.
+    // Buckets with only one key don't need to search at all, because their displacement can just store a free slot.
+    // Returns 1 on success, 0 if a new seed is needed, or -1 if there are duplicate keys.
+    template<class KF>
+    static int _search(uint32_t n, uint32_t buckets, uint64_t seed, KF& getkey, uint64_t* hashes, uint32_t* disp)
+    {
+      std::unique_ptr<uint32_t[]> start(new uint32_t[buckets + 1]());
+      std::unique_ptr<uint32_t[]> order(new uint32_t[n]);
+      std::unique_ptr<uint32_t[]> slots(new uint32_t[n]);
+      std::unique_ptr<uint8_t[]> taken(new uint8_t[n]());
+
+      for(uint32_t i = 0; i < n; ++i)
+      {
+        hashes[i] = internal::FrozenHashKey<Key, INS>(getkey(i), seed);
+        ++start[_range(uint32_t(hashes[i]), buckets) + 1];
+      }
+      uint32_t largest = 0;
+      for(uint32_t b = 0; b < buckets; ++b)
+      {
+        largest = bun_max(largest, start[b + 1]);
+        start[b + 1] += start[b];
+      }
+      {
+        std::unique_ptr<uint32_t[]> fill(new uint32_t[buckets]);
+        memcpy(fill.get(), start.get(), sizeof(uint32_t) * buckets);
+        for(uint32_t i = 0; i < n; ++i)
+          order[fill[_range(uint32_t(hashes[i]), buckets)]++] = i;
+      }
+
+      // Sorts the buckets by size, largest first
+      std::unique_ptr<uint32_t[]> bysize(new uint32_t[largest + 2]());
+      std::unique_ptr<uint32_t[]> sorted(new uint32_t[buckets]);
+      for(uint32_t b = 0; b < buckets; ++b)
+        ++bysize[largest - (start[b + 1] - start[b]) + 1];
+      for(uint32_t s = 0; s <= largest; ++s)
+        bysize[s + 1] += bysize[s];
+      for(uint32_t b = 0; b < buckets; ++b)
+        sorted[bysize[largest - (start[b + 1] - start[b])]++] = b;
+
+      uint32_t free = 0;
+      for(uint32_t k = 0; k < buckets; ++k)
+      {
+        uint32_t b             = sorted[k];
+        const uint32_t* bucket = order.get() + start[b];
+        uint32_t size          = start[b + 1] - start[b];
+        disp[b]                = 0;
+        if(size == 1)
+        {
+          while(taken[free])
+            ++free;
+          taken[free] = 1;
+          disp[b]     = DIRECT | free;
+          continue;
+        }
+        if(!size)
+          continue;
+
+        for(uint32_t i = 0; i < size; ++i) // Two keys with the same hash can never be separated by a displacement
+          for(uint32_t j = 0; j < i; ++j)
+            if(hashes[bucket[i]] == hashes[bucket[j]])
+              return KH_AUTO_EQUAL<Key, INS>(getkey(bucket[i]), getkey(bucket[j])) ? -1 : 0;
+
+        uint32_t d = 0;
+        for(; d < MAX_DISPLACE; ++d)
+        {
+          uint32_t i = 0;
+          for(; i < size; ++i)
+          {
+            slots[i] = _place(hashes[bucket[i]], d, n);
+            if(taken[slots[i]])
+              break;
+            taken[slots[i]] = 1;
+          }
+          if(i == size)
+            break;
+          while(i > 0) // Undo the slots this displacement already claimed
+            taken[slots[--i]] = 0;
+        }
+        if(d == MAX_DISPLACE)
+          return 0;
+        disp[b] = d;
+      }
+      return 1;
+    }
+
+    template<class KF, class VF> bool _build(uint32_t n, KF&& getkey, VF&& getval)
+    {
+      Clear();
+      if(n >= DIRECT)
+        return false;
+
+      uint32_t buckets = bun_max(1u, (n + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET);
+      std::unique_ptr<uint64_t[]> hashes(new uint64_t[n]);
+      std::unique_ptr<uint32_t[]> disp(new uint32_t[buckets]);
+      uint64_t seed = 0;
+      int r         = 0;
+      for(uint32_t attempt = 0; attempt < MAX_SEEDS && r == 0; ++attempt)
+      {
+        seed = internal::HashMix(attempt + 1, 0x9E3779B97F4A7C15ULL);
+        r    = _search(n, buckets, seed, getkey, hashes.get(), disp.get());
+      }
+      if(r <= 0)
+        return false;
+
+      size_t pool = 0;
+      for(uint32_t i = 0; i < n; ++i)
+      {
+        if constexpr(IsStringKey)
+          pool = _poolSize<CHAR>(pool, internal::HashKeyView<CHAR>(getkey(i)));
+        if constexpr(IsStringData)
+          pool = _poolSize<typename DATAVIEW::value_type>(
+            pool, internal::HashKeyView<typename DATAVIEW::value_type>(getval(i)));
+      }
+      if(pool > 0xFFFFFFFF)
+        return false;
+
+      size_t size = _align(_poolOffset(n, buckets) + pool);
+      _owned.reset(new uint64_t[size / sizeof(uint64_t)]());
+      std::byte* data = reinterpret_cast<std::byte*>(_owned.get());
+      Header* h       = reinterpret_cast<Header*>(data);
+      h->magic        = MAGIC;
+      h->format       = FORMAT;
+      h->count        = n;
+      h->buckets      = buckets;
+      h->seed         = seed;
+      h->size         = size;
+      memcpy(data + sizeof(Header), disp.get(), sizeof(uint32_t) * buckets);
+
+      Entry* entries = reinterpret_cast<Entry*>(data + _entryOffset(buckets));
+      std::byte* p   = data + _poolOffset(n, buckets);
+      pool           = 0;
+      for(uint32_t i = 0; i < n; ++i)
+      {
+        uint32_t d = disp[_range(uint32_t(hashes[i]), buckets)];
+        Entry& e   = entries[(d & DIRECT) ? (d & ~DIRECT) : _place(hashes[i], d, n)];
+        if constexpr(IsStringKey)
+          e.key = _poolAdd<CHAR>(p, pool, internal::HashKeyView<CHAR>(getkey(i)));
+        else
+          memcpy(&e.key, &getkey(i), sizeof(Key));
+        if constexpr(IsStringData)
+          e.value = _poolAdd<typename DATAVIEW::value_type>(
+            p, pool, internal::HashKeyView<typename DATAVIEW::value_type>(getval(i)));
+        else if constexpr(IsMap)
+          memcpy(&e.value, &getval(i), sizeof(Data));
+      }
+      _attach(data);
+      return true;
+    }
+    template<class C> BUN_FORCEINLINE static size_t _poolSize(size_t pool, std::basic_string_view<C> s)
+    {
+      return ((pool + alignof(C) - 1) & ~(alignof(C) - 1)) + (s.size() + 1) * sizeof(C);
+    }
+    // Copies a string into the pool with a null terminator
+    template<class C> static internal::FrozenStr _poolAdd(std::byte* p, size_t& pool, std::basic_string_view<C> s)
+    {
+      pool = (pool + alignof(C) - 1) & ~(alignof(C) - 1);
+      internal::FrozenStr r = { uint32_t(pool), uint32_t(s.size()) };
+      memcpy(p + pool, s.data(), s.size() * sizeof(C));
+      pool += (s.size() + 1) * sizeof(C);
+      return r;
+    }
+
+    std::unique_ptr<uint64_t[]> _owned;
+    const std::byte* _data;
+    const uint32_t* _disp;
+    const Entry* _entries;
+    const std::byte* _pool;
+    uint64_t _seed;
+    uint32_t _count;
+    uint32_t _buckets;
+  };
+
+  // Case-insensitive FrozenHash
+  template<class Key, class Data = void> using FrozenHashIns = FrozenHash<Key, Data, true>;
+}
+
+#endif
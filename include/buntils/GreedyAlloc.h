@@ -138,6 +138,7 @@ namespace bun {
   protected:
     BUN_FORCEINLINE void _allocChunk(size_t nsize) noexcept
     {
+      nsize        = AlignSize(nsize, _align); // aligned_alloc requires the size to be a multiple of the alignment
       Node* retval = reinterpret_cast<Node*>(ALIGNEDALLOC(_alignsize + nsize, _align));
       assert(retval != 0);
       retval->next = _root.load(std::memory_order_acquire);
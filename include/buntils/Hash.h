@@ -9,7 +9,10 @@
 #include "khash.h"
 #include "Serializer.h"
 #include "Str.h"
+#include <bit>
 #include <iterator>
+#include <span>
+#include <string_view>
 #include <utility>
 #include <wchar.h>
 
@@ -32,39 +35,175 @@ namespace bun {
       return static_cast<const khint_t>(key);
   }
 
-  // String hash function
-  template<class T, bool IgnoreCase> inline khint_t KH_STR_HASH(const T* s) = delete;
-  template<> inline khint_t KH_STR_HASH<char, false>(const char* s)
+  namespace internal {
+    // 64-bit multiply that folds the 128-bit result back into 64 bits, the core mixing step of wyhash
+    BUN_FORCEINLINE uint64_t HashMix(uint64_t a, uint64_t b)
+    {
+#if defined(BUN_64BIT) && defined(BUN_COMPILER_MSC)
+      uint64_t hi;
+      uint64_t lo = _umul128(a, b, &hi);
+      return lo ^ hi;
+#elif defined(BUN_64BIT)
+      unsigned __int128 r = (unsigned __int128)a * b;
+      return uint64_t(r) ^ uint64_t(r >> 64);
+#else
+      uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+      uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+      uint64_t lo = t + (rm1 << 32);
+      c += lo < t;
+      return lo ^ (rh + (rm0 >> 32) + (rm1 >> 32) + c);
+#endif
+    }
+
+    // Lowercases every ASCII letter packed into a 64-bit word at once, leaving every other byte alone
+    BUN_FORCEINLINE uint64_t HashFoldCase(uint64_t w)
+    {
+      constexpr uint64_t ONES = 0x0101010101010101ULL;
+      uint64_t low7           = w & (ONES * 0x7F);
+      uint64_t upper          = ((low7 + ONES * (0x80 - 'A')) ^ (low7 + ONES * (0x80 - 'Z' - 1))) & ~w & (ONES * 0x80);
+      return w | (upper >> 2);
+    }
+
+    template<bool FOLD> BUN_FORCEINLINE uint64_t HashRead64(const char* p)
+    {
+      uint64_t v;
+      memcpy(&v, p, sizeof(v));
+      return FOLD ? HashFoldCase(v) : v;
+    }
+    BUN_FORCEINLINE uint64_t HashRead32(const char* p)
+    {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    // Reads 16 bytes, lowercasing all of them with a single SSE2 compare if FOLD is true
+    template<bool FOLD> BUN_FORCEINLINE void HashRead128(const char* p, uint64_t& a, uint64_t& b)
+    {
+#ifdef BUN_SSE_ENABLED
+      if constexpr(FOLD)
+      {
+        __m128i v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        alignas(16) uint64_t r[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(r), _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+        a = r[0];
+        b = r[1];
+        return;
+      }
+#endif
+      a = HashRead64<FOLD>(p);
+      b = HashRead64<FOLD>(p + 8);
+    }
+
+    // 64-bit string hash based on wyhash. It reads 16 to 48 bytes per step and only looks at the first and last 16 bytes of
+    // short strings, so it relies on knowing the length up front instead of searching for a null terminator. If FOLD is
+    // true, ASCII letters are lowercased as they are read, which gives the same result as hashing a lowercase copy.
+    template<bool FOLD> inline uint64_t HashBytes(const char* p, size_t len, uint64_t seed = 0)
+    {
+      constexpr uint64_t P0 = 0xa0761d6478bd642fULL, P1 = 0xe7037ed1a0b428dbULL, P2 = 0x8ebc6af09c88c6e3ULL,
+                         P3 = 0x589965cc75374cc3ULL;
+      seed ^= HashMix(seed ^ P0, P1);
+      uint64_t a, b;
+      if(len <= 16)
+      {
+        if(len >= 4)
+        {
+          size_t mid = (len >> 3) << 2;
+          a          = (HashRead32(p) << 32) | HashRead32(p + mid);
+          b          = (HashRead32(p + len - 4) << 32) | HashRead32(p + len - 4 - mid);
+        }
+        else if(len > 0)
+        {
+          a = (uint64_t(uint8_t(p[0])) << 16) | (uint64_t(uint8_t(p[len >> 1])) << 8) | uint8_t(p[len - 1]);
+          b = 0;
+        }
+        else
+          a = b = 0;
+        if constexpr(FOLD)
+        {
+          a = HashFoldCase(a);
+          b = HashFoldCase(b);
+        }
+      }
+      else
+      {
+        size_t i = len;
+        if(i > 48)
+        {
+          uint64_t s1 = seed, s2 = seed, x, y;
+          do
+          {
+            HashRead128<FOLD>(p, x, y);
+            seed = HashMix(x ^ P1, y ^ seed);
+            HashRead128<FOLD>(p + 16, x, y);
+            s1 = HashMix(x ^ P2, y ^ s1);
+            HashRead128<FOLD>(p + 32, x, y);
+            s2 = HashMix(x ^ P3, y ^ s2);
+            p += 48;
+            i -= 48;
+          } while(i > 48);
+          seed ^= s1 ^ s2;
+        }
+        while(i > 16)
+        {
+          uint64_t x, y;
+          HashRead128<FOLD>(p, x, y);
+          seed = HashMix(x ^ P1, y ^ seed);
+          p += 16;
+          i -= 16;
+        }
+        HashRead128<FOLD>(p + i - 16, a, b);
+      }
+      return HashMix(P1 ^ len, HashMix(a ^ P1, b ^ seed));
+    }
+
+    BUN_FORCEINLINE khint_t HashFold32(uint64_t h) { return khint_t(h ^ (h >> 32)); }
+
+    // Full 64-bit string hash that KH_STR_HASH folds down to 32 bits
+    template<class C, bool INS> inline uint64_t HashView64(std::basic_string_view<C> s, uint64_t seed = 0)
+    {
+      if constexpr(INS && !std::is_same_v<C, char>)
+      {
+        // Wide strings can contain non-ASCII letters, so they have to be lowercased one character at a time
+        uint64_t h = seed;
+        for(C c : s)
+          h = HashMix(h ^ towlower(c), 0x9E3779B97F4A7C15ULL);
+        return HashMix(h ^ s.size(), 0xa0761d6478bd642fULL);
+      }
+      else
+        return HashBytes<INS>(reinterpret_cast<const char*>(s.data()), s.size() * sizeof(C), seed);
+    }
+  }
+
+  // String hash function. The length-aware versions are faster if the length is already known, and give the same result.
+  template<class T, bool IgnoreCase> inline khint_t KH_STR_HASH(const T* s, size_t len) = delete;
+  template<> inline khint_t KH_STR_HASH<char, false>(const char* s, size_t len)
   {
-    khint_t h = *s;
-    if(h)
-      for(++s; *s; ++s)
-        h = (h << 5) - h + *s;
-    return h;
+    return internal::HashFold32(internal::HashBytes<false>(s, len));
   }
-  template<> inline khint_t KH_STR_HASH<char, true>(const char* s)
+  template<> inline khint_t KH_STR_HASH<char, true>(const char* s, size_t len)
   {
-    khint_t h = ((*s) > 64 && (*s) < 91) ? (*s) + 32 : *s;
-    if(h)
-      for(++s; *s; ++s)
-        h = (h << 5) - h + (((*s) > 64 && (*s) < 91) ? (*s) + 32 : *s);
-    return h;
+    return internal::HashFold32(internal::HashBytes<true>(s, len));
   }
+  template<> inline khint_t KH_STR_HASH<wchar_t, false>(const wchar_t* s, size_t len)
+  {
+    return internal::HashFold32(internal::HashBytes<false>(reinterpret_cast<const char*>(s), len * sizeof(wchar_t)));
+  }
+  template<> inline khint_t KH_STR_HASH<wchar_t, true>(const wchar_t* s, size_t len)
+  {
+    return internal::HashFold32(internal::HashView64<wchar_t, true>(std::wstring_view(s, len)));
+  }
+
+  template<class T, bool IgnoreCase> inline khint_t KH_STR_HASH(const T* s) = delete;
+  template<> inline khint_t KH_STR_HASH<char, false>(const char* s) { return KH_STR_HASH<char, false>(s, strlen(s)); }
+  template<> inline khint_t KH_STR_HASH<char, true>(const char* s) { return KH_STR_HASH<char, true>(s, strlen(s)); }
   template<> inline khint_t KH_STR_HASH<wchar_t, false>(const wchar_t* s)
   {
-    khint_t h = *s;
-    if(h)
-      for(++s; *s; ++s)
-        h = (h << 5) - h + *s;
-    return h;
+    return KH_STR_HASH<wchar_t, false>(s, wcslen(s));
   }
   template<> inline khint_t KH_STR_HASH<wchar_t, true>(const wchar_t* s)
   {
-    khint_t h = towlower(*s);
-    if(h)
-      for(++s; *s; ++s)
-        h = (h << 5) - h + towlower(*s);
-    return h;
+    return KH_STR_HASH<wchar_t, true>(s, wcslen(s));
   }
 
   // String equality function
@@ -77,6 +216,61 @@ namespace bun {
   template<typename T, bool INS = false> // forward declaration for the multihash
   BUN_FORCEINLINE khint_t KH_AUTO_HASH(const T& k);
 
+  namespace internal {
+    // Matches any basic_string of C, including Str with a custom allocator
+    template<typename T, typename C>
+    concept HashString = requires { typename T::allocator_type; } &&
+                         std::is_base_of_v<std::basic_string<C, std::char_traits<C>, typename T::allocator_type>, T>;
+
+    // Matches strings that know their own length, including views of borrowed characters
+    template<typename T, typename C>
+    concept HashSizedString = HashString<T, C> || std::is_same_v<T, std::basic_string_view<C>>;
+
+    // Compares two strings that have already been measured
+    template<typename C, bool INS>
+    BUN_FORCEINLINE bool HashViewEqual(std::basic_string_view<C> a, std::basic_string_view<C> b)
+    {
+      if(a.size() != b.size())
+        return false;
+      if constexpr(!INS)
+        return std::char_traits<C>::compare(a.data(), b.data(), a.size()) == 0;
+      else if constexpr(std::is_same_v<C, char>)
+        return STRNICMP(a.data(), b.data(), a.size()) == 0;
+      else
+        return WCSNICMP(a.data(), b.data(), a.size()) == 0;
+    }
+  }
+
+  // Stores a key together with its hash, so a Hash using it as a key never has to hash the key's contents again when it
+  // grows, and most mismatched keys are rejected by comparing hashes instead of contents. INS must match the table, so
+  // HashIns needs HashedKey<K, true>.
+  template<typename K, bool INS = false> class HashedKey
+  {
+  public:
+    using KEY                        = K;
+    static constexpr bool IgnoreCase = INS;
+
+    HashedKey() : _key(), _hash(KH_AUTO_HASH<K, INS>(_key)) {}
+    HashedKey(const K& key) : _key(key), _hash(KH_AUTO_HASH<K, INS>(_key)) {}
+    HashedKey(K&& key) : _key(std::move(key)), _hash(KH_AUTO_HASH<K, INS>(_key)) {}
+    template<typename U>
+      requires(std::is_constructible_v<K, U &&> && !std::is_same_v<std::remove_cvref_t<U>, HashedKey> &&
+               !std::is_same_v<std::remove_cvref_t<U>, K>)
+    HashedKey(U&& key) : _key(std::forward<U>(key)), _hash(KH_AUTO_HASH<K, INS>(_key))
+    {}
+
+    BUN_FORCEINLINE const K& GetKey() const { return _key; }
+    BUN_FORCEINLINE khint_t GetHash() const { return _hash; }
+    BUN_FORCEINLINE operator const K&() const { return _key; }
+    inline bool operator==(const HashedKey& r) const { return _hash == r._hash && _key == r._key; }
+
+  protected:
+    K _key;
+    khint_t _hash;
+  };
+
+  using HashedStr = HashedKey<Str>;
+
   // Hash for tuples, pairs, and arrays that combines the hashes of each element
   template<typename T, int I> inline khint_t KH_MULTI_HASH(const T& k)
   {
@@ -102,10 +296,15 @@ namespace bun {
     if constexpr(std::is_same<T, char*>::value || std::is_same<T, wchar_t*>::value || std::is_same<T, const char*>::value ||
                  std::is_same<T, const wchar_t*>::value)
       return KH_STR_HASH<std::remove_const_t<std::remove_pointer_t<T>>, INS>(k);
-    else if constexpr(std::is_base_of<std::string, T>::value)
-      return KH_STR_HASH<char, INS>(k.c_str());
-    else if constexpr(std::is_base_of<std::basic_string<wchar_t>, T>::value)
-      return KH_STR_HASH<wchar_t, INS>(k.c_str());
+    else if constexpr(internal::HashSizedString<T, char>)
+      return KH_STR_HASH<char, INS>(k.data(), k.size());
+    else if constexpr(internal::HashSizedString<T, wchar_t>)
+      return KH_STR_HASH<wchar_t, INS>(k.data(), k.size());
+    else if constexpr(requires { k.GetHash(); })
+    {
+      static_assert(T::IgnoreCase == INS, "A HashedKey must use the same case sensitivity as the table it's in");
+      return k.GetHash();
+    }
     else if constexpr(is_specialization_of<T, std::tuple>::value || is_specialization_of<T, std::pair>::value ||
                       is_specialization_of_array<T>::value)
       return KH_MULTI_HASH<T, std::tuple_size<T>::value - 1>(k);
@@ -119,10 +318,16 @@ namespace bun {
     if constexpr(std::is_same<T, char*>::value || std::is_same<T, wchar_t*>::value || std::is_same<T, const char*>::value ||
                  std::is_same<T, const wchar_t*>::value)
       return KH_STR_EQUAL<std::remove_const_t<std::remove_pointer_t<T>>, INS>(a, b);
-    else if constexpr(std::is_base_of<std::string, T>::value)
+    else if constexpr(!INS && (internal::HashString<T, char> || internal::HashString<T, wchar_t>))
+      return a.size() == b.size() && std::char_traits<typename T::value_type>::compare(a.data(), b.data(), a.size()) == 0;
+    else if constexpr(internal::HashString<T, char>)
       return KH_STR_EQUAL<char, INS>(a.c_str(), b.c_str());
-    else if constexpr(std::is_base_of<std::basic_string<wchar_t>, T>::value)
+    else if constexpr(internal::HashString<T, wchar_t>)
       return KH_STR_EQUAL<wchar_t, INS>(a.c_str(), b.c_str());
+    else if constexpr(internal::HashSizedString<T, char> || internal::HashSizedString<T, wchar_t>)
+      return internal::HashViewEqual<typename T::value_type, INS>(a, b);
+    else if constexpr(requires { a.GetHash(); })
+      return a.GetHash() == b.GetHash() && KH_AUTO_EQUAL<typename T::KEY, INS>(a.GetKey(), b.GetKey());
     else if constexpr(is_specialization_of<T, std::tuple>::value || is_specialization_of<T, std::pair>::value ||
                       is_specialization_of_array<T>::value)
       return KH_MULTI_EQUAL<T, std::tuple_size<T>::value - 1>(a, b);
@@ -163,33 +368,230 @@ namespace bun {
       static BUN_FORCEINLINE GET F(std::wstring& s) { return s.c_str(); }
     };
 #endif
+
+    // Gets the character type of a string key, or void if the key isn't a string
+    template<class T> struct HashChar
+    {
+      using type = void;
+    };
+    template<class T>
+      requires(std::is_same_v<T, char*> || std::is_same_v<T, const char*> || HashSizedString<T, char>)
+    struct HashChar<T>
+    {
+      using type = char;
+    };
+    template<class T>
+      requires(std::is_same_v<T, wchar_t*> || std::is_same_v<T, const wchar_t*> || HashSizedString<T, wchar_t>)
+    struct HashChar<T>
+    {
+      using type = wchar_t;
+    };
+    template<class T>
+      requires requires(const T& k) { k.GetHash(); }
+    struct HashChar<T> : HashChar<typename T::KEY>
+    {};
+
+    // Borrows the characters of a string key without copying them
+    template<class C, class T> BUN_FORCEINLINE std::basic_string_view<C> HashKeyView(const T& k)
+    {
+      if constexpr(std::is_pointer_v<T>)
+        return std::basic_string_view<C>(k);
+      else if constexpr(requires { k.GetHash(); })
+        return HashKeyView<C>(k.GetKey());
+      else
+        return std::basic_string_view<C>(k.data(), k.size());
+    }
+
+    // Returns 0 or 1 if a table can look up a string key using borrowed characters, which is only possible if it uses the
+    // standard hash and equality functions, since those always agree with KH_STR_HASH and HashViewEqual. 1 means the
+    // table ignores case. Returns -1 if the table can't do this.
+    template<class Key, khint_t (*HashFunc)(const Key&), bool (*HashEqual)(const Key&, const Key&)>
+    consteval int HashTransparency()
+    {
+      if constexpr(std::is_void_v<typename HashChar<Key>::type>)
+        return -1;
+      else if constexpr(requires { Key::IgnoreCase; })
+        return (HashFunc == &KH_AUTO_HASH<Key, Key::IgnoreCase> && HashEqual == &KH_AUTO_EQUAL<Key, Key::IgnoreCase>) ?
+                 Key::IgnoreCase :
+                 -1;
+      else if(HashFunc == &KH_AUTO_HASH<Key, false> && HashEqual == &KH_AUTO_EQUAL<Key, false>)
+        return 0;
+      else if(HashFunc == &KH_AUTO_HASH<Key, true> && HashEqual == &KH_AUTO_EQUAL<Key, true>)
+        return 1;
+      return -1;
+    }
+  }
+
+  // Selects how a Hash lays out and probes its buckets
+  enum HASH_LAYOUT : uint8_t
+  {
+    HASH_KHASH = 0, // khash quadratic probing over 2-bit bucket flags, one bucket at a time
+    HASH_SWISS = 1, // Groups of 16 control bytes holding 7 bits of each key's hash, matched 16 at a time with SSE2
+    HASH_INCREMENTAL = 2, // Same as HASH_KHASH, but growing moves a few buckets at a time instead of rehashing at once
+  };
+
+  namespace internal {
+    // Holds the old bucket arrays of a HASH_INCREMENTAL table while they are being moved into the new ones. Copies never
+    // inherit a migration in progress, they only keep the migration step.
+    template<class Key, class Data, bool INCREMENTAL> struct HashMigration
+    {};
+
+    template<class Key, class Data> struct HashMigration<Key, Data, true>
+    {
+      static constexpr khint_t DEFAULT_STEP = 64;
+
+      HashMigration() :
+        old_flags(0), old_keys(0), old_vals(0), old_n(0), old_pos(0), old_live(0), migrate_step(DEFAULT_STEP)
+      {}
+      HashMigration(const HashMigration& copy) :
+        old_flags(0), old_keys(0), old_vals(0), old_n(0), old_pos(0), old_live(0), migrate_step(copy.migrate_step)
+      {}
+      HashMigration(HashMigration&& mov) :
+        old_flags(mov.old_flags),
+        old_keys(mov.old_keys),
+        old_vals(mov.old_vals),
+        old_n(mov.old_n),
+        old_pos(mov.old_pos),
+        old_live(mov.old_live),
+        migrate_step(mov.migrate_step)
+      {
+        mov.old_flags = 0;
+        mov.old_keys  = 0;
+        mov.old_vals  = 0;
+        mov.old_n     = 0;
+        mov.old_pos   = 0;
+        mov.old_live  = 0;
+      }
+      // The owner must have already released its own old arrays
+      HashMigration& operator=(HashMigration&& mov)
+      {
+        old_flags     = mov.old_flags;
+        old_keys      = mov.old_keys;
+        old_vals      = mov.old_vals;
+        old_n         = mov.old_n;
+        old_pos       = mov.old_pos;
+        old_live      = mov.old_live;
+        migrate_step  = mov.migrate_step;
+        mov.old_flags = 0;
+        mov.old_keys  = 0;
+        mov.old_vals  = 0;
+        mov.old_n     = 0;
+        mov.old_pos   = 0;
+        mov.old_live  = 0;
+        return *this;
+      }
+
+      khint8_t* old_flags; // Only non-null while a migration is in progress
+      Key* old_keys;
+      Data* old_vals;
+      khint_t old_n;        // Number of buckets in the old arrays
+      khint_t old_pos;      // Every old bucket before this one has already been moved
+      khint_t old_live;     // Number of keys still in the old buckets
+      khint_t migrate_step; // Maximum number of old buckets moved by a single insertion or removal
+    };
+
+    // Hints that memory is about to be read, so the cache misses for several lookups can be in flight at once
+    BUN_FORCEINLINE void HashPrefetch(const void* p)
+    {
+#ifdef BUN_SSE_ENABLED
+      _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0);
+#elif defined(BUN_COMPILER_GCC) || defined(BUN_COMPILER_CLANG)
+      __builtin_prefetch(p);
+#endif
+    }
+
+    // A group of control bytes in a HASH_SWISS table. Each byte is either EMPTY, DELETED, or holds the low 7 bits of the
+    // hash of the key in that bucket, so the high bit is only set on buckets that don't hold anything.
+    struct HashGroup
+    {
+      static constexpr khint8_t EMPTY   = 0x80;
+      static constexpr khint8_t DELETED = 0xFE;
+      static constexpr khint_t SIZE     = 16;
+
+#ifdef BUN_SSE_ENABLED
+      // Returns a bitmask of every bucket in the group whose control byte is h
+      BUN_FORCEINLINE static uint32_t Match(const khint8_t* group, khint8_t h)
+      {
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h)));
+      }
+      // Returns a bitmask of every bucket that is either empty or deleted
+      BUN_FORCEINLINE static uint32_t MatchFree(const khint8_t* group)
+      {
+        return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+      }
+#else
+      BUN_FORCEINLINE static uint32_t Match(const khint8_t* group, khint8_t h)
+      {
+        uint32_t r = 0;
+        for(khint_t i = 0; i < SIZE; ++i)
+          r |= uint32_t(group[i] == h) << i;
+        return r;
+      }
+      BUN_FORCEINLINE static uint32_t MatchFree(const khint8_t* group)
+      {
+        uint32_t r = 0;
+        for(khint_t i = 0; i < SIZE; ++i)
+          r |= uint32_t(group[i] >> 7) << i;
+        return r;
+      }
+#endif
+      BUN_FORCEINLINE static uint32_t MatchEmpty(const khint8_t* group) { return Match(group, EMPTY); }
+    };
   }
 
-  // Template hash class based on the khash C implementation
+  // Template hash class based on the khash C implementation. Setting Layout to HASH_SWISS switches the table to
+  // SIMD group probing, which only compares keys whose 7-bit hash fragment matches and can usually delete without
+  // leaving a tombstone behind, at the cost of being a bit less dense (7/8 maximum load instead of 0.77).
+  //
+  // Setting Layout to HASH_INCREMENTAL keeps the old buckets around when the table grows, and every insertion or removal
+  // moves at most GetMigrationStep() of them into the new buckets, so no single operation has to rehash the whole table.
+  // Lookups search both sets of buckets until the migration finishes. A lookup that finds a key in the old buckets returns
+  // an iterator past Capacity(), which can be used like any other iterator until the table is modified again.
   template<class Key, class Data = void, khint_t (*HashFunc)(const Key&) = &KH_AUTO_HASH<Key, false>,
            bool (*HashEqual)(const Key&, const Key&) = &KH_AUTO_EQUAL<Key, false>,
-           typename Alloc = StandardAllocator<std::byte>, typename RECURSIVE_KEY = Key, typename RECURSIVE_DATA = Data>
-  class BUN_COMPILER_DLLEXPORT Hash : protected Alloc
+           typename Alloc = StandardAllocator<std::byte>, typename RECURSIVE_KEY = Key, typename RECURSIVE_DATA = Data,
+           HASH_LAYOUT Layout = HASH_KHASH>
+  class BUN_COMPILER_DLLEXPORT BUN_EMPTY_BASES Hash :
+    protected Alloc,
+    protected internal::HashMigration<Key, Data, Layout == HASH_INCREMENTAL>
   {
+    using Group     = internal::HashGroup;
+    using Migration = internal::HashMigration<Key, Data, Layout == HASH_INCREMENTAL>;
+
   public:
-    static constexpr bool IsMap = !std::is_void_v<Data>;
+    static constexpr bool IsMap   = !std::is_void_v<Data>;
+    static constexpr bool IsSwiss       = Layout == HASH_SWISS;
+    static constexpr bool IsIncremental = Layout == HASH_INCREMENTAL;
     using KEY                   = Key;
     using DATA                  = Data;
     using FakeData              = typename std::conditional<IsMap, Data, std::byte>::type;
     using GET                   = std::conditional_t<std::is_integral_v<FakeData> || std::is_enum_v<FakeData> ||
                                                        std::is_pointer_v<FakeData> || std::is_member_pointer_v<FakeData>,
                                                      FakeData, typename internal::_HashGET<FakeData>::GET>;
+    static constexpr size_t BATCH = 16; // Keys hashed and prefetched at once by FindBatch and InsertBatch
+
+    // String keys using the standard hash and equality functions can also be looked up with a VIEW of borrowed characters,
+    // or with a HashedKey<VIEW, IgnoreCase> that already has the hash computed, without constructing a temporary Key.
+    static constexpr bool IsTransparent = internal::HashTransparency<Key, HashFunc, HashEqual>() >= 0;
+    static constexpr bool IgnoreCase    = internal::HashTransparency<Key, HashFunc, HashEqual>() > 0;
+    using CHAR = std::conditional_t<IsTransparent, typename internal::HashChar<Key>::type, char>;
+    using VIEW = std::basic_string_view<CHAR>;
+    template<class V>
+    static constexpr bool IsView =
+      IsTransparent && (std::is_same_v<V, VIEW> || std::is_same_v<V, HashedKey<VIEW, IgnoreCase>>);
 
     Hash(const Hash& copy)
       requires(is_copy_constructible_or_incomplete_v<RECURSIVE_KEY> &&
                (!IsMap || is_copy_constructible_or_incomplete_v<RECURSIVE_DATA>))
-      : Alloc(copy), n_buckets(0), flags(0), keys(0), vals(0), sz(0), n_occupied(0), upper_bound(0)
+      : Alloc(copy), Migration(copy), n_buckets(0), flags(0), keys(0), vals(0), sz(0), n_occupied(0), upper_bound(0)
     {
       if(copy.n_buckets > 0)
         _docopy(copy);
     }
     Hash(Hash&& mov) :
       Alloc(std::move(mov)),
+      Migration(std::move(mov)),
       n_buckets(mov.n_buckets),
       flags(mov.flags),
       keys(mov.keys),
@@ -270,13 +672,55 @@ namespace bun {
       return _put<Key&&>(std::move(key), &r);
     }
 
+    // Looks up every key and stores what Iterator() would return for it in out, which must be at least as long as batch.
+    // Keys are handled in blocks of BATCH: every key in a block is hashed and its buckets are prefetched before any of
+    // them are probed, so the cache misses of a whole block overlap instead of each lookup waiting on the last one.
+    inline void FindBatch(std::span<const Key> batch, std::span<khiter_t> out) const
+    {
+      assert(out.size() >= batch.size());
+      khint_t h[BATCH];
+      for(size_t base = 0; base < batch.size(); base += BATCH)
+      {
+        size_t n = bun_min(BATCH, batch.size() - base);
+        for(size_t j = 0; j < n; ++j)
+          _prefetch<false>(h[j] = HashFunc(batch[base + j]));
+        for(size_t j = 0; j < n; ++j)
+        {
+          const Key& key = batch[base + j];
+          out[base + j]  = _get(h[j], [&](const Key& k) { return HashEqual(k, key); });
+        }
+      }
+    }
+    // Inserts every key with its value, overwriting the values of keys that already exist, and returns how many keys were
+    // new. If out isn't empty, it receives the index of each key. Room for every key is reserved up front, so the table
+    // never grows partway through a batch and invalidates the indices. A HASH_INCREMENTAL table does this growth all at
+    // once, so it should be given smaller batches.
+    inline size_t InsertBatch(std::span<const Key> batch, std::span<const FakeData> values, std::span<khiter_t> out = {})
+      requires IsMap
+    {
+      assert(values.size() >= batch.size());
+      return _insertBatch(batch, out, [&](size_t j, khiter_t i, int r) {
+        if(!r) // If r is 0, this key was already present, so we need to assign, not initialize
+          vals[i] = values[j];
+        else
+          new(vals + i) Data(values[j]);
+      });
+    }
+    inline size_t InsertBatch(std::span<const Key> batch, std::span<khiter_t> out = {})
+      requires(!IsMap)
+    {
+      return _insertBatch(batch, out, [](size_t, khiter_t, int) {});
+    }
+
     void Clear()
     {
+      if constexpr(IsIncremental)
+        _dropOld();
       if(flags)
       {
         for(khint_t i = 0; i < n_buckets; ++i)
         {
-          if(!__ac_iseither(flags, i))
+          if(_exists(i))
           {
             keys[i].~Key();
 
@@ -284,12 +728,27 @@ namespace bun {
               vals[i].~Data();
           }
         }
-        memset(flags, 2, n_buckets);
+        memset(flags, IsSwiss ? Group::EMPTY : 2, n_buckets);
         sz = n_occupied = 0;
       }
     }
     inline khiter_t Iterator(const Key& key) const { return _get(key); }
-    inline const Key& GetKey(khiter_t i) const { return keys[i]; }
+    // Finds a string key from borrowed characters, without constructing a Key
+    template<class V>
+      requires IsView<V>
+    inline khiter_t Iterator(const V& key) const
+    {
+      if constexpr(std::is_same_v<V, VIEW>)
+        return _getView(KH_STR_HASH<CHAR, IgnoreCase>(key.data(), key.size()), key);
+      else
+        return _getView(key.GetHash(), key.GetKey());
+    }
+    inline khiter_t Iterator(const CHAR* s, size_t len) const
+      requires IsTransparent
+    {
+      return Iterator(VIEW(s, len));
+    }
+    inline const Key& GetKey(khiter_t i) const { return _key(i); }
     inline GET GetValue(khiter_t i) const
       requires IsMap
     {
@@ -307,31 +766,42 @@ namespace bun {
       }
       if constexpr(std::is_integral_v<FakeData> || std::is_enum_v<FakeData> || std::is_pointer_v<FakeData> ||
                    std::is_member_pointer_v<FakeData>)
-        return vals[i];
+        return _val(i);
       else
-        return internal::_HashGET<FakeData>::F(vals[i]);
+        return internal::_HashGET<FakeData>::F(_val(i));
     }
     inline GET Get(const Key& key) const
       requires IsMap
     {
       return GetValue(Iterator(key));
     }
+    template<class V>
+      requires(IsMap && IsView<V>)
+    inline GET Get(const V& key) const
+    {
+      return GetValue(Iterator(key));
+    }
+    inline GET Get(const CHAR* s, size_t len) const
+      requires(IsMap && IsTransparent)
+    {
+      return GetValue(Iterator(VIEW(s, len)));
+    }
     inline const FakeData& Value(khiter_t i) const
       requires IsMap
     {
-      return vals[i];
+      return _val(i);
     }
     inline FakeData& Value(khiter_t i)
       requires IsMap
     {
-      return vals[i];
+      return _val(i);
     }
     inline FakeData* PointerValue(khiter_t i)
       requires IsMap
     {
       if(!ExistsIter(i))
         return nullptr;
-      return &vals[i];
+      return &_val(i);
     }
     inline bool SetValue(khiter_t iterator, const FakeData& newvalue)
       requires IsMap
@@ -358,14 +828,17 @@ namespace bun {
       if(n_buckets < capacity)
         _resize(capacity);
     }
-    inline bool Remove(const Key& key)
+    inline bool Remove(const Key& key) { return _remove(Iterator(key)); }
+    template<class V>
+      requires IsView<V>
+    inline bool Remove(const V& key)
     {
-      khiter_t iterator = Iterator(key);
-      if(n_buckets == iterator) // This isn't ExistsIter because _get will return n_buckets if key doesn't exist
-        return false;
-
-      _delete(iterator);
-      return true;
+      return _remove(Iterator(key));
+    }
+    inline bool Remove(const CHAR* s, size_t len)
+      requires IsTransparent
+    {
+      return _remove(Iterator(VIEW(s, len)));
     }
     inline bool RemoveIter(khiter_t iterator)
     {
@@ -373,17 +846,80 @@ namespace bun {
         return false;
 
       _delete(iterator);
+      if constexpr(IsIncremental)
+        Migrate(this->migrate_step);
       return true;
     }
     BUN_FORCEINLINE khint_t size() const { return sz; }
     BUN_FORCEINLINE khint_t Capacity() const { return n_buckets; }
     BUN_FORCEINLINE khiter_t Front() const { return 0; }
-    BUN_FORCEINLINE khiter_t Back() const { return n_buckets; }
+    BUN_FORCEINLINE khiter_t Back() const
+    {
+      if constexpr(IsIncremental)
+        return this->old_flags ? n_buckets + 1 + this->old_n : n_buckets;
+      else
+        return n_buckets;
+    }
     inline bool ExistsIter(khiter_t iterator) const
     {
-      return (std::make_unsigned_t<khiter_t>(iterator) < std::make_unsigned_t<khiter_t>(n_buckets)) && _exists(iterator);
+      using U = std::make_unsigned_t<khiter_t>;
+      if constexpr(IsIncremental)
+      {
+        if(this->old_flags && U(iterator) > U(n_buckets))
+        {
+          U j = U(iterator) - U(n_buckets) - 1;
+          return j < U(this->old_n) && !__ac_iseither(this->old_flags, j);
+        }
+      }
+      return (U(iterator) < U(n_buckets)) && _exists(iterator);
+    }
+    // Returns true while a HASH_INCREMENTAL table still has buckets left to move
+    BUN_FORCEINLINE bool IsMigrating() const
+      requires IsIncremental
+    {
+      return this->old_flags != nullptr;
+    }
+    BUN_FORCEINLINE khint_t GetMigrationStep() const
+      requires IsIncremental
+    {
+      return this->migrate_step;
+    }
+    // Sets the maximum number of old buckets that a single insertion or removal will move while the table is growing.
+    inline void SetMigrationStep(khint_t buckets)
+      requires IsIncremental
+    {
+      this->migrate_step = bun_max((khint_t)1, buckets);
+    }
+    // Moves up to the given number of old buckets, which can be used to finish a migration while the program is idle.
+    // Returns true if there are still buckets left to move.
+    inline bool Migrate(khint_t buckets = (khint_t)~0)
+      requires IsIncremental
+    {
+      if(!this->old_flags)
+        return false;
+
+      khint_t end = (this->old_n - this->old_pos <= buckets) ? this->old_n : this->old_pos + buckets;
+      for(; this->old_pos < end; ++this->old_pos)
+        if(!__ac_iseither(this->old_flags, this->old_pos))
+          _moveOld(this->old_pos);
+
+      if(this->old_pos < this->old_n)
+        return true;
+      _freeOld();
+      return false;
     }
     inline bool Exists(const Key& key) const { return ExistsIter(Iterator(key)); }
+    template<class V>
+      requires IsView<V>
+    inline bool Exists(const V& key) const
+    {
+      return ExistsIter(Iterator(key));
+    }
+    inline bool Exists(const CHAR* s, size_t len) const
+      requires IsTransparent
+    {
+      return ExistsIter(Iterator(VIEW(s, len)));
+    }
     GET operator[](const Key& key) const
       requires IsMap
     {
@@ -398,7 +934,7 @@ namespace bun {
       if(!ExistsIter(i))
         return false;
 
-      v = vals[i];
+      v = _val(i);
       return true;
     }
 
@@ -429,6 +965,7 @@ namespace bun {
       _freeall();
 
       Alloc::operator=(std::move(mov));
+      Migration::operator=(std::move(mov));
       n_buckets   = mov.n_buckets;
       flags       = mov.flags;
       keys        = mov.keys;
@@ -479,11 +1016,12 @@ namespace bun {
       }                                 // postfix
       inline HashIterator& operator--() // prefix
       {
-        std::make_unsigned_t<khiter_t> c = cur; // This is complicated because khiter_t could be signed or unsigned
-        while((--c) < src->n_buckets && !src->_exists(c))
+        std::make_unsigned_t<khiter_t> c    = cur; // This is complicated because khiter_t could be signed or unsigned
+        std::make_unsigned_t<khiter_t> back = src->Back();
+        while((--c) < back && !src->ExistsIter(c))
           ;
-        if(c > src->n_buckets)
-          c = src->n_buckets;
+        if(c > back)
+          c = back;
         cur = c;
         return *this;
       }
@@ -502,7 +1040,8 @@ namespace bun {
     protected:
       inline void _next()
       {
-        while(cur < src->n_buckets && !src->_exists(cur))
+        khiter_t back = src->Back();
+        while(cur < back && !src->ExistsIter(cur))
           ++cur;
       }
     };
@@ -535,9 +1074,36 @@ namespace bun {
       Serializer<Engine>::template ActionBind<Engine, Key>::Parse(e, key, 0);
       obj.Insert(std::move(key));
     }
-    BUN_FORCEINLINE bool _exists(khiter_t iterator) const { return !__ac_iseither(flags, iterator); }
+    BUN_FORCEINLINE bool _exists(khiter_t iterator) const
+    {
+      if constexpr(IsSwiss)
+        return !(flags[iterator] & Group::EMPTY);
+      else
+        return !__ac_iseither(flags, iterator);
+    }
+    BUN_FORCEINLINE const Key& _key(khiter_t i) const
+    {
+      if constexpr(IsIncremental)
+      {
+        if(std::make_unsigned_t<khiter_t>(i) > n_buckets)
+          return this->old_keys[i - n_buckets - 1];
+      }
+      return keys[i];
+    }
+    BUN_FORCEINLINE FakeData& _val(khiter_t i) const
+      requires IsMap
+    {
+      if constexpr(IsIncremental)
+      {
+        if(std::make_unsigned_t<khiter_t>(i) > n_buckets)
+          return this->old_vals[i - n_buckets - 1];
+      }
+      return vals[i];
+    }
     inline void _freeall()
     {
+      if constexpr(IsIncremental)
+        _dropOld();
       if(flags)
         _deallocate(flags, n_buckets);
       if(keys)
@@ -558,7 +1124,7 @@ namespace bun {
       memcpy(flags, copy.flags, n_buckets);
       for(khint_t i = 0; i < n_buckets; ++i)
       {
-        if(!__ac_iseither(copy.flags, i))
+        if(copy._exists(i))
         {
           new(keys + i) Key((const Key&)copy.keys[i]);
 
@@ -571,26 +1137,90 @@ namespace bun {
       sz          = copy.sz;
       n_occupied  = copy.n_occupied;
       upper_bound = copy.upper_bound;
+
+      if constexpr(IsIncremental)
+      {
+        // Rather than copying the migration, whatever is left in the old buckets is inserted into the new ones
+        sz -= copy.old_live;
+        for(khint_t j = copy.old_pos; copy.old_flags && j < copy.old_n; ++j)
+        {
+          if(!__ac_iseither(copy.old_flags, j))
+          {
+            int r;
+            khint_t i = _put<Key&&>(Key((const Key&)copy.old_keys[j]), &r);
+            if constexpr(IsMap)
+              new(vals + i) Data((const Data&)copy.old_vals[j]);
+          }
+        }
+      }
     }
     template<typename U, typename V> inline khiter_t _insert(U&& key, V&& value)
+    {
+      return _insert<U, V>(std::forward<U>(key), HashFunc(key), std::forward<V>(value));
+    }
+    template<typename U, typename V> inline khiter_t _insert(U&& key, khint_t h, V&& value)
     {
       int r;
-      khiter_t i = _put<const Key&>(std::forward<U>(key), &r);
+      khiter_t i = _put<const Key&>(std::forward<U>(key), h, &r);
       if(!r) // If r is 0, this key was already present, so we need to assign, not initialize
         vals[i] = std::forward<V>(value);
       else
         new(vals + i) Data(std::forward<V>(value));
       return i;
     }
+    template<class F> size_t _insertBatch(std::span<const Key> batch, std::span<khiter_t> out, F&& assign)
+    {
+      assert(out.empty() || out.size() >= batch.size());
+      khint_t used = n_occupied;
+      if constexpr(IsIncremental)
+        used += this->old_live;
+      if(used + batch.size() >= upper_bound && _resize(khint_t((sz + batch.size()) / __ac_HASH_UPPER) + 1) < 0)
+        return 0;
+
+      size_t added = 0;
+      khint_t h[BATCH];
+      for(size_t base = 0; base < batch.size(); base += BATCH)
+      {
+        size_t n = bun_min(BATCH, batch.size() - base);
+        for(size_t j = 0; j < n; ++j)
+          _prefetch<IsMap>(h[j] = HashFunc(batch[base + j]));
+        for(size_t j = 0; j < n; ++j)
+        {
+          int r;
+          khiter_t i = _put<const Key&>(batch[base + j], h[j], &r);
+          assign(base + j, i, r);
+          added += (r > 0);
+          if(!out.empty())
+            out[base + j] = i;
+        }
+      }
+      return added;
+    }
+    // Prefetches the first buckets a lookup of this hash will probe
+    template<bool VALUES> BUN_FORCEINLINE void _prefetch(khint_t h) const
+    {
+      if(!n_buckets)
+        return;
+      khint_t i = IsSwiss ? _swissStart(h, n_buckets - 1) : (h & (n_buckets - 1));
+      internal::HashPrefetch(flags + i);
+      internal::HashPrefetch(keys + i);
+      if constexpr(VALUES)
+        internal::HashPrefetch(vals + i);
+    }
     template<typename U> inline bool _setvalue(khiter_t i, U&& newvalue)
     {
       if(!ExistsIter(i))
         return false;
-      vals[i] = std::forward<U>(newvalue);
+      _val(i) = std::forward<U>(newvalue);
       return true;
     }
     char _resize(khint_t new_n_buckets)
     {
+      if constexpr(IsSwiss)
+        return _resizeSwiss(new_n_buckets);
+      if constexpr(IsIncremental)
+        Migrate();
+
       khint8_t* new_flags = 0;
       khint_t j           = 1;
       {
@@ -681,12 +1311,29 @@ namespace bun {
       return 0;
     }
 
-    template<typename U> khint_t _put(U&& key, int* ret)
+    template<typename U> BUN_FORCEINLINE khint_t _put(U&& key, int* ret)
     {
-      khint_t x;
-      if(n_occupied >= upper_bound)
+      return _put<U>(std::forward<U>(key), HashFunc(key), ret);
+    }
+    // Inserts a key whose hash is already known
+    template<typename U> khint_t _put(U&& key, khint_t h, int* ret)
+    {
+      if constexpr(IsIncremental)
+        Migrate(this->migrate_step);
+      khint_t used = n_occupied;
+      if constexpr(IsIncremental)
+        used += this->old_live; // Makes sure the keys that haven't been moved yet will still fit
+      if(used >= upper_bound)
       { /* update the hash table */
-        if(n_buckets > (sz << 1))
+        if constexpr(IsIncremental)
+        {
+          if(_beginMigration() < 0)
+          {
+            *ret = -1;
+            return n_buckets;
+          }
+        }
+        else if(n_buckets > (sz << 1))
         {
           if(_resize(n_buckets - 1) < 0)
           { /* clear "deleted" elements */
@@ -700,10 +1347,31 @@ namespace bun {
           return n_buckets;
         }
       } /* TODO: to implement automatically shrinking; resize() already support shrinking */
+      if constexpr(IsIncremental)
+      {
+        if(this->old_flags)
+        {
+          khint_t j = _find(this->old_flags, this->old_keys, this->old_n, h,
+                            [&](const Key& k) { return HashEqual(k, key); });
+          if(j != this->old_n)
+          { /* the key is still in the old buckets, so move it over now so the caller gets an index it can assign to */
+            *ret = 0;
+            return _moveOld(j);
+          }
+        }
+      }
+      if constexpr(IsSwiss)
+        return _putSwiss<U>(std::forward<U>(key), h, ret);
+      else
+        return _putKhash<U>(std::forward<U>(key), h, ret);
+    }
+    // Inserts a key into the current buckets without checking if they need to grow first
+    template<typename U> khint_t _putKhash(U&& key, khint_t k, int* ret)
+    {
+      khint_t x;
       {
-        khint_t k, i, site, last, mask = n_buckets - 1, step = 0;
+        khint_t i, site, last, mask = n_buckets - 1, step = 0;
         x = site = n_buckets;
-        k        = HashFunc(key);
         i        = k & mask;
         if(__ac_isempty(flags, i))
           x = i; /* for speed up */
@@ -749,37 +1417,341 @@ namespace bun {
         *ret = 0; /* Don't touch keys[x] if present and not deleted */
       return x;
     }
-    khint_t _get(const Key& key) const
+    BUN_FORCEINLINE khint_t _get(const Key& key) const
+    {
+      return _get(HashFunc(key), [&](const Key& k) { return HashEqual(k, key); });
+    }
+    // Finds the key with the given hash that satisfies eq(const Key&)
+    template<class F> khint_t _get(khint_t h, F&& eq) const
     {
-      if(n_buckets)
+      if constexpr(IsSwiss)
+        return _getSwiss(h, eq);
+      khint_t i = _find(flags, keys, n_buckets, h, eq);
+      if constexpr(IsIncremental)
       {
-        khint_t k, i, last, mask, step = 0;
-        mask = n_buckets - 1;
-        k    = HashFunc(key);
-        i    = k & mask;
+        if(i == n_buckets && this->old_flags)
+        {
+          khint_t j = _find(this->old_flags, this->old_keys, this->old_n, h, eq);
+          if(j != this->old_n)
+            return n_buckets + 1 + j;
+        }
+      }
+      return i;
+    }
+    // Compares borrowed characters directly against each stored key. A HashedKey already knows its hash, which rejects
+    // most mismatches without touching the characters.
+    inline khint_t _getView(khint_t h, VIEW view) const
+    {
+      return _get(h, [&](const Key& k) {
+        if constexpr(requires { k.GetHash(); })
+        {
+          if(k.GetHash() != h)
+            return false;
+        }
+        return internal::HashViewEqual<CHAR, IgnoreCase>(internal::HashKeyView<CHAR>(k), view);
+      });
+    }
+    // Searches a set of khash buckets for a key, returning n if it isn't there
+    template<class F> static khint_t _find(const khint8_t* f, const Key* k, khint_t n, khint_t h, F&& eq)
+    {
+      if(n)
+      {
+        khint_t i, last, mask, step = 0;
+        mask = n - 1;
+        i    = h & mask;
         last = i;
-        while(!__ac_isempty(flags, i) && (__ac_isdel(flags, i) || !HashEqual(keys[i], key)))
+        while(!__ac_isempty(f, i) && (__ac_isdel(f, i) || !eq(k[i])))
         {
           i = (i + (++step)) & mask;
           if(i == last)
-            return n_buckets;
+            return n;
         }
-        return __ac_iseither(flags, i) ? n_buckets : i;
+        return __ac_iseither(f, i) ? n : i;
       }
       else
         return 0;
     }
+    // Starts moving every key into a new set of buckets. If the table is empty there's nothing to spread out, so it's
+    // resized immediately instead. If the step was too small to finish the last migration before the new buckets filled
+    // up, the rest of it happens all at once here.
+    char _beginMigration()
+      requires IsIncremental
+    {
+      Migrate();
+      khint_t new_n_buckets = n_buckets > (sz << 1) ? n_buckets - 1 : n_buckets + 1; /* clear deleted or expand */
+      kroundup32(new_n_buckets);
+      if(new_n_buckets < 4)
+        new_n_buckets = 32;
+      if(!sz || sz >= (khint_t)(new_n_buckets * __ac_HASH_UPPER + 0.5))
+        return _resize(new_n_buckets);
+
+      khint8_t* new_flags = _allocate<khint8_t>(new_n_buckets);
+      Key* new_keys       = _allocate<Key>(new_n_buckets);
+      Data* new_vals      = nullptr;
+      if constexpr(IsMap)
+        new_vals = _allocate<Data>(new_n_buckets);
+      if(!new_flags || !new_keys || (IsMap && !new_vals))
+      {
+        if(new_flags)
+          _deallocate(new_flags, new_n_buckets);
+        if(new_keys)
+          _deallocate(new_keys, new_n_buckets);
+        if constexpr(IsMap)
+        {
+          if(new_vals)
+            _deallocate(new_vals, new_n_buckets);
+        }
+        return -1;
+      }
+
+      memset(new_flags, 2, new_n_buckets);
+      this->old_flags = flags;
+      this->old_keys  = keys;
+      this->old_vals  = vals;
+      this->old_n     = n_buckets;
+      this->old_pos   = 0;
+      this->old_live  = sz;
+      flags           = new_flags;
+      keys            = new_keys;
+      vals            = new_vals;
+      n_buckets       = new_n_buckets;
+      n_occupied      = 0;
+      upper_bound     = (khint_t)(n_buckets * __ac_HASH_UPPER + 0.5);
+      return 0;
+    }
+    // Moves a key from the old buckets into the new ones and returns its new index
+    khint_t _moveOld(khint_t j)
+      requires IsIncremental
+    {
+      int r;
+      khint_t i = _putKhash<Key&&>(std::move(this->old_keys[j]), HashFunc(this->old_keys[j]), &r);
+      assert(r > 0);
+      this->old_keys[j].~Key();
+      if constexpr(IsMap)
+      {
+        new(vals + i) Data(std::move(this->old_vals[j]));
+        this->old_vals[j].~Data();
+      }
+      __ac_set_isdel_true(this->old_flags, j);
+      --this->old_live;
+      --sz; // The key was counted again when it was put in the new buckets
+      return i;
+    }
+    inline void _freeOld()
+      requires IsIncremental
+    {
+      _deallocate(this->old_flags, this->old_n);
+      _deallocate(this->old_keys, this->old_n);
+      if constexpr(IsMap)
+        _deallocate(this->old_vals, this->old_n);
+      this->old_flags = 0;
+      this->old_keys  = 0;
+      this->old_vals  = 0;
+      this->old_n     = 0;
+      this->old_pos   = 0;
+      this->old_live  = 0;
+    }
+    // Destroys every key still in the old buckets and frees them
+    inline void _dropOld()
+      requires IsIncremental
+    {
+      if(!this->old_flags)
+        return;
+      for(khint_t j = this->old_pos; j < this->old_n; ++j)
+      {
+        if(!__ac_iseither(this->old_flags, j))
+        {
+          this->old_keys[j].~Key();
+          if constexpr(IsMap)
+            this->old_vals[j].~Data();
+          --sz;
+        }
+      }
+      _freeOld();
+    }
+    inline bool _remove(khiter_t iterator)
+    {
+      if(n_buckets == iterator) // This isn't ExistsIter because _get will return n_buckets if key doesn't exist
+        return false;
+
+      _delete(iterator);
+      if constexpr(IsIncremental)
+        Migrate(this->migrate_step);
+      return true;
+    }
     inline void _delete(khint_t x)
     {
-      if(x != n_buckets && !__ac_iseither(flags, x))
+      if constexpr(IsIncremental)
+      {
+        if(x > n_buckets)
+        {
+          if(ExistsIter(x))
+          {
+            khint_t j = x - n_buckets - 1;
+            this->old_keys[j].~Key();
+            if constexpr(IsMap)
+              this->old_vals[j].~Data();
+            __ac_set_isdel_true(this->old_flags, j);
+            --this->old_live;
+            --sz;
+          }
+          return;
+        }
+      }
+      if(x != n_buckets && _exists(x))
       {
         keys[x].~Key();
         if constexpr(IsMap)
           vals[x].~Data();
-        __ac_set_isdel_true(flags, x);
+        if constexpr(IsSwiss)
+        {
+          // A lookup only moves past a group that has no empty buckets, so if this group still has one, no key can be
+          // stored past it on a probe sequence that went through here, and the bucket can be marked empty again.
+          if(Group::MatchEmpty(flags + (x & ~(Group::SIZE - 1))))
+          {
+            flags[x] = Group::EMPTY;
+            --n_occupied;
+          }
+          else
+            flags[x] = Group::DELETED;
+        }
+        else
+          __ac_set_isdel_true(flags, x);
         --sz;
       }
     }
+
+    BUN_FORCEINLINE static khint_t _swissBound(khint_t buckets) { return buckets - (buckets >> 3); }
+    // Returns the first group to probe for a hash. Groups are always aligned to a multiple of 16 buckets.
+    BUN_FORCEINLINE static khint_t _swissStart(khint_t h, khint_t mask) { return (h >> 7) & mask & ~(Group::SIZE - 1); }
+    // Moves to the next group using triangular probing over groups, which visits every group once
+    BUN_FORCEINLINE static khint_t _swissNext(khint_t pos, khint_t& step, khint_t mask)
+    {
+      return (pos + (++step) * Group::SIZE) & mask;
+    }
+    template<class F> khint_t _getSwiss(khint_t h, F&& eq) const
+    {
+      if(!n_buckets)
+        return 0;
+
+      khint_t mask = n_buckets - 1;
+      khint_t pos  = _swissStart(h, mask);
+      khint8_t h2  = khint8_t(h & 0x7F);
+      for(khint_t step = 0; step * Group::SIZE < n_buckets;)
+      {
+        for(uint32_t m = Group::Match(flags + pos, h2); m; m &= m - 1)
+        {
+          khint_t i = pos + std::countr_zero(m);
+          if(eq(keys[i]))
+            return i;
+        }
+        if(Group::MatchEmpty(flags + pos))
+          break;
+        pos = _swissNext(pos, step, mask);
+      }
+      return n_buckets;
+    }
+    template<typename U> khint_t _putSwiss(U&& key, khint_t h, int* ret)
+    {
+      khint_t mask = n_buckets - 1;
+      khint_t pos  = _swissStart(h, mask);
+      khint_t site = n_buckets;
+      khint8_t h2  = khint8_t(h & 0x7F);
+      for(khint_t step = 0; step * Group::SIZE < n_buckets;)
+      {
+        for(uint32_t m = Group::Match(flags + pos, h2); m; m &= m - 1)
+        {
+          khint_t i = pos + std::countr_zero(m);
+          if(HashEqual(keys[i], key))
+          {
+            *ret = 0; /* Don't touch keys[i] if present */
+            return i;
+          }
+        }
+        if(site == n_buckets)
+        {
+          if(uint32_t m = Group::MatchFree(flags + pos))
+            site = pos + std::countr_zero(m);
+        }
+        if(Group::MatchEmpty(flags + pos))
+          break;
+        pos = _swissNext(pos, step, mask);
+      }
+
+      assert(site != n_buckets); // The load factor guarantees there's always a free bucket
+      if(flags[site] == Group::EMPTY)
+      {
+        ++n_occupied;
+        *ret = 1;
+      }
+      else
+        *ret = 2;
+      flags[site] = h2;
+      new(keys + site) Key(std::move(key));
+      ++sz;
+      return site;
+    }
+    // Swiss tables can't be rehashed in place, so this always builds a new table and moves every key over
+    char _resizeSwiss(khint_t new_n_buckets)
+    {
+      kroundup32(new_n_buckets);
+      if(new_n_buckets < Group::SIZE)
+        new_n_buckets = Group::SIZE;
+      if(sz >= _swissBound(new_n_buckets))
+        return 0; /* requested sz is too small */
+
+      khint8_t* new_flags = _allocate<khint8_t>(new_n_buckets);
+      Key* new_keys       = _allocate<Key>(new_n_buckets);
+      Data* new_vals      = nullptr;
+      if constexpr(IsMap)
+        new_vals = _allocate<Data>(new_n_buckets);
+      if(!new_flags || !new_keys || (IsMap && !new_vals))
+      {
+        if(new_flags)
+          _deallocate(new_flags, new_n_buckets);
+        if(new_keys)
+          _deallocate(new_keys, new_n_buckets);
+        if constexpr(IsMap)
+        {
+          if(new_vals)
+            _deallocate(new_vals, new_n_buckets);
+        }
+        return -1;
+      }
+
+      memset(new_flags, Group::EMPTY, new_n_buckets);
+      khint_t mask = new_n_buckets - 1;
+      for(khint_t j = 0; j < n_buckets; ++j)
+      {
+        if(!_exists(j))
+          continue;
+
+        khint_t h    = HashFunc(keys[j]);
+        khint_t pos  = _swissStart(h, mask);
+        khint_t step = 0;
+        uint32_t m;
+        while(!(m = Group::MatchFree(new_flags + pos)))
+          pos = _swissNext(pos, step, mask);
+        khint_t i    = pos + std::countr_zero(m);
+        new_flags[i] = khint8_t(h & 0x7F);
+        new(new_keys + i) Key(std::move(keys[j]));
+        keys[j].~Key();
+        if constexpr(IsMap)
+        {
+          new(new_vals + i) Data(std::move(vals[j]));
+          vals[j].~Data();
+        }
+      }
+
+      _freeall();
+      flags       = new_flags;
+      keys        = new_keys;
+      vals        = new_vals;
+      n_buckets   = new_n_buckets;
+      n_occupied  = sz;
+      upper_bound = _swissBound(n_buckets);
+      return 0;
+    }
     template<typename T> inline T* _realloc(T* src, khint_t old, khint_t new_n) noexcept
     {
       if constexpr(std::is_trivially_copyable_v<T>)
@@ -821,6 +1793,18 @@ namespace bun {
     Data* vals;
   };
 
+  // Hash that uses the HASH_SWISS layout
+  template<class Key, class Data = void, khint_t (*HashFunc)(const Key&) = &KH_AUTO_HASH<Key, false>,
+           bool (*HashEqual)(const Key&, const Key&) = &KH_AUTO_EQUAL<Key, false>,
+           typename Alloc = StandardAllocator<std::byte>>
+  using SwissHash = Hash<Key, Data, HashFunc, HashEqual, Alloc, Key, Data, HASH_SWISS>;
+
+  // Hash that uses the HASH_INCREMENTAL layout
+  template<class Key, class Data = void, khint_t (*HashFunc)(const Key&) = &KH_AUTO_HASH<Key, false>,
+           bool (*HashEqual)(const Key&, const Key&) = &KH_AUTO_EQUAL<Key, false>,
+           typename Alloc = StandardAllocator<std::byte>>
+  using IncrementalHash = Hash<Key, Data, HashFunc, HashEqual, Alloc, Key, Data, HASH_INCREMENTAL>;
+
   // Case-insensitive hash definition
   template<typename K, typename T, typename Alloc = StandardAllocator<std::byte>>
   class BUN_COMPILER_DLLEXPORT HashIns : public Hash<K, T, &KH_AUTO_HASH<K, true>, &KH_AUTO_EQUAL<K, true>, Alloc>
@@ -0,0 +1,787 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#ifndef __HASH64_H__BUN__
+#define __HASH64_H__BUN__
+
+#include "Hash.h"
+#include <tuple>
+
+namespace bun {
+  // Standard 64-bit hashing function for Hash64. A 32-bit hash can't tell more than 2^32 buckets apart, so this keeps every
+  // bit of HashBytes, and a HashedKey is hashed from its contents because the hash it caches only has 32 bits.
+  template<typename T, bool INS = false> inline uint64_t KH_AUTO_HASH64(const T& k)
+  {
+    using C = typename internal::HashChar<T>::type;
+    if constexpr(requires { k.GetHash(); })
+    {
+      static_assert(T::IgnoreCase == INS, "A HashedKey must use the same case sensitivity as the table it's in");
+      return KH_AUTO_HASH64<typename T::KEY, INS>(k.GetKey());
+    }
+    else if constexpr(!std::is_void_v<C>)
+      return internal::HashView64<C, INS>(internal::HashKeyView<C>(k));
+    else if constexpr(is_specialization_of<T, std::tuple>::value || is_specialization_of<T, std::pair>::value ||
+                      is_specialization_of_array<T>::value)
+      return std::apply(
+        [](const auto&... e) {
+          uint64_t h = 0; // Elements are compared with ==, so they are always hashed case-sensitively
+          ((h = internal::HashMix(h ^ KH_AUTO_HASH64<std::remove_cvref_t<decltype(e)>, false>(e), 0x9E3779B97F4A7C15ULL)),
+           ...);
+          return h;
+        },
+        k);
+    else if constexpr(std::is_pointer_v<T>)
+      return internal::HashMix(reinterpret_cast<uintptr_t>(k) ^ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL);
+    else if constexpr((std::is_integral_v<T> || std::is_enum_v<T>) && sizeof(T) <= sizeof(uint64_t))
+      return internal::HashMix(static_cast<uint64_t>(k) ^ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL);
+    else if constexpr(std::has_unique_object_representations_v<T>)
+      return internal::HashBytes<false>(reinterpret_cast<const char*>(&k), sizeof(T));
+    else // Keys like floats can't be hashed by their bytes, so this falls back to the 32-bit KH_AUTO_HASH
+      return internal::HashMix(KH_AUTO_HASH<T, INS>(k) ^ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL);
+  }
+
+  namespace internal {
+    // Same as HashTransparency, but checks against the 64-bit hash
+    template<class Key, uint64_t (*HashFunc)(const Key&), bool (*HashEqual)(const Key&, const Key&)>
+    consteval int HashTransparency64()
+    {
+      if constexpr(std::is_void_v<typename HashChar<Key>::type>)
+        return -1;
+      else if constexpr(requires { Key::IgnoreCase; })
+        return (HashFunc == &KH_AUTO_HASH64<Key, Key::IgnoreCase> && HashEqual == &KH_AUTO_EQUAL<Key, Key::IgnoreCase>) ?
+                 Key::IgnoreCase :
+                 -1;
+      else if(HashFunc == &KH_AUTO_HASH64<Key, false> && HashEqual == &KH_AUTO_EQUAL<Key, false>)
+        return 0;
+      else if(HashFunc == &KH_AUTO_HASH64<Key, true> && HashEqual == &KH_AUTO_EQUAL<Key, true>)
+        return 1;
+      return -1;
+    }
+  }
+
+  // Variant of Hash with 64-bit bucket indices, sizes and hashes, for tables that outgrow the roughly 3.3 billion keys a
+  // Hash can hold. It uses the same khash flags and quadratic probing as HASH_KHASH, but the maximum load factor can be
+  // changed with SetMaxLoad() instead of always being __ac_HASH_UPPER, and growing allocates the new buckets and moves
+  // every key into them instead of rehashing in place. The flags, keys and values are each allocated with Alloc, so a
+  // HugePageAllocator (see HugeHash64) puts them on huge pages, which saves TLB misses on tables that are gigabytes in
+  // size. Iterators are 64-bit and Iterator() returns Capacity() for keys that don't exist.
+  template<class Key, class Data = void, uint64_t (*HashFunc)(const Key&) = &KH_AUTO_HASH64<Key, false>,
+           bool (*HashEqual)(const Key&, const Key&) = &KH_AUTO_EQUAL<Key, false>,
+           typename Alloc = StandardAllocator<std::byte>, typename RECURSIVE_KEY = Key, typename RECURSIVE_DATA = Data>
+  class BUN_COMPILER_DLLEXPORT BUN_EMPTY_BASES Hash64 : protected Alloc
+  {
+  public:
+    static constexpr bool IsMap = !std::is_void_v<Data>;
+    using KEY                   = Key;
+    using DATA                  = Data;
+    using FakeData              = typename std::conditional<IsMap, Data, std::byte>::type;
+    using GET                   = std::conditional_t<std::is_integral_v<FakeData> || std::is_enum_v<FakeData> ||
+                                                       std::is_pointer_v<FakeData> || std::is_member_pointer_v<FakeData>,
+                                                     FakeData, typename internal::_HashGET<FakeData>::GET>;
+    static constexpr size_t BATCH = 16; // Keys hashed and prefetched at once by FindBatch and InsertBatch
+
+    // String keys using the standard hash and equality functions can also be looked up with a VIEW of borrowed characters
+    static constexpr bool IsTransparent = internal::HashTransparency64<Key, HashFunc, HashEqual>() >= 0;
+    static constexpr bool IgnoreCase    = internal::HashTransparency64<Key, HashFunc, HashEqual>() > 0;
+    using CHAR = std::conditional_t<IsTransparent, typename internal::HashChar<Key>::type, char>;
+    using VIEW = std::basic_string_view<CHAR>;
+    template<class V> static constexpr bool IsView = IsTransparent && std::is_same_v<V, VIEW>;
+
+    Hash64(const Hash64& copy)
+      requires(is_copy_constructible_or_incomplete_v<RECURSIVE_KEY> &&
+               (!IsMap || is_copy_constructible_or_incomplete_v<RECURSIVE_DATA>))
+      :
+      Alloc(copy),
+      n_buckets(0),
+      sz(0),
+      n_occupied(0),
+      upper_bound(0),
+      max_load(copy.max_load),
+      flags(0),
+      keys(0),
+      vals(0)
+    {
+      if(copy.n_buckets > 0)
+        _docopy(copy);
+    }
+    Hash64(Hash64&& mov) :
+      Alloc(std::move(mov)),
+      n_buckets(mov.n_buckets),
+      sz(mov.sz),
+      n_occupied(mov.n_occupied),
+      upper_bound(mov.upper_bound),
+      max_load(mov.max_load),
+      flags(mov.flags),
+      keys(mov.keys),
+      vals(mov.vals)
+    {
+      mov._zero();
+    }
+    Hash64(uint64_t nbuckets, const Alloc& alloc) :
+      Alloc(alloc),
+      n_buckets(0),
+      sz(0),
+      n_occupied(0),
+      upper_bound(0),
+      max_load(__ac_HASH_UPPER),
+      flags(0),
+      keys(0),
+      vals(0)
+    {
+      if(nbuckets > 0)
+        _resize(nbuckets);
+    }
+    explicit Hash64(uint64_t nbuckets)
+      requires std::is_default_constructible_v<Alloc>
+      : n_buckets(0), sz(0), n_occupied(0), upper_bound(0), max_load(__ac_HASH_UPPER), flags(0), keys(0), vals(0)
+    {
+      if(nbuckets > 0)
+        _resize(nbuckets);
+    }
+    Hash64()
+      requires std::is_default_constructible_v<Alloc>
+      : n_buckets(0), sz(0), n_occupied(0), upper_bound(0), max_load(__ac_HASH_UPPER), flags(0), keys(0), vals(0)
+    {}
+    ~Hash64()
+    {
+      Clear();
+      _freeall();
+    }
+
+    inline uint64_t Insert(const Key& key, const FakeData& value)
+      requires IsMap
+    {
+      return _insert<const Key&, const Data&>(key, value);
+    }
+    inline uint64_t Insert(const Key& key, FakeData&& value)
+      requires IsMap
+    {
+      return _insert<const Key&, Data&&>(key, std::move(value));
+    }
+    inline uint64_t Insert(Key&& key, const FakeData& value)
+      requires IsMap
+    {
+      return _insert<Key&&, const Data&>(std::move(key), value);
+    }
+    inline uint64_t Insert(Key&& key, FakeData&& value)
+      requires IsMap
+    {
+      return _insert<Key&&, Data&&>(std::move(key), std::move(value));
+    }
+    inline uint64_t Insert(const Key& key)
+      requires(!IsMap)
+    {
+      int r;
+      return _put<const Key&>(key, HashFunc(key), &r);
+    }
+    inline uint64_t Insert(Key&& key)
+      requires(!IsMap)
+    {
+      int r;
+      uint64_t h = HashFunc(key);
+      return _put<Key&&>(std::move(key), h, &r);
+    }
+
+    // Same as Hash::FindBatch
+    inline void FindBatch(std::span<const Key> batch, std::span<uint64_t> out) const
+    {
+      assert(out.size() >= batch.size());
+      uint64_t h[BATCH];
+      for(size_t base = 0; base < batch.size(); base += BATCH)
+      {
+        size_t n = bun_min(BATCH, batch.size() - base);
+        for(size_t j = 0; j < n; ++j)
+          _prefetch<false>(h[j] = HashFunc(batch[base + j]));
+        for(size_t j = 0; j < n; ++j)
+        {
+          const Key& key = batch[base + j];
+          out[base + j]  = _find(h[j], [&](const Key& k) { return HashEqual(k, key); });
+        }
+      }
+    }
+    // Same as Hash::InsertBatch
+    inline size_t InsertBatch(std::span<const Key> batch, std::span<const FakeData> values, std::span<uint64_t> out = {})
+      requires IsMap
+    {
+      assert(values.size() >= batch.size());
+      return _insertBatch(batch, out, [&](size_t j, uint64_t i, int r) {
+        if(!r) // If r is 0, this key was already present, so we need to assign, not initialize
+          vals[i] = values[j];
+        else
+          new(vals + i) Data(values[j]);
+      });
+    }
+    inline size_t InsertBatch(std::span<const Key> batch, std::span<uint64_t> out = {})
+      requires(!IsMap)
+    {
+      return _insertBatch(batch, out, [](size_t, uint64_t, int) {});
+    }
+
+    void Clear()
+    {
+      if(flags)
+      {
+        for(uint64_t i = 0; i < n_buckets; ++i)
+        {
+          if(_exists(i))
+          {
+            keys[i].~Key();
+
+            if constexpr(IsMap)
+              vals[i].~Data();
+          }
+        }
+        memset(flags, 2, n_buckets);
+        sz = n_occupied = 0;
+      }
+    }
+    inline uint64_t Iterator(const Key& key) const
+    {
+      return _find(HashFunc(key), [&](const Key& k) { return HashEqual(k, key); });
+    }
+    // Finds a string key from borrowed characters, without constructing a Key
+    template<class V>
+      requires IsView<V>
+    inline uint64_t Iterator(const V& key) const
+    {
+      return _find(internal::HashView64<CHAR, IgnoreCase>(key), [&](const Key& k) {
+        return internal::HashViewEqual<CHAR, IgnoreCase>(internal::HashKeyView<CHAR>(k), key);
+      });
+    }
+    inline uint64_t Iterator(const CHAR* s, size_t len) const
+      requires IsTransparent
+    {
+      return Iterator(VIEW(s, len));
+    }
+    inline const Key& GetKey(uint64_t i) const { return keys[i]; }
+    inline GET GetValue(uint64_t i) const
+      requires IsMap
+    {
+      if(!ExistsIter(i))
+      {
+        if constexpr(std::is_integral<GET>::value)
+          return (GET)~0;
+        else if constexpr(std::is_enum<GET>::value) // Kept separate from the integral case because VC++ gets confused
+          return (GET)~0;
+        else if constexpr(std::is_pointer<GET>::value | std::is_member_pointer<GET>::value)
+          return nullptr;
+        else
+          return GET{ 0 };
+      }
+      if constexpr(std::is_integral_v<FakeData> || std::is_enum_v<FakeData> || std::is_pointer_v<FakeData> ||
+                   std::is_member_pointer_v<FakeData>)
+        return vals[i];
+      else
+        return internal::_HashGET<FakeData>::F(vals[i]);
+    }
+    inline GET Get(const Key& key) const
+      requires IsMap
+    {
+      return GetValue(Iterator(key));
+    }
+    template<class V>
+      requires(IsMap && IsView<V>)
+    inline GET Get(const V& key) const
+    {
+      return GetValue(Iterator(key));
+    }
+    inline GET Get(const CHAR* s, size_t len) const
+      requires(IsMap && IsTransparent)
+    {
+      return GetValue(Iterator(VIEW(s, len)));
+    }
+    inline const FakeData& Value(uint64_t i) const
+      requires IsMap
+    {
+      return vals[i];
+    }
+    inline FakeData& Value(uint64_t i)
+      requires IsMap
+    {
+      return vals[i];
+    }
+    inline FakeData* PointerValue(uint64_t i)
+      requires IsMap
+    {
+      if(!ExistsIter(i))
+        return nullptr;
+      return vals + i;
+    }
+    inline bool SetValue(uint64_t iterator, const FakeData& newvalue)
+      requires IsMap
+    {
+      return _setvalue<const Data&>(iterator, newvalue);
+    }
+    inline bool SetValue(uint64_t iterator, FakeData&& newvalue)
+      requires IsMap
+    {
+      return _setvalue<Data&&>(iterator, std::move(newvalue));
+    }
+    inline bool Set(const Key& key, const FakeData& newvalue)
+      requires IsMap
+    {
+      return _setvalue<const Data&>(Iterator(key), newvalue);
+    }
+    inline bool Set(const Key& key, FakeData&& newvalue)
+      requires IsMap
+    {
+      return _setvalue<Data&&>(Iterator(key), std::move(newvalue));
+    }
+    inline void SetCapacity(uint64_t capacity)
+    {
+      if(n_buckets < capacity)
+        _resize(capacity);
+    }
+    // Sets the fraction of buckets that can be used, including deleted buckets, before the table grows. Higher loads
+    // save memory at the cost of longer probe sequences. This is clamped between 0.1 and 0.95, and if the table is already
+    // fuller than the new load allows, it grows immediately.
+    inline void SetMaxLoad(double load)
+    {
+      max_load    = bun_max(0.1, bun_min(load, 0.95));
+      upper_bound = _bound(n_buckets);
+      if(n_buckets > 0 && n_occupied >= upper_bound)
+        _grow();
+    }
+    BUN_FORCEINLINE double GetMaxLoad() const { return max_load; }
+    inline bool Remove(const Key& key) { return RemoveIter(Iterator(key)); }
+    template<class V>
+      requires IsView<V>
+    inline bool Remove(const V& key)
+    {
+      return RemoveIter(Iterator(key));
+    }
+    inline bool Remove(const CHAR* s, size_t len)
+      requires IsTransparent
+    {
+      return RemoveIter(Iterator(VIEW(s, len)));
+    }
+    inline bool RemoveIter(uint64_t iterator)
+    {
+      if(!ExistsIter(iterator))
+        return false;
+
+      keys[iterator].~Key();
+      if constexpr(IsMap)
+        vals[iterator].~Data();
+      __ac_set_isdel_true(flags, iterator);
+      --sz;
+      return true;
+    }
+    BUN_FORCEINLINE uint64_t size() const { return sz; }
+    BUN_FORCEINLINE uint64_t Capacity() const { return n_buckets; }
+    BUN_FORCEINLINE uint64_t Front() const { return 0; }
+    BUN_FORCEINLINE uint64_t Back() const { return n_buckets; }
+    inline bool ExistsIter(uint64_t iterator) const { return iterator < n_buckets && _exists(iterator); }
+    inline bool Exists(const Key& key) const { return ExistsIter(Iterator(key)); }
+    template<class V>
+      requires IsView<V>
+    inline bool Exists(const V& key) const
+    {
+      return ExistsIter(Iterator(key));
+    }
+    inline bool Exists(const CHAR* s, size_t len) const
+      requires IsTransparent
+    {
+      return ExistsIter(Iterator(VIEW(s, len)));
+    }
+    GET operator[](const Key& key) const
+      requires IsMap
+    {
+      return Get(key);
+    }
+    inline bool operator()(const Key& key) const { return Exists(key); }
+    inline bool operator()(const Key& key, FakeData& v) const
+      requires IsMap
+    {
+      uint64_t i = Iterator(key);
+
+      if(!ExistsIter(i))
+        return false;
+
+      v = vals[i];
+      return true;
+    }
+
+    Hash64& operator=(const Hash64& copy)
+      requires(is_copy_constructible_or_incomplete_v<RECURSIVE_KEY> &&
+               (!IsMap || is_copy_constructible_or_incomplete_v<RECURSIVE_DATA>))
+    {
+      Clear();
+      _freeall();
+      _zero();
+      max_load = copy.max_load;
+      if(copy.n_buckets > 0)
+        _docopy(copy);
+      return *this;
+    }
+
+    Hash64& operator=(Hash64&& mov)
+    {
+      Clear();
+      _freeall();
+
+      Alloc::operator=(std::move(mov));
+      n_buckets   = mov.n_buckets;
+      sz          = mov.sz;
+      n_occupied  = mov.n_occupied;
+      upper_bound = mov.upper_bound;
+      max_load    = mov.max_load;
+      flags       = mov.flags;
+      keys        = mov.keys;
+      vals        = mov.vals;
+      mov._zero();
+      return *this;
+    }
+
+    template<typename U> struct BUN_TEMPLATE_DLLEXPORT HashIterator
+    {
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type        = std::conditional_t<IsMap, std::tuple<Key, U>, Key>;
+      using difference_type   = ptrdiff_t;
+      using reference         = std::conditional_t<IsMap, std::tuple<const Key&, U&>, const Key&>;
+      using pointer           = std::conditional_t<IsMap, std::tuple<const Key*, U*>, const Key*>;
+
+      using PTR = std::conditional_t<std::is_const_v<U>, const Hash64*, Hash64*>;
+      inline HashIterator(uint64_t c, PTR s) : cur(c), src(s) { _next(); }
+      inline std::conditional_t<IsMap, std::tuple<const Key&, U&>, const Key&> operator*() const
+      {
+        if constexpr(IsMap)
+          return { src->GetKey(cur), src->Value(cur) };
+        else
+          return src->GetKey(cur);
+      }
+      inline HashIterator& operator++()
+      {
+        ++cur;
+        _next();
+        return *this;
+      } // prefix
+      inline HashIterator operator++(int)
+      {
+        HashIterator r(*this);
+        ++*this;
+        return r;
+      }                                 // postfix
+      inline HashIterator& operator--() // prefix
+      {
+        uint64_t back = src->Back();
+        while((--cur) < back && !src->ExistsIter(cur))
+          ;
+        if(cur > back)
+          cur = back;
+        return *this;
+      }
+      inline HashIterator operator--(int)
+      {
+        HashIterator r(*this);
+        --*this;
+        return r;
+      } // postfix
+      inline bool operator==(const HashIterator& _Right) const { return (cur == _Right.cur); }
+      inline bool operator!=(const HashIterator& _Right) const { return (cur != _Right.cur); }
+
+      uint64_t cur;
+      PTR src;
+
+    protected:
+      inline void _next()
+      {
+        uint64_t back = src->Back();
+        while(cur < back && !src->ExistsIter(cur))
+          ++cur;
+      }
+    };
+
+    BUN_FORCEINLINE HashIterator<const FakeData> begin() const { return HashIterator<const FakeData>(Front(), this); }
+    BUN_FORCEINLINE HashIterator<const FakeData> end() const { return HashIterator<const FakeData>(Back(), this); }
+    BUN_FORCEINLINE HashIterator<FakeData> begin() { return HashIterator<FakeData>(Front(), this); }
+    BUN_FORCEINLINE HashIterator<FakeData> end() { return HashIterator<FakeData>(Back(), this); }
+
+    using SerializerArray = std::conditional_t<IsMap, void, Key>;
+    template<typename Engine> void Serialize(Serializer<Engine>& s, const char* id)
+    {
+      if constexpr(!IsMap)
+        s.template EvaluateArray<Hash64, Key, &_serializeAdd<Engine>, size_t, nullptr>(*this, sz, id);
+      else
+        s.template EvaluateKeyValue<Hash64>(*this, [this](Serializer<Engine>& e, const char* name) {
+          Key k   = internal::serializer::FromString<Key>(name);
+          Data* v = PointerValue(Iterator(k));
+          if(!v)
+            v = PointerValue(Insert(k, Data()));
+          if(v)
+            Serializer<Engine>::template ActionBind<Data>::Parse(e, *v, name);
+        });
+    }
+
+  protected:
+    template<typename Engine> static inline void _serializeAdd(Serializer<Engine>& e, Hash64& obj, int& n)
+    {
+      Key key;
+      Serializer<Engine>::template ActionBind<Engine, Key>::Parse(e, key, 0);
+      obj.Insert(std::move(key));
+    }
+    BUN_FORCEINLINE bool _exists(uint64_t i) const { return !__ac_iseither(flags, i); }
+    BUN_FORCEINLINE uint64_t _bound(uint64_t buckets) const { return uint64_t(buckets * max_load + 0.5); }
+    inline void _zero()
+    {
+      n_buckets   = 0;
+      sz          = 0;
+      n_occupied  = 0;
+      upper_bound = 0;
+      flags       = 0;
+      keys        = 0;
+      vals        = 0;
+    }
+    inline void _freeall()
+    {
+      if(flags)
+        _deallocate(flags, n_buckets);
+      if(keys)
+        _deallocate(keys, n_buckets);
+      if constexpr(IsMap)
+      {
+        if(vals)
+          _deallocate(vals, n_buckets);
+      }
+      else
+        assert(vals == 0);
+    }
+    inline void _docopy(const Hash64& copy)
+      requires(std::is_copy_constructible_v<RECURSIVE_KEY> && (!IsMap || std::is_copy_constructible_v<RECURSIVE_DATA>))
+    {
+      if(_allocBuckets(copy.n_buckets, flags, keys, vals) < 0)
+        return;
+      n_buckets = copy.n_buckets;
+      memcpy(flags, copy.flags, n_buckets);
+      for(uint64_t i = 0; i < n_buckets; ++i)
+      {
+        if(copy._exists(i))
+        {
+          new(keys + i) Key((const Key&)copy.keys[i]);
+
+          if constexpr(IsMap)
+            new(vals + i) Data((const Data&)copy.vals[i]);
+        }
+      }
+      sz          = copy.sz;
+      n_occupied  = copy.n_occupied;
+      upper_bound = copy.upper_bound;
+    }
+    template<typename U, typename V> inline uint64_t _insert(U&& key, V&& value)
+    {
+      int r;
+      uint64_t h = HashFunc(key);
+      uint64_t i = _put<U>(std::forward<U>(key), h, &r);
+      if(r == -1)
+        return n_buckets;
+      if(!r) // If r is 0, this key was already present, so we need to assign, not initialize
+        vals[i] = std::forward<V>(value);
+      else
+        new(vals + i) Data(std::forward<V>(value));
+      return i;
+    }
+    template<class F> size_t _insertBatch(std::span<const Key> batch, std::span<uint64_t> out, F&& assign)
+    {
+      assert(out.empty() || out.size() >= batch.size());
+      size_t added = 0;
+      if(n_occupied + batch.size() >= upper_bound && _resize(uint64_t((sz + batch.size()) / max_load) + 1) < 0)
+        return 0;
+
+      uint64_t h[BATCH];
+      for(size_t base = 0; base < batch.size(); base += BATCH)
+      {
+        size_t n = bun_min(BATCH, batch.size() - base);
+        for(size_t j = 0; j < n; ++j)
+          _prefetch<IsMap>(h[j] = HashFunc(batch[base + j]));
+        for(size_t j = 0; j < n; ++j)
+        {
+          int r;
+          uint64_t i = _put<const Key&>(batch[base + j], h[j], &r);
+          if(r < 0)
+            return added;
+          assign(base + j, i, r);
+          added += (r != 0);
+          if(!out.empty())
+            out[base + j] = i;
+        }
+      }
+      return added;
+    }
+    template<bool VALUES> BUN_FORCEINLINE void _prefetch(uint64_t h) const
+    {
+      if(!n_buckets)
+        return;
+      uint64_t i = h & (n_buckets - 1);
+      internal::HashPrefetch(flags + i);
+      internal::HashPrefetch(keys + i);
+      if constexpr(VALUES)
+        internal::HashPrefetch(vals + i);
+    }
+    template<typename U> inline bool _setvalue(uint64_t i, U&& newvalue)
+    {
+      if(!ExistsIter(i))
+        return false;
+      vals[i] = std::forward<U>(newvalue);
+      return true;
+    }
+    // Called when the used buckets reach the upper bound. If most of them are deleted, the table is rebuilt at the same
+    // size to clear them out, otherwise it doubles. Unlike khash, this can't just check if the table is less than half
+    // full, because with a maximum load below 0.5 that's always true.
+    inline char _grow() { return _resize(sz <= (upper_bound >> 1) ? n_buckets : (n_buckets << 1)); }
+    inline char _allocBuckets(uint64_t n, khint8_t*& f, Key*& k, Data*& v)
+    {
+      f = _allocate<khint8_t>(n);
+      k = _allocate<Key>(n);
+      v = 0;
+      if constexpr(IsMap)
+        v = _allocate<Data>(n);
+      if(!f || !k || (IsMap && !v))
+      {
+        if(f)
+          _deallocate(f, n);
+        if(k)
+          _deallocate(k, n);
+        if constexpr(IsMap)
+        {
+          if(v)
+            _deallocate(v, n);
+        }
+        return -1;
+      }
+      memset(f, 2, n);
+      return 0;
+    }
+    char _resize(uint64_t new_n_buckets)
+    {
+      new_n_buckets = std::bit_ceil(bun_max(new_n_buckets, (uint64_t)32));
+      while(sz >= _bound(new_n_buckets))
+        new_n_buckets <<= 1;
+
+      khint8_t* new_flags;
+      Key* new_keys;
+      Data* new_vals;
+      if(_allocBuckets(new_n_buckets, new_flags, new_keys, new_vals) < 0)
+        return -1;
+
+      uint64_t mask = new_n_buckets - 1;
+      for(uint64_t j = 0; j < n_buckets; ++j)
+      {
+        if(!_exists(j))
+          continue;
+        uint64_t i = HashFunc(keys[j]) & mask;
+        for(uint64_t step = 0; !__ac_isempty(new_flags, i);)
+          i = (i + (++step)) & mask;
+        __ac_set_isboth_false(new_flags, i);
+        new(new_keys + i) Key(std::move(keys[j]));
+        keys[j].~Key();
+        if constexpr(IsMap)
+        {
+          new(new_vals + i) Data(std::move(vals[j]));
+          vals[j].~Data();
+        }
+      }
+
+      _freeall();
+      flags       = new_flags;
+      keys        = new_keys;
+      vals        = new_vals;
+      n_buckets   = new_n_buckets;
+      n_occupied  = sz;
+      upper_bound = _bound(n_buckets);
+      return 0;
+    }
+    // Inserts a key whose hash is already known
+    template<typename U> uint64_t _put(U&& key, uint64_t h, int* ret)
+    {
+      if(n_occupied >= upper_bound && _grow() < 0)
+      {
+        *ret = -1;
+        return n_buckets;
+      }
+
+      uint64_t x, i, site, last, mask = n_buckets - 1, step = 0;
+      x = site = n_buckets;
+      i        = h & mask;
+      if(__ac_isempty(flags, i))
+        x = i; /* for speed up */
+      else
+      {
+        last = i;
+        while(!__ac_isempty(flags, i) && (__ac_isdel(flags, i) || !HashEqual(keys[i], key)))
+        {
+          if(__ac_isdel(flags, i))
+            site = i;
+          i = (i + (++step)) & mask;
+          if(i == last)
+          {
+            x = site;
+            break;
+          }
+        }
+        if(x == n_buckets)
+        {
+          if(__ac_isempty(flags, i) && site != n_buckets)
+            x = site;
+          else
+            x = i;
+        }
+      }
+      if(__ac_isempty(flags, x))
+      { /* not present at all */
+        new(keys + x) Key(std::forward<U>(key));
+        __ac_set_isboth_false(flags, x);
+        ++sz;
+        ++n_occupied;
+        *ret = 1;
+      }
+      else if(__ac_isdel(flags, x))
+      { /* deleted */
+        new(keys + x) Key(std::forward<U>(key));
+        __ac_set_isboth_false(flags, x);
+        ++sz;
+        *ret = 2;
+      }
+      else
+        *ret = 0; /* Don't touch keys[x] if present and not deleted */
+      return x;
+    }
+    // Finds the key with the given hash that satisfies eq(const Key&), returning n_buckets if it isn't there
+    template<class F> uint64_t _find(uint64_t h, F&& eq) const
+    {
+      if(!n_buckets)
+        return 0;
+      uint64_t i, last, mask = n_buckets - 1, step = 0;
+      i = last = h & mask;
+      while(!__ac_isempty(flags, i) && (__ac_isdel(flags, i) || !eq(keys[i])))
+      {
+        i = (i + (++step)) & mask;
+        if(i == last)
+          return n_buckets;
+      }
+      return __ac_iseither(flags, i) ? n_buckets : i;
+    }
+
+    template<typename T> inline T* _allocate(uint64_t n)
+    {
+      return reinterpret_cast<T*>(std::allocator_traits<Alloc>::allocate(*this, n * sizeof(T)));
+    }
+
+    template<typename T> inline void _deallocate(T* p, uint64_t n) noexcept
+    {
+      std::allocator_traits<Alloc>::deallocate(*this, reinterpret_cast<std::byte*>(p), n * sizeof(T));
+    }
+
+    uint64_t n_buckets, sz, n_occupied, upper_bound;
+    double max_load;
+    khint8_t* flags;
+    Key* keys;
+    Data* vals;
+  };
+
+  // Hash64 that keeps its buckets on huge pages
+  template<class Key, class Data = void, uint64_t (*HashFunc)(const Key&) = &KH_AUTO_HASH64<Key, false>,
+           bool (*HashEqual)(const Key&, const Key&) = &KH_AUTO_EQUAL<Key, false>>
+  using HugeHash64 = Hash64<Key, Data, HashFunc, HashEqual, HugePageAllocator<std::byte>>;
+}
+
+#endif
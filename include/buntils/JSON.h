@@ -6,17 +6,94 @@
 
 #include "buntils.h"
 #include "DynArray.h"
+#include "GreedyAlloc.h"
 #include "Serializer.h"
 #include "Str.h"
 #include "Variant.h"
+#include <bit>
+#include <charconv>
 #include <fstream>
 #include <istream>
+#include <memory>
 #include <ostream>
+#include <span>
 #include <sstream>
+#include <string_view>
 #include <utility>
 #include <variant>
+#include <vector>
 
 namespace bun {
+  // Reads JSON directly out of a contiguous buffer. It mimics the parts of std::istream the JSON parser uses, so the same
+  // parsing code runs on either, but every read is an inline pointer access instead of a call into the stream.
+  class JSONBufferReader
+  {
+  public:
+    JSONBufferReader(const char*& pos, const char* last) : cur(pos), end(last) {}
+    BUN_FORCEINLINE int peek() const { return (cur < end) ? static_cast<unsigned char>(*cur) : -1; }
+    BUN_FORCEINLINE int get() { return (cur < end) ? static_cast<unsigned char>(*cur++) : -1; }
+    BUN_FORCEINLINE explicit operator bool() const { return cur < end; }
+    BUN_FORCEINLINE bool operator!() const { return cur >= end; }
+    // Parses a number with std::from_chars. Like an istream, leading whitespace and a + sign are skipped, and nothing is
+    // consumed if there isn't a number to read.
+    template<typename T> JSONBufferReader& operator>>(T& obj)
+    {
+      cur           = SkipWhitespace(cur, end);
+      const char* p = (cur < end && *cur == '+') ? cur + 1 : cur;
+      auto [ptr, ec] = std::from_chars(p, end, obj);
+      if(ec != std::errc::invalid_argument)
+        cur = ptr;
+      return *this;
+    }
+
+    // Returns the first character at or after p that isn't whitespace, 16 characters at a time when SSE is available
+    static inline const char* SkipWhitespace(const char* p, const char* end)
+    {
+#ifdef BUN_SSE_ENABLED
+      const __m128i tab   = _mm_set1_epi8('\t');
+      const __m128i range = _mm_set1_epi8('\r' - '\t');
+      const __m128i space = _mm_set1_epi8(' ');
+      while(end - p >= 16)
+      {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i t = _mm_sub_epi8(x, tab); // Same set of characters as isspace: \t, \n, \v, \f, \r and space
+        __m128i w = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(t, range), t), _mm_cmpeq_epi8(x, space));
+        uint32_t m = static_cast<uint32_t>(_mm_movemask_epi8(w)) ^ 0xFFFF;
+        if(m)
+          return p + std::countr_zero(m);
+        p += 16;
+      }
+#endif
+      while(p < end && isspace(static_cast<unsigned char>(*p)))
+        ++p;
+      return p;
+    }
+
+    // Returns the first " or \ character at or after p, or end if there isn't one
+    static inline const char* FindQuote(const char* p, const char* end)
+    {
+#ifdef BUN_SSE_ENABLED
+      const __m128i quote = _mm_set1_epi8('"');
+      const __m128i slash = _mm_set1_epi8('\\');
+      while(end - p >= 16)
+      {
+        __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t m = static_cast<uint32_t>(
+          _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, slash))));
+        if(m)
+          return p + std::countr_zero(m);
+        p += 16;
+      }
+#endif
+      while(p < end && *p != '"' && *p != '\\')
+        ++p;
+      return p;
+    }
+
+    const char*& cur;
+    const char* end;
+  };
+
   class JSONEngine
   {
   public:
@@ -43,37 +120,54 @@ namespace bun {
     template<typename T> static void ParseNumber(Serializer<JSONEngine>& e, T& obj, const char* id);
     static void ParseBool(Serializer<JSONEngine>& e, bool& target, const char* id)
     {
-      std::istream& s        = *e.in;
-      static const char* val = "true";
-      int pos                = 0;
+      WithReader(e, [&](auto& s) {
+        static const char* val = "true";
+        int pos                = 0;
 
-      if(s.peek() >= '0' && s.peek() <= '9')
-      {
-        uint64_t num;
-        s >> num;
-        target = num != 0; // If it's numeric, record the value as false if 0 and true otherwise.
-        return;
-      }
-
-      while(!!s && s.peek() != ',' && s.peek() != '}' && s.peek() != ']' && s.peek() != -1 && pos < 4)
-      {
-        if(s.get() != val[pos++])
+        if(s.peek() >= '0' && s.peek() <= '9')
         {
-          target = false;
+          uint64_t num = 0;
+          s >> num;
+          target = num != 0; // If it's numeric, record the value as false if 0 and true otherwise.
           return;
         }
-      }
 
-      target = true;
+        while(!!s && s.peek() != ',' && s.peek() != '}' && s.peek() != ']' && s.peek() != -1 && pos < 4)
+        {
+          if(s.get() != val[pos++])
+          {
+            target = false;
+            return;
+          }
+        }
+
+        target = true;
+      });
     }
     template<typename F> static void ParseMany(Serializer<JSONEngine>& e, F&& f);
 
+    // Calls f with a JSONBufferReader if e is parsing from a buffer, or with its istream otherwise
+    template<typename F> static BUN_FORCEINLINE void WithReader(Serializer<JSONEngine>& e, F&& f)
+    {
+      if(e._bufcur)
+      {
+        JSONBufferReader r(e._bufcur, e._bufend);
+        f(r);
+      }
+      else
+        f(*e.in);
+    }
+
     static inline void ParseJSONEatWhitespace(std::istream& s)
     {
       while(!!s && isspace(s.peek()))
         s.get();
     }
-    static inline void ParseJSONEatCharacter(std::string& str, std::istream& src)
+    static inline void ParseJSONEatWhitespace(JSONBufferReader& s)
+    {
+      s.cur = JSONBufferReader::SkipWhitespace(s.cur, s.end);
+    }
+    template<class S> static inline void ParseJSONEatCharacter(std::string& str, S& src)
     {
       char c = src.get();
       if(c != '\\')
@@ -102,6 +196,24 @@ namespace bun {
         break;
       }
     }
+    // Reads the contents of a string up to its closing " character, which is left unread
+    static inline void ParseJSONString(std::string& str, std::istream& s)
+    {
+      while(!!s && s.peek() != '"' && s.peek() != -1)
+        ParseJSONEatCharacter(str, s);
+    }
+    static inline void ParseJSONString(std::string& str, JSONBufferReader& s)
+    {
+      for(;;) // Copies everything between escape sequences in one go
+      {
+        const char* p = JSONBufferReader::FindQuote(s.cur, s.end);
+        str.append(s.cur, p);
+        s.cur = p;
+        if(p >= s.end || *p == '"')
+          return;
+        ParseJSONEatCharacter(str, s);
+      }
+    }
     template<typename F> static inline void ParseJSONObject(Serializer<JSONEngine>& e, F f);
 
     static inline bool WriteJSONIsPretty(size_t pretty) { return (pretty & (~JSONEngine::PRETTYFLAG)) > 0; }
@@ -188,39 +300,39 @@ namespace bun {
 
   template<typename F> void JSONEngine::ParseJSONObject(Serializer<JSONEngine>& e, F f)
   {
-    std::istream& s = *e.in;
-    Str buf;
-    ParseJSONEatWhitespace(s);
-    if(!s || s.get() != '{')
-      return;
-    ParseJSONEatWhitespace(s);
-    while(!!s && s.peek() != '}' && s.peek() != -1)
-    {
-      if(!s || s.get() != '"' || s.peek() == -1)
-        continue;
+    WithReader(e, [&](auto& s) {
+      Str buf;
+      ParseJSONEatWhitespace(s);
+      if(!s || s.get() != '{')
+        return;
+      ParseJSONEatWhitespace(s);
+      while(!!s && s.peek() != '}' && s.peek() != -1)
+      {
+        if(!s || s.get() != '"' || s.peek() == -1)
+          continue;
 
-      buf.clear(); // clear buffer to hold name
-      while(!!s && s.peek() != '"' && s.peek() != -1)
-        ParseJSONEatCharacter(buf, s);
-      if(s)
-        s.get(); // eat " character
+        buf.clear(); // clear buffer to hold name
+        ParseJSONString(buf, s);
+        if(s)
+          s.get(); // eat " character
 
-      ParseJSONEatWhitespace(s);
-      if(s.get() != ':')
-        continue;
+        ParseJSONEatWhitespace(s);
+        if(s.get() != ':')
+          continue;
 
-      ParseJSONEatWhitespace(s);
-      f(e, buf.c_str());
+        ParseJSONEatWhitespace(s);
+        f(e, buf.c_str());
 
-      while(!!s && s.peek() != ',' && s.peek() != '}' && s.peek() != -1) // eat everything up to a , or } character
-        s.get();
-      if(!!s && s.peek() == ',') // Only eat comma if it's there.
-        s.get();
+        while(!!s && s.peek() != ',' && s.peek() != '}' && s.peek() != -1) // eat everything up to a , or } character
+          s.get();
+        if(!!s && s.peek() == ',') // Only eat comma if it's there.
+          s.get();
 
-      ParseJSONEatWhitespace(s);
-    }
-    if(s.peek() == '}')
-      s.get(); // eat the closing brace
+        ParseJSONEatWhitespace(s);
+      }
+      if(s.peek() == '}')
+        s.get(); // eat the closing brace
+    });
   }
 
   template<class T> inline void ParseJSONBase(Serializer<JSONEngine>& e, T& obj, std::istream& s)
@@ -234,32 +346,448 @@ namespace bun {
     Serializer<JSONEngine> e;
     e.Parse<T>(obj, s, 0);
   }
-  template<class T> inline void ParseJSON(T& obj, const char* s)
+  // Parses JSON straight out of a contiguous buffer, such as a memory mapped file, without going through an istream.
+  template<class T> inline void ParseJSON(T& obj, std::span<const char> buf)
   {
-    std::istringstream ss(s);
-    ParseJSON<T>(obj, ss);
+    Serializer<JSONEngine> e;
+    e.Parse<T>(obj, buf, 0);
   }
+  template<class T> inline void ParseJSON(T& obj, const char* s) { ParseJSON<T>(obj, std::span<const char>(s, strlen(s))); }
+  template<class T> inline void ParseJSON(T& obj, const std::string& s) { ParseJSON<T>(obj, std::span<const char>(s)); }
+
+  // Stage 1 of ParseJSONIndexed. Appends the offset of every structural character in buf to index: { } [ ] : and , plus
+  // the opening quote of each string and the first character of each number or literal, skipping anything inside a
+  // string. Works through 64 bytes at a time with AVX2 if bunGetCPUInfo() reports it, and with SSE2 otherwise.
+  BUN_DLLEXPORT void JSONStructuralIndex(std::span<const char> buf, std::vector<uint32_t>& index);
+
+  // Parses a document in two stages, the way simdjson does. Stage 1 indexes the structure of the whole buffer with SIMD,
+  // then stage 2 builds the JSONValue by jumping between the indexed characters instead of reading every byte. Returns
+  // false if the document is malformed, leaving whatever was parsed before the error in value. Trailing commas and
+  // missing values are accepted, like ParseJSON does. Buffers must be smaller than 4 GiB.
+  BUN_DLLEXPORT bool ParseJSONIndexed(JSONValue& value, std::span<const char> buf);
 
-  template<> inline void ParseJSONBase<std::string>(Serializer<JSONEngine>& e, std::string& target, std::istream& s)
+  namespace internal {
+    // The stage 1 implementations JSONStructuralIndex picks from, exposed so they can be checked against each other
+    BUN_DLLEXPORT void JSONStructuralIndexScalar(std::span<const char> buf, std::vector<uint32_t>& index);
+#ifdef BUN_SSE_ENABLED
+    BUN_DLLEXPORT void JSONStructuralIndexSSE2(std::span<const char> buf, std::vector<uint32_t>& index);
+    BUN_DLLEXPORT void JSONStructuralIndexAVX2(std::span<const char> buf, std::vector<uint32_t>& index);
+#endif
+  }
+
+  // A read-only DOM that does as little work as possible up front. Parse copies the source into an arena and then walks
+  // the structural index from JSONStructuralIndex to build a flat tape in the same arena, with one entry per value, key
+  // and container that points back into the source. Strings are only decoded and numbers only converted when they're
+  // read, and an object only builds a table of its keys the first time one is looked up, so reading a few fields out of
+  // a large payload costs little more than stage 1. Reading caches what it decodes, so a document can't be read from
+  // several threads at once. Moving it invalidates every Node taken from it and leaves the old document empty, which can
+  // only be destroyed.
+  class BUN_DLLEXPORT JSONDocument
   {
-    target.clear();
+    JSONDocument(const JSONDocument& copy)            = delete;
+    JSONDocument& operator=(const JSONDocument& copy) = delete;
 
-    if(s.peek() == ',' || s.peek() == ']' || s.peek() == '}')
-      return;
+    struct Entry
+    {
+      uint32_t offset; // Where the value starts in the source. A missing value points at the , ] or } after it.
+      uint32_t end;    // For containers, the tape index after its last child, otherwise the next structural character
+      uint32_t size;   // Number of elements, or of key/value pairs, in a container
+      uint32_t cache;  // 1 + the index of the decoded string or key table for this entry, or 0 if there isn't one yet
+    };
+
+  public:
+    class Node;
 
-    char c = s.get();
-    if(c != '"')
+    // Visits the children of an array, or the values of an object. Call Key() on a value to get its key.
+    struct Iterator
     {
-      target += c;
-      while(!!s && s.peek() != ',' && s.peek() != '}' && s.peek() != ']' && s.peek() != -1)
-        target += s.get();
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = Node;
+      using difference_type   = ptrdiff_t;
+      using reference         = Node;
+      using pointer           = void;
+
+      inline Iterator(const JSONDocument* d, uint32_t start, uint32_t skip) : doc(d), t(start), stride(skip) {}
+      inline Node operator*() const { return Node(doc, t); }
+      inline Iterator& operator++()
+      {
+        t = doc->_skip(t) + stride;
+        return *this;
+      }
+      inline Iterator operator++(int)
+      {
+        Iterator r(*this);
+        ++*this;
+        return r;
+      }
+      inline bool operator==(const Iterator& r) const { return t == r.t; }
+      inline bool operator!=(const Iterator& r) const { return t != r.t; }
+
+      const JSONDocument* doc;
+      uint32_t t;
+      uint32_t stride; // 1 for objects, which skips over the key before each value, or 0 for arrays
+    };
+
+    // A handle to a single value in a JSONDocument. A default constructed Node, or one returned for an element or key
+    // that doesn't exist, is invalid: it converts to false, is not any type, and get() returns T().
+    class BUN_DLLEXPORT Node
+    {
+    public:
+      inline Node() : _doc(nullptr), _t(0) {}
+      inline explicit operator bool() const { return _doc != nullptr; }
+      inline bool IsNull() const
+      {
+        char c = _c();
+        return c == 'n' || c == ',' || c == ']' || c == '}'; // Missing values are treated as null, like ParseJSON does
+      }
+      inline bool IsArray() const { return _c() == '['; }
+      inline bool IsObject() const { return _c() == '{'; }
+      inline bool IsNumber() const { return _c() == '-' || (_c() >= '0' && _c() <= '9'); }
+      // Matches what the same value would be stored as in a JSONValue: std::string_view for strings, bool, int64_t for
+      // integers and double for any other number.
+      template<typename T> inline bool is() const
+      {
+        if constexpr(std::is_same_v<T, std::string_view>)
+          return _c() == '"';
+        else if constexpr(std::is_same_v<T, bool>)
+          return _c() == 't' || _c() == 'f';
+        else if constexpr(std::is_integral_v<T>)
+          return IsNumber() && _doc->_integral(_t);
+        else
+          return IsNumber() && !_doc->_integral(_t);
+      }
+      // Decodes a string or converts a number the first time it's read. Any number can be read as any arithmetic type.
+      // Asking for a type the value isn't returns T().
+      template<typename T> inline T get() const
+      {
+        if constexpr(std::is_same_v<T, std::string_view>)
+          return is<std::string_view>() ? _doc->_string(_t) : std::string_view();
+        else if constexpr(std::is_same_v<T, bool>)
+          return _c() == 't';
+        else if constexpr(std::is_integral_v<T>)
+          return IsNumber() ? static_cast<T>(_doc->_int(_t)) : T();
+        else
+          return IsNumber() ? static_cast<T>(_doc->_double(_t)) : T();
+      }
+      // Number of elements in an array or key/value pairs in an object
+      inline size_t size() const { return (IsArray() || IsObject()) ? _doc->_tape[_t].size : 0; }
+      // Returns the ith element of an array or value of an object. This has to skip over every value before it, so
+      // iterate instead of indexing when visiting everything.
+      Node operator[](size_t i) const;
+      // Returns the value for a key in an object. Small objects are searched in order, larger ones build a hash table of
+      // their keys the first time this is called on them.
+      Node operator[](std::string_view key) const;
+      // Returns the key for a value found by iterating over an object
+      inline std::string_view Key() const { return _doc ? _doc->_string(_t - 1) : std::string_view(); }
+      inline Iterator begin() const
+      {
+        return IsObject() ? Iterator(_doc, _t + 2, 1) : Iterator(_doc, IsArray() ? _t + 1 : 0, 0);
+      }
+      inline Iterator end() const
+      {
+        if(IsObject())
+          return Iterator(_doc, _doc->_tape[_t].end + 1, 1);
+        return Iterator(_doc, IsArray() ? _doc->_tape[_t].end : 0, 0);
+      }
+      // Decodes this value and everything in it into a JSONValue
+      void CopyTo(JSONValue& v) const;
+
+    protected:
+      friend class JSONDocument;
+      friend struct Iterator;
+      inline Node(const JSONDocument* doc, uint32_t t) : _doc(doc), _t(t) {}
+      inline char _c() const { return _doc ? _doc->_src[_doc->_tape[_t].offset] : 0; }
+
+      const JSONDocument* _doc;
+      uint32_t _t;
+    };
+
+    inline JSONDocument() : _arena(4096, alignof(Entry)), _src(nullptr), _len(0), _tape(nullptr), _count(0) {}
+    inline JSONDocument(JSONDocument&& mov) :
+      _arena(std::move(mov._arena)),
+      _src(mov._src),
+      _len(mov._len),
+      _tape(mov._tape),
+      _count(mov._count),
+      _strings(std::move(mov._strings)),
+      _tables(std::move(mov._tables))
+    {
+      mov._src   = nullptr;
+      mov._len   = 0;
+      mov._tape  = nullptr;
+      mov._count = 0;
+    }
+    // Copies buf and builds the tape for it, replacing whatever was parsed before. Returns false if the document is
+    // malformed, which leaves it empty. Like ParseJSONIndexed, trailing commas and missing values are accepted, but a
+    // malformed number is only noticed when it's read, which returns 0. Buffers must be smaller than 4 GiB.
+    bool Parse(std::span<const char> buf);
+    inline bool Parse(const char* s) { return Parse(std::span<const char>(s, strlen(s))); }
+    inline bool Parse(const std::string& s) { return Parse(std::span<const char>(s)); }
+    // The root value, which is invalid if nothing has been parsed
+    inline Node Root() const { return _count > 0 ? Node(this, 0) : Node(); }
+    // Number of entries in the tape, counting object keys
+    inline size_t TapeSize() const { return _count; }
+
+  protected:
+    inline uint32_t _skip(uint32_t t) const
+    {
+      char c = _src[_tape[t].offset];
+      return (c == '{' || c == '[') ? _tape[t].end : t + 1;
+    }
+    std::string_view _token(uint32_t t) const;
+    bool _integral(uint32_t t) const;
+    int64_t _int(uint32_t t) const;
+    double _double(uint32_t t) const;
+    std::string_view _string(uint32_t t) const;
+    uint32_t _find(uint32_t t, std::string_view key) const;
+    bool _build(std::span<const uint32_t> index, size_t& i);
+    void _clear();
+
+    mutable GreedyAlloc _arena;
+    char* _src;
+    size_t _len;
+    Entry* _tape;
+    uint32_t _count;
+#pragma warning(push)
+#pragma warning(disable : 4251)
+    mutable std::vector<std::string_view> _strings;
+    mutable std::vector<uint32_t*> _tables;
+#pragma warning(pop)
+  };
+
+  enum class JSONEvent : uint8_t
+  {
+    NeedMore, // Every byte fed so far has been used, so Feed the next chunk, or call Finish if there isn't one
+    End,      // Finish was called and every value was complete
+    Error,    // The JSON is malformed. Every call to Next after this returns Error until Reset is called.
+    StartObject,
+    EndObject,
+    StartArray,
+    EndArray,
+    Key,
+    String,
+    Int,
+    Double,
+    Bool,
+    Null,
+  };
+
+  // A pull parser that reads JSON incrementally from chunks as they arrive, so a document never has to be in memory all at
+  // once. Call Feed with a chunk, then call Next until it returns JSONEvent::NeedMore before feeding the next one. A value
+  // split across chunks is resumed where it left off. Memory only grows with how deeply values are nested, and with the
+  // longest string or number, which has to be copied if it spans a chunk boundary. Any number of root values can follow
+  // each other, so newline-delimited JSON is just a stream of root values. Trailing commas and missing values are
+  // accepted, like ParseJSON does, and a missing value is reported as Null.
+  class BUN_DLLEXPORT JSONReader
+  {
+  public:
+    JSONReader();
+    // The chunk must stay alive until Next returns NeedMore, and can only be fed once the previous one has been used up.
+    void Feed(std::span<const char> chunk);
+    // Marks the end of the input, so a number at the end of the last chunk can be completed.
+    void Finish();
+    JSONEvent Next();
+    // The decoded text of the last Key or String event, which is only valid until the next call to Next or Feed.
+    inline std::string_view String() const { return _str; }
+    inline int64_t Int() const { return _int; }
+    // The value of the last Double event, or of the last Int event converted to a double.
+    inline double Double() const { return _double; }
+    inline bool Bool() const { return _bool; }
+    // The number of objects and arrays that are currently open
+    inline size_t Depth() const { return _stack.size(); }
+    // Forgets everything, including any error, so a new stream can be read.
+    void Reset();
+
+  protected:
+    enum STATE : uint8_t
+    {
+      STATE_ROOT,  // Expecting a root value
+      STATE_VALUE, // Expecting a value inside an object or array
+      STATE_KEY,   // Expecting a key or }
+      STATE_COLON,
+      STATE_NEXT, // Expecting a , or the end of the current object or array
+      STATE_ERROR,
+    };
+    enum TOKEN : uint8_t
+    {
+      TOKEN_NONE,
+      TOKEN_KEY,
+      TOKEN_STRING,
+      TOKEN_SCALAR,
+    };
+
+    JSONEvent _value(char c);
+    JSONEvent _string(TOKEN token);
+    JSONEvent _scalar();
+    JSONEvent _resume();
+    JSONEvent _emitString(TOKEN token, std::string_view raw, bool escaped);
+    JSONEvent _emitScalar(std::string_view s);
+    JSONEvent _close(char open);
+    JSONEvent _error();
+    const char* _findQuote(const char* p, bool& escaped);
+    const char* _endScalar(const char* p) const;
+    inline void _next() { _state = _stack.empty() ? STATE_ROOT : STATE_NEXT; }
+
+    const char* _cur;
+    const char* _end;
+    STATE _state;
+    TOKEN _token;
+    bool _finished;
+    bool _pending;  // The last byte of _partial is a backslash, so the first byte of the next chunk is escaped
+    bool _escaped;  // _partial has at least one escape sequence in it
+    bool _bool;
+    int64_t _int;
+    double _double;
+    std::string_view _str;
+#pragma warning(push)
+#pragma warning(disable : 4251)
+    std::string _stack;   // The opening character of every object or array we're inside of
+    std::string _partial; // The raw bytes of a token that spans more than one chunk
+    std::string _decoded; // Holds a string after its escape sequences have been decoded
+#pragma warning(pop)
+  };
+
+  // Reads s in chunks of the given size, calling f(reader, event) for every event until the stream ends. Returns false
+  // if the JSON is malformed, after calling f for every event before the error.
+  template<typename F> inline bool ParseJSONEvents(std::istream& s, F&& f, size_t chunk = 65536)
+  {
+    JSONReader reader;
+    std::unique_ptr<char[]> buf(new char[chunk]);
+    for(;;)
+    {
+      JSONEvent ev = reader.Next();
+      switch(ev)
+      {
+      case JSONEvent::NeedMore:
+        s.read(buf.get(), chunk);
+        if(s.gcount() > 0)
+          reader.Feed(std::span<const char>(buf.get(), static_cast<size_t>(s.gcount())));
+        else
+          reader.Finish();
+        break;
+      case JSONEvent::End: return true;
+      case JSONEvent::Error: return false;
+      default: f(reader, ev);
+      }
+    }
+  }
+
+  // The writing half of JSONReader. Events are written compactly into a buffer, with commas and colons added
+  // automatically, and the buffer is written out with a single unformatted ostream::write whenever it grows past the
+  // flush threshold. Each root value ends with a newline, so writing several root values produces newline-delimited JSON.
+  // If there is no ostream, everything stays in the buffer until Clear is called. Nothing is checked, so events must be
+  // written in a valid order.
+  class BUN_DLLEXPORT JSONWriter
+  {
+    JSONWriter(const JSONWriter& copy)            = delete;
+    JSONWriter& operator=(const JSONWriter& copy) = delete;
+
+  public:
+    explicit JSONWriter(std::ostream* out = nullptr, size_t flush = 65536);
+    inline explicit JSONWriter(std::ostream& out, size_t flush = 65536) : JSONWriter(&out, flush) {}
+    ~JSONWriter();
+    void StartObject();
+    void EndObject();
+    void StartArray();
+    void EndArray();
+    void Key(std::string_view key);
+    void String(std::string_view s);
+    void Int(int64_t i);
+    void UInt(uint64_t i);
+    // Written in the shortest form that reads back as the same double. Infinity and NaN don't exist in JSON, so they're
+    // written as null.
+    void Double(double d);
+    void Bool(bool b);
+    void Null();
+    // Writes everything in the buffer to the ostream, if there is one.
+    void Flush();
+    inline std::string_view Buffer() const { return _buf; }
+    inline void Clear() { _buf.clear(); }
+    inline size_t Depth() const { return _depth; }
+
+  protected:
+    inline void _begin()
+    {
+      if(_comma)
+        _buf += ',';
+    }
+    inline void _end()
+    {
+      _comma = _depth > 0;
+      if(!_depth)
+        _buf += '\n';
+      if(_buf.size() >= _flush)
+        Flush();
+    }
+    void _escape(std::string_view s);
+
+    std::ostream* _out;
+    size_t _flush;
+    size_t _depth;
+    bool _comma; // The next value or key needs a comma in front of it
+#pragma warning(push)
+#pragma warning(disable : 4251)
+    std::string _buf;
+#pragma warning(pop)
+  };
+
+  template<> inline void ParseJSONBase<std::string>(Serializer<JSONEngine>& e, std::string& target, std::istream&)
+  {
+    JSONEngine::WithReader(e, [&](auto& s) {
+      target.clear();
+
+      if(s.peek() == ',' || s.peek() == ']' || s.peek() == '}')
+        return;
+
+      char c = s.get();
+      if(c != '"')
+      {
+        target += c;
+        while(!!s && s.peek() != ',' && s.peek() != '}' && s.peek() != ']' && s.peek() != -1)
+          target += s.get();
+        return;
+      }
+
+      JSONEngine::ParseJSONString(target, s);
+      s.get(); // eat last " character
+    });
+  }
+  // A string_view points directly into the buffer being parsed, so no copy is made, but escape sequences are left as they
+  // were in the source. When parsing from an istream there is nothing for it to point to, so it is left empty.
+  template<>
+  inline void ParseJSONBase<std::string_view>(Serializer<JSONEngine>& e, std::string_view& target, std::istream& s)
+  {
+    target = std::string_view();
+    if(!e._bufcur)
+    {
+      std::string discard;
+      ParseJSONBase<std::string>(e, discard, s);
       return;
     }
 
-    while(!!s && s.peek() != '"' && s.peek() != -1)
-      JSONEngine::ParseJSONEatCharacter(target, s);
+    JSONBufferReader r(e._bufcur, e._bufend);
+    if(r.peek() == ',' || r.peek() == ']' || r.peek() == '}')
+      return;
+
+    const char* start = r.cur;
+    if(r.get() != '"')
+    {
+      while(!!r && r.peek() != ',' && r.peek() != '}' && r.peek() != ']')
+        r.get();
+      target = std::string_view(start, r.cur);
+      return;
+    }
 
-    s.get(); // eat last " character
+    start = r.cur;
+    for(;;) // Skip to the closing quote, stepping over anything escaped
+    {
+      r.cur = JSONBufferReader::FindQuote(r.cur, r.end);
+      if(r.cur >= r.end || *r.cur == '"')
+        break;
+      r.cur = bun_min(r.cur + 2, r.end);
+    }
+    target = std::string_view(start, r.cur);
+    r.get(); // eat last " character
   }
   template<> inline void ParseJSONBase<Str>(Serializer<JSONEngine>& e, Str& target, std::istream& s)
   {
@@ -268,8 +796,12 @@ namespace bun {
 
   template<> inline void ParseJSONBase<JSONValue>(Serializer<JSONEngine>& e, JSONValue& target, std::istream& s)
   {
-    JSONEngine::ParseJSONEatWhitespace(s);
-    switch(s.peek())
+    int c;
+    JSONEngine::WithReader(e, [&](auto& r) {
+      JSONEngine::ParseJSONEatWhitespace(r);
+      c = r.peek();
+    });
+    switch(c)
     {
     case '{':
       target = JSONValue::JSONObject();
@@ -332,43 +864,46 @@ namespace bun {
            bool (*Read)(Serializer<JSONEngine>& e, T& obj, int64_t count)>
   void JSONEngine::ParseArray(Serializer<JSONEngine>& e, T& obj, const char* id)
   {
-    std::istream& s = *e.in;
-    ParseJSONEatWhitespace(s);
+    auto add = Add; // Naming Add inside the lambda trips GCC's access checks when it is a protected member
+    WithReader(e, [&](auto& s) {
+      ParseJSONEatWhitespace(s);
 
-    if(!s || s.get() != '[')
-      return;
+      if(!s || s.get() != '[')
+        return;
 
-    ParseJSONEatWhitespace(s);
-    int n = 0;
+      ParseJSONEatWhitespace(s);
+      int n = 0;
 
-    while(!!s && s.peek() != ']' && s.peek() != -1)
-    {
-      Add(e, obj, n);
-      while(!!s && s.peek() != ',' && s.peek() != ']' && s.peek() != -1) // eat everything up to a , or ] character
-        s.get();
-      if(!!s && s.peek() == ',' && s.peek() != -1) // Only eat comma if it's there.
+      while(!!s && s.peek() != ']' && s.peek() != -1)
+      {
+        add(e, obj, n);
+        while(!!s && s.peek() != ',' && s.peek() != ']' && s.peek() != -1) // eat everything up to a , or ] character
+          s.get();
+        if(!!s && s.peek() == ',' && s.peek() != -1) // Only eat comma if it's there.
+          s.get();
+        ParseJSONEatWhitespace(s);
+      }
+      if(s.peek() == ']')
         s.get();
-      ParseJSONEatWhitespace(s);
-    }
-    if(s.peek() == ']')
-      s.get();
+    });
   }
   template<typename T> void JSONEngine::ParseNumber(Serializer<JSONEngine>& e, T& obj, const char* id)
   {
-    std::istream& s = *e.in;
-    if(s.peek() == ',' || s.peek() == ']' || s.peek() == '}')
-      return;
+    WithReader(e, [&](auto& s) {
+      if(s.peek() == ',' || s.peek() == ']' || s.peek() == '}')
+        return;
 
-    if(s.peek() == '"') // if true, we have to attempt to coerce the string to T
-    {
-      s.get();
-      s >> obj; // grab whatever we can
-      while(!!s && s.peek() != -1 && s.get() != '"')
-        ;      // eat the rest of the string
-      s.get(); // eat the " character
-    }
-    else
-      s >> obj;
+      if(s.peek() == '"') // if true, we have to attempt to coerce the string to T
+      {
+        s.get();
+        s >> obj; // grab whatever we can
+        while(!!s && s.peek() != -1 && s.get() != '"')
+          ;      // eat the rest of the string
+        s.get(); // eat the " character
+      }
+      else
+        s >> obj;
+    });
   }
 
   template<class T>
@@ -410,7 +945,8 @@ namespace bun {
   }
 
   template<>
-  inline void WriteJSONBase<std::string>(Serializer<JSONEngine>& e, const char* id, const std::string& obj, std::ostream& s)
+  inline void WriteJSONBase<std::string_view>(Serializer<JSONEngine>& e, const char* id, const std::string_view& obj,
+                                              std::ostream& s)
   {
     JSONEngine::WriteJSONComma(s, e.engine.pretty);
     JSONEngine::WriteJSONId(id, s, e.engine.pretty);
@@ -435,6 +971,12 @@ namespace bun {
     s << '"';
   }
 
+  template<>
+  inline void WriteJSONBase<std::string>(Serializer<JSONEngine>& e, const char* id, const std::string& obj, std::ostream& s)
+  {
+    WriteJSONBase<std::string_view>(e, id, obj, s);
+  }
+
   template<> inline void WriteJSONBase<Str>(Serializer<JSONEngine>& e, const char* id, const Str& obj, std::ostream& s)
   {
     WriteJSONBase<std::string>(e, id, obj, s);
@@ -512,7 +1054,15 @@ namespace bun {
   {
     WriteJSONComma(*e.out, e.engine.pretty);
     WriteJSONId(id, *e.out, e.engine.pretty);
-    (*e.out) << obj;
+    if constexpr(std::is_floating_point_v<T>)
+    {
+      if(!std::isfinite(obj)) // JSON has no infinity or NaN
+      {
+        e.out->write("null", 4);
+        return;
+      }
+    }
+    WriteNumber<T>(*e.out, obj);
   }
 
   template<typename T> void JSONEngine::Serialize(Serializer<JSONEngine>& e, const T& obj, const char* id)
@@ -233,64 +233,298 @@ namespace bun {
     alignas(64) std::atomic_flag _pflag;
   };
 
-  // Multi-producer Multi-consumer lockless queue using a multithreaded allocator
-  /*template<typename T, typename LENGTH = void>
-  class MicroLockQueue : public internal::LocklessQueue_Length<LENGTH>
+  namespace internal {
+    template<typename T> struct RQ_Slot
+    {
+      std::atomic<size_t> seq;
+      alignas(T) std::byte item[sizeof(T)];
+    };
+  }
+
+  // Bounded multi-producer multi-consumer lockless queue backed by a fixed ring of slots, based on Dmitry Vyukov's bounded
+  // MPMC queue. Each slot has a sequence number that tells a producer or consumer whether the slot is ready for it on the
+  // current lap around the ring, so threads only contend on a single CAS of the head or tail and nothing is allocated per
+  // element. The capacity is rounded up to a power of two. TryPush fails if the queue is full, TryPop fails if it's empty.
+  template<typename T, typename Alloc = StandardAllocator<internal::RQ_Slot<T>>> class RingQueue : Alloc
   {
+    using SLOT                             = internal::RQ_Slot<T>;
+    RingQueue(const RingQueue&)            = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
   public:
-    MicroLockQueue(const MicroLockQueue&) = delete;
-    MicroLockQueue(MicroLockQueue&& mov) : internal::LocklessQueue_Length<LENGTH>(std::move(mov)), _div(mov._div),
-  _last(mov._last), _alloc(std::move(mov._alloc)) { mov._div=mov._last=0; } inline MicroLockQueue() { _last.store(_div.p =
-  _alloc.Alloc(1), std::memory_order_relaxed); new(_div.p) QNODE(); assert(_last.is_lock_free());} inline ~MicroLockQueue()
-  { } // Don't need to clean up because the allocator will destroy everything by itself BUN_FORCEINLINE void Push(const T&
-  item) { _produce<const T&>(item); } BUN_FORCEINLINE void Push(T&& item) { _produce<T&&>(std::move(item)); } inline bool
-  Pop(T& result)
-    {
-      bun_PTag<QNODE> ref ={0, 0};
-      bun_PTag<QNODE> nval;
-      asmcasr<bun_PTag<QNODE>>(&_div, ref, ref, ref);
-      while(ref.p != _last.load(std::memory_order_relaxed))
+    inline RingQueue(size_t capacity, const Alloc& alloc) : Alloc(alloc) { _init(capacity); }
+    inline explicit RingQueue(size_t capacity)
+      requires std::is_default_constructible_v<Alloc>
+    {
+      _init(capacity);
+    }
+    inline ~RingQueue()
+    {
+      for(size_t pos = _head.load(std::memory_order_relaxed);; ++pos)
       {
-        nval.p = ref.p->next; // This can fail because if there are two consumers ahead of this one, one can increment the
-  pointer, then another can increment the pointer and is then legally allowed to destroy that pointer, leaving this thread
-  with an invalid ref.p->next value. nval.tag = ref.tag+1; if(!asmcasr<bun_PTag<QNODE>>(&_div, nval, ref, ref)) continue;
-        result = std::move(ref.p->item); 	// try to use move semantics if possible
-        ref.p->~QNODE(); // We have to let item clean itself up
-        _alloc.Dealloc(ref.p);
-        internal::LocklessQueue_Length<LENGTH>::_decLength(); // Decrement length if we're tracking it
-        return true;
+        SLOT& slot = _slots[pos & _mask];
+        if(slot.seq.load(std::memory_order_relaxed) != pos + 1)
+          break;
+        std::launder(reinterpret_cast<T*>(slot.item))->~T();
       }
-      return false;
+      std::allocator_traits<Alloc>::deallocate(*this, _slots, _mask + 1);
+    }
+    BUN_FORCEINLINE bool TryPush(const T& item) { return _produce<const T&>(item); }
+    BUN_FORCEINLINE bool TryPush(T&& item) { return _produce<T&&>(std::move(item)); }
+    inline bool TryPop(T& result)
+    {
+      size_t pos = _head.load(std::memory_order_relaxed);
+      SLOT* slot;
+      for(;;)
+      {
+        slot          = &_slots[pos & _mask];
+        size_t seq    = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if(!diff)
+        {
+          if(_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if(diff < 0)
+          return false; // The slot hasn't been filled for this lap yet, so the queue is empty
+        else
+          pos = _head.load(std::memory_order_relaxed);
+      }
+
+      _consume(slot, pos, result);
+      return true;
     }
 
-    MicroLockQueue& operator=(const MicroLockQueue&) = delete;
-    inline MicroLockQueue& operator=(MicroLockQueue&& mov)
+    // Pushes as many items as will fit, up to count, with a single CAS on the tail. Returns the number of items pushed,
+    // which are always the first ones in the list.
+    template<typename It> inline size_t TryPushBatch(It items, size_t count)
     {
-        _div=mov._div;
-        _last=mov._last;
-        _alloc=std::move(mov._alloc);
-        mov._div=mov._last=0;
-        internal::LocklessQueue_Length<LENGTH>::operator=(std::move(mov));
+      size_t pos = _tail.load(std::memory_order_relaxed);
+      size_t n;
+      do
+      {
+        // A slot that is ready for this lap can only be claimed by whoever advances the tail past it, so if our CAS from
+        // pos succeeds, every slot we checked is still ours to fill.
+        for(n = 0; n < count && n <= _mask; ++n)
+          if(_slots[(pos + n) & _mask].seq.load(std::memory_order_acquire) != pos + n)
+            break;
+        if(!n)
+          return 0;
+      } while(!_tail.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed));
+
+      for(size_t i = 0; i < n; ++i, ++items)
+      {
+        SLOT* slot = &_slots[(pos + i) & _mask];
+        new(slot->item) T(*items);
+        slot->seq.store(pos + i + 1, std::memory_order_release);
+      }
+      return n;
+    }
+    BUN_FORCEINLINE size_t TryPushBatch(std::span<const T> items) { return TryPushBatch(items.data(), items.size()); }
+
+    // Pops up to count items into out with a single CAS on the head, returning the number of items popped.
+    inline size_t TryPopBatch(T* out, size_t count)
+    {
+      size_t pos = _head.load(std::memory_order_relaxed);
+      size_t n;
+      do
+      {
+        for(n = 0; n < count && n <= _mask; ++n)
+          if(_slots[(pos + n) & _mask].seq.load(std::memory_order_acquire) != pos + n + 1)
+            break;
+        if(!n)
+          return 0;
+      } while(!_head.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed));
+
+      for(size_t i = 0; i < n; ++i)
+        _consume(&_slots[(pos + i) & _mask], pos + i, out[i]);
+      return n;
+    }
+    BUN_FORCEINLINE size_t TryPopBatch(std::span<T> out) { return TryPopBatch(out.data(), out.size()); }
+
+    inline bool Peek() const
+    {
+      size_t pos = _head.load(std::memory_order_relaxed);
+      return _slots[pos & _mask].seq.load(std::memory_order_acquire) == pos + 1;
+    }
+    // Only an estimate if other threads are pushing or popping
+    inline size_t size() const
+    {
+      size_t head = _head.load(std::memory_order_relaxed);
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      return (tail > head) ? bun_min(tail - head, _mask + 1) : 0;
     }
+    inline size_t Capacity() const { return _mask + 1; }
+
   protected:
-    template<typename U>
-    void _produce(U && t)
+    inline void _init(size_t capacity)
+    {
+      capacity = NextPow2((uint64_t)bun_max(capacity, (size_t)2));
+      _mask    = capacity - 1;
+      _slots   = std::allocator_traits<Alloc>::allocate(*this, capacity);
+      for(size_t i = 0; i < capacity; ++i)
+        new(&_slots[i].seq) std::atomic<size_t>(i);
+      _head.store(0, std::memory_order_relaxed);
+      _tail.store(0, std::memory_order_relaxed);
+    }
+    template<typename U> inline bool _produce(U&& item)
     {
-      QNODE* nval = _alloc.Alloc(1);
-      new(nval) QNODE();
+      size_t pos = _tail.load(std::memory_order_relaxed);
+      SLOT* slot;
+      for(;;)
+      {
+        slot          = &_slots[pos & _mask];
+        size_t seq    = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if(!diff)
+        {
+          if(_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if(diff < 0)
+          return false; // The slot still holds an item from the previous lap, so the queue is full
+        else
+          pos = _tail.load(std::memory_order_relaxed);
+      }
 
-      while(!asmcas<QNODE*>(&_last.load(std::memory_order_relaxed)->next, nval, 0)); //This doesn't work because of a race
-  condition where this thread loads _last, then another producer pushes through a new _last and a consume thread then
-  destroys the _last we just loaded, and we end up writing to an undefined location.
-      _last.load(std::memory_order_relaxed)->item=std::forward<U>(t);
-      _last.store(nval, std::memory_order_release);
-      internal::LocklessQueue_Length<LENGTH>::_incLength(); // If we are tracking length, atomically increment it
+      new(slot->item) T(std::forward<U>(item));
+      slot->seq.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+    BUN_FORCEINLINE void _consume(SLOT* slot, size_t pos, T& result)
+    {
+      T* item = std::launder(reinterpret_cast<T*>(slot->item));
+      result  = std::move(*item);
+      item->~T();
+      slot->seq.store(pos + _mask + 1, std::memory_order_release); // Mark the slot as free for the next lap
     }
 
-    LocklessBlockAlloc<QNODE> _alloc;
-    alignas(64) bun_PTag<QNODE> _div; // Align to try and get them on different cache lines
-    alignas(64) std::atomic<QNODE*> _last;
-  };*/
+    SLOT* _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _head; // Keep the head and tail on separate cache lines from each other and the slots
+    alignas(64) std::atomic<size_t> _tail;
+  };
+
+  // Bounded single-producer single-consumer queue backed by a fixed ring. The producer and consumer each keep a cached copy
+  // of the other side's index and only reload it when the ring looks full or empty, so in the common case neither side
+  // touches the other's cache line. Every slot always holds a constructed T, which lets the batch functions hand out
+  // spans of the ring directly: Reserve() returns free slots to write into before calling Commit(), and Peek() returns
+  // items to read before calling Release(). The capacity is rounded up to a power of two.
+  template<typename T, typename Alloc = StandardAllocator<T>>
+    requires std::is_default_constructible_v<T>
+  class SPSCRingQueue : Alloc
+  {
+    SPSCRingQueue(const SPSCRingQueue&)            = delete;
+    SPSCRingQueue& operator=(const SPSCRingQueue&) = delete;
+
+  public:
+    inline SPSCRingQueue(size_t capacity, const Alloc& alloc) : Alloc(alloc) { _init(capacity); }
+    inline explicit SPSCRingQueue(size_t capacity)
+      requires std::is_default_constructible_v<Alloc>
+    {
+      _init(capacity);
+    }
+    inline ~SPSCRingQueue()
+    {
+      for(size_t i = 0; i <= _mask; ++i)
+        _ring[i].~T();
+      std::allocator_traits<Alloc>::deallocate(*this, _ring, _mask + 1);
+    }
+
+    // Producer functions
+    BUN_FORCEINLINE bool TryPush(const T& item) { return _produce<const T&>(item); }
+    BUN_FORCEINLINE bool TryPush(T&& item) { return _produce<T&&>(std::move(item)); }
+    // Returns up to count contiguous free slots. The span can be shorter than count if the ring is almost full or wraps
+    // around, and is empty if the ring is full.
+    inline std::span<T> Reserve(size_t count)
+    {
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      size_t free = _mask + 1 - (tail - _headcache);
+      if(free < count)
+      {
+        _headcache = _head.load(std::memory_order_acquire);
+        free       = _mask + 1 - (tail - _headcache);
+      }
+      size_t i = tail & _mask;
+      return std::span<T>(_ring + i, bun_min(bun_min(count, free), _mask + 1 - i));
+    }
+    // Publishes the first count slots returned by Reserve()
+    BUN_FORCEINLINE void Commit(size_t count)
+    {
+      _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Consumer functions
+    inline bool TryPop(T& result)
+    {
+      size_t head = _head.load(std::memory_order_relaxed);
+      if(head == _tailcache)
+      {
+        _tailcache = _tail.load(std::memory_order_acquire);
+        if(head == _tailcache)
+          return false;
+      }
+      result = std::move(_ring[head & _mask]);
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+    // Returns up to count contiguous items at the front of the queue without removing them. The span can be shorter than
+    // count if there aren't enough items or the ring wraps around.
+    inline std::span<T> Peek(size_t count = ~size_t(0))
+    {
+      size_t head  = _head.load(std::memory_order_relaxed);
+      size_t avail = _tailcache - head;
+      if(avail < count)
+      {
+        _tailcache = _tail.load(std::memory_order_acquire);
+        avail      = _tailcache - head;
+      }
+      size_t i = head & _mask;
+      return std::span<T>(_ring + i, bun_min(bun_min(count, avail), _mask + 1 - i));
+    }
+    // Removes the first count items returned by Peek()
+    BUN_FORCEINLINE void Release(size_t count)
+    {
+      _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Only an estimate when called while the other side is running
+    inline size_t size() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+    inline size_t Capacity() const { return _mask + 1; }
+
+  protected:
+    inline void _init(size_t capacity)
+    {
+      capacity = NextPow2((uint64_t)bun_max(capacity, (size_t)2));
+      _mask    = capacity - 1;
+      _ring    = std::allocator_traits<Alloc>::allocate(*this, capacity);
+      for(size_t i = 0; i < capacity; ++i)
+        new(_ring + i) T();
+      _head.store(0, std::memory_order_relaxed);
+      _tail.store(0, std::memory_order_relaxed);
+      _headcache = _tailcache = 0;
+    }
+    template<typename U> inline bool _produce(U&& item)
+    {
+      size_t tail = _tail.load(std::memory_order_relaxed);
+      if(tail - _headcache > _mask)
+      {
+        _headcache = _head.load(std::memory_order_acquire);
+        if(tail - _headcache > _mask)
+          return false;
+      }
+      _ring[tail & _mask] = std::forward<U>(item);
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    T* _ring;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _tail; // Written by the producer
+    size_t _headcache;                     // Producer's copy of _head
+    alignas(64) std::atomic<size_t> _head; // Written by the consumer
+    size_t _tailcache;                     // Consumer's copy of _tail
+  };
 }
 
 #endif
@@ -0,0 +1,289 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#ifndef __PARALLEL_H__BUN__
+#define __PARALLEL_H__BUN__
+
+#include "algo.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <iterator>
+
+namespace bun {
+  namespace internal {
+    // Hands out chunks of [next, end) to whichever thread asks first. Chunks start out large and shrink as the range runs
+    // out (guided self-scheduling), so threads that finish early pick up the tail of the work in small pieces instead of
+    // waiting on a thread stuck with one big chunk. Runs entirely out of the caller's stack frame, so it never allocates.
+    template<typename F> struct ParallelJob
+    {
+      ParallelJob(ThreadPool& p, size_t first, size_t last, size_t g, F& f) :
+        pool(p), fn(f), next(first), end(last), grain(g), divisor((p.Workers() + 1) * 2), active(0)
+      {}
+
+      inline bool Claim(size_t& begin, size_t& finish)
+      {
+        size_t cur = next.load(std::memory_order_relaxed);
+        do
+        {
+          if(cur >= end)
+            return false;
+          finish = bun_min(end, cur + bun_max(grain, (end - cur) / divisor));
+        } while(!next.compare_exchange_weak(cur, finish, std::memory_order_relaxed));
+        begin = cur;
+        return true;
+      }
+      inline void Process()
+      {
+        size_t begin, finish;
+        while(Claim(begin, finish))
+          fn(begin, finish);
+      }
+      // Runs the job on the pool with the calling thread also taking chunks, then waits for every queued instance to
+      // finish, since they reference this job. Waiting threads help run other pool tasks, so calling this from inside a
+      // pool task is safe.
+      inline void Run()
+      {
+        size_t instances = bun_min(pool.Workers(), (end - next.load(std::memory_order_relaxed) + grain - 1) / grain - 1);
+        active.store(instances ? instances + 1 : 0, std::memory_order_relaxed);
+        if(instances > 0)
+          pool.AddTask(&_run, this, instances);
+        Process();
+
+        // Once active drops to 1 the last instance is only notifying us, so spin until it's done with the job.
+        while(size_t cur = active.load(std::memory_order_acquire))
+        {
+          if(cur == 1)
+            CPU_Pause();
+          else if(!pool.RunTask())
+            active.wait(cur, std::memory_order_acquire);
+        }
+      }
+
+      ThreadPool& pool;
+      F& fn;
+      std::atomic<size_t> next;
+      size_t end;
+      size_t grain;
+      size_t divisor;
+      std::atomic<size_t> active;
+
+    protected:
+      static void _run(void* p)
+      {
+        ParallelJob* job = reinterpret_cast<ParallelJob*>(p);
+        job->Process();
+        // active starts one above the instance count, so the last instance can notify before releasing the job with
+        // the final store, after which it must not touch it.
+        if(job->active.fetch_sub(1, std::memory_order_acq_rel) == 2)
+        {
+          job->active.notify_all();
+          job->active.store(0, std::memory_order_release);
+        }
+      }
+    };
+
+    // Picks a minimum chunk size that gives every thread several chunks to balance with.
+    BUN_FORCEINLINE size_t ParallelGrain(ThreadPool& pool, size_t n, size_t grain)
+    {
+      return grain ? grain : bun_max((size_t)1, n / ((pool.Workers() + 1) * 32));
+    }
+
+    // Finds how many elements of a come before output index k when merging a and b, taking elements from a first on ties.
+    template<typename It, typename LESS>
+    inline size_t MergeSplit(It a, size_t na, It b, size_t nb, size_t k, const LESS& less)
+    {
+      size_t lo = (k > nb) ? k - nb : 0;
+      size_t hi = bun_min(k, na);
+      while(lo < hi)
+      {
+        size_t mid = lo + ((hi - lo) >> 1);
+        if(!less(b[k - mid - 1], a[mid]))
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      return lo;
+    }
+  }
+
+  // Calls f(begin, end) on disjoint chunks covering [first, last) using the pool and the calling thread, and returns once
+  // every chunk is done. If grain is 0, a minimum chunk size is picked based on the number of workers.
+  template<typename F> inline void ParallelFor(ThreadPool& pool, size_t first, size_t last, F&& f, size_t grain = 0)
+  {
+    if(last <= first)
+      return;
+    grain = internal::ParallelGrain(pool, last - first, grain);
+    if(last - first <= grain || !pool.Workers())
+    {
+      f(first, last);
+      return;
+    }
+
+    internal::ParallelJob<std::remove_reference_t<F>> job(pool, first, last, grain, f);
+    job.Run();
+  }
+
+  // Calls f on every element of a random access range, like an Array, DynArray or ArraySort.
+  template<sized_random_access_range R, typename F>
+    requires std::is_invocable_v<F&, std::ranges::range_reference_t<R>>
+  inline void ParallelFor(ThreadPool& pool, R&& range, F&& f, size_t grain = 0)
+  {
+    auto it = std::ranges::begin(range);
+    ParallelFor(
+      pool, 0, std::ranges::size(range),
+      [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i)
+          f(it[i]);
+      },
+      grain);
+  }
+
+  // Combines every element of the range using op, which must be associative and commutative, because chunks are combined
+  // in whatever order threads finish them. init is included exactly once.
+  template<sized_random_access_range R, typename T, typename Op = std::plus<>>
+  inline T ParallelReduce(ThreadPool& pool, R&& range, T init, Op op = Op{}, size_t grain = 0)
+  {
+    auto it  = std::ranges::begin(range);
+    size_t n = std::ranges::size(range);
+    if(!n)
+      return init;
+
+    std::mutex lock;
+    ParallelFor(
+      pool, 0, n,
+      [&](size_t begin, size_t end) {
+        T acc = it[begin];
+        for(size_t i = begin + 1; i < end; ++i)
+          acc = op(std::move(acc), it[i]);
+        std::scoped_lock guard(lock); // Only taken once per chunk, so it's never contended enough to matter
+        init = op(std::move(init), std::move(acc));
+      },
+      grain);
+    return init;
+  }
+
+  // Writes the inclusive prefix scan of the range into out, which can point at the range itself. op only has to be
+  // associative. The range is split into one block per thread: each block is reduced in parallel, the block totals are
+  // scanned serially, then every block is scanned again starting from the total of the blocks before it.
+  template<sized_random_access_range R, std::random_access_iterator Out, typename Op = std::plus<>>
+  inline void ParallelScan(ThreadPool& pool, R&& range, Out out, Op op = Op{})
+  {
+    using T  = std::remove_cvref_t<range_value_t<R>>;
+    auto it  = std::ranges::begin(range);
+    size_t n = std::ranges::size(range);
+    if(!n)
+      return;
+
+    size_t blocks = bun_min(n, (pool.Workers() + 1) * 4);
+    size_t width  = (n + blocks - 1) / blocks;
+    blocks        = (n + width - 1) / width;
+    Array<T> sums(blocks);
+
+    ParallelFor(
+      pool, 0, blocks,
+      [&](size_t begin, size_t end) {
+        for(size_t b = begin; b < end; ++b)
+        {
+          size_t last = bun_min(n, (b + 1) * width);
+          T acc       = it[b * width];
+          for(size_t i = b * width + 1; i < last; ++i)
+            acc = op(std::move(acc), it[i]);
+          sums[b] = std::move(acc);
+        }
+      },
+      1);
+
+    for(size_t b = 1; b < blocks; ++b)
+      sums[b] = op(sums[b - 1], sums[b]);
+
+    ParallelFor(
+      pool, 0, blocks,
+      [&](size_t begin, size_t end) {
+        for(size_t b = begin; b < end; ++b)
+        {
+          size_t i    = b * width;
+          size_t last = bun_min(n, i + width);
+          T acc       = b ? op(sums[b - 1], it[i]) : T(it[i]);
+          out[i]      = acc;
+          for(++i; i < last; ++i)
+          {
+            acc    = op(std::move(acc), it[i]);
+            out[i] = acc;
+          }
+        }
+      },
+      1);
+  }
+
+  // Sorts a random access range with a parallel merge sort, using the same three-way comparisons as ArraySort. Each thread
+  // first sorts its own block, then pairs of runs are merged into a temporary buffer. Every merge is split into pieces by
+  // binary searching for the point where each piece starts, so the last few merges still use every thread. This is not a
+  // stable sort, and the elements must be default constructible and movable.
+  template<sized_random_access_range R, Comparison<range_value_t<R>, range_value_t<R>> C = std::compare_three_way>
+  inline void ParallelSort(ThreadPool& pool, R&& range, C comp = C{}, size_t grain = 0)
+  {
+    using T  = std::remove_cvref_t<range_value_t<R>>;
+    auto it  = std::ranges::begin(range);
+    size_t n = std::ranges::size(range);
+    auto less = [&](const T& l, const T& r) { return comp(l, r) < 0; };
+
+    size_t threads = pool.Workers() + 1;
+    size_t width   = bun_max(internal::ParallelGrain(pool, n, grain), (n + threads - 1) / threads);
+    if(n <= width || threads < 2)
+      return std::sort(it, it + n, less);
+
+    size_t runs = (n + width - 1) / width;
+    ParallelFor(
+      pool, 0, runs,
+      [&](size_t begin, size_t end) {
+        for(size_t r = begin; r < end; ++r)
+          std::sort(it + (r * width), it + bun_min(n, (r + 1) * width), less);
+      },
+      1);
+
+    Array<T> buffer(n);
+    T* tmp      = buffer.data();
+    bool inside = false; // True if the current runs are in the buffer rather than the range
+
+    for(; width < n; width <<= 1)
+    {
+      size_t pairs  = (n + (width << 1) - 1) / (width << 1);
+      size_t pieces = bun_max((size_t)1, (threads * 4 + pairs - 1) / pairs);
+
+      auto merge = [&](auto src, auto dest) {
+        ParallelFor(
+          pool, 0, pairs * pieces,
+          [&](size_t begin, size_t end) {
+            for(size_t job = begin; job < end; ++job)
+            {
+              size_t base  = (job / pieces) * (width << 1);
+              size_t piece = job % pieces;
+              size_t na    = bun_min(width, n - base);
+              size_t nb    = bun_min(width, n - base - na);
+              auto a       = src + base;
+              auto b       = a + na;
+              size_t k0    = ((na + nb) * piece) / pieces;
+              size_t k1    = ((na + nb) * (piece + 1)) / pieces;
+              size_t i0    = internal::MergeSplit(a, na, b, nb, k0, less);
+              size_t i1    = internal::MergeSplit(a, na, b, nb, k1, less);
+              std::merge(std::make_move_iterator(a + i0), std::make_move_iterator(a + i1),
+                         std::make_move_iterator(b + (k0 - i0)), std::make_move_iterator(b + (k1 - i1)), dest + base + k0,
+                         less);
+            }
+          },
+          1);
+      };
+
+      if(inside)
+        merge(tmp, it);
+      else
+        merge(it, tmp);
+      inside = !inside;
+    }
+
+    if(inside)
+      ParallelFor(pool, 0, n, [&](size_t begin, size_t end) { std::move(tmp + begin, tmp + end, it + begin); });
+  }
+}
+
+#endif
@@ -4,266 +4,471 @@
 #ifndef __BUN_ALLOC_RING_H__
 #define __BUN_ALLOC_RING_H__
 
-#include "LLBase.h"
-#include "lockless.h"
-#include "RWLock.h"
+#include "BlockAllocMT.h"
 #include <string.h>
 
-/* // This doesn't work. Kept here for posterity.
 namespace bun {
-  // Primary implementation of a multi-consumer multi-producer lockless ring allocator
-  class BUN_COMPILER_DLLEXPORT RingAllocVoid
+  /* Single-threaded ring allocator for short lived buffers, like per-frame or per-request scratch memory. Allocations
+   * are bumped out of the current bucket, and each bucket counts how many of its allocations are still alive. Once a
+   * bucket is full it is retired, and the moment its last allocation is freed it goes back on the free list to be reused.
+   * As long as allocations are freed in roughly the order they were made, memory cycles through a handful of buckets like
+   * a ring buffer, but out of order frees are still fine, they just hold onto their bucket for longer. Allocations bigger
+   * than a bucket get a dedicated bucket that is freed along with them. */
+  class BUN_COMPILER_DLLEXPORT RingAlloc
   {
+    RingAlloc(const RingAlloc& copy)            = delete;
+    RingAlloc& operator=(const RingAlloc& copy) = delete;
+
     struct Bucket
     {
-      Bucket* next; // next free bucket
-      size_t sz;
-      std::atomic<size_t> reserved; // How much was attempted to be used (includes allocations over the limit)
-      LLBase<Bucket> list; // position on permanent doubly linked list
-      RWLock lock;
+      Bucket* next; // Next bucket on the free list, or the list of every bucket
+      Bucket* prev;
+      size_t size;
+      size_t used;
+      size_t live;
     };
 
-    struct Node
+  public:
+    // Counts how many buckets have been made and how often one was reused
+    struct Stats
     {
-      size_t sz;
-      Bucket* p;
+      uint64_t buckets;  // Buckets currently allocated, including dedicated ones
+      uint64_t recycled; // Times a bucket was retired and later reused
     };
 
-  public:
-    RingAllocVoid(RingAllocVoid&& mov) : _gc(mov._gc), _lastsize(mov._lastsize), _list(mov._list)
+    inline RingAlloc(RingAlloc&& mov) :
+      _cur(mov._cur),
+      _free(mov._free),
+      _all(mov._all),
+      _bucketsize(mov._bucketsize),
+      _align(mov._align),
+      _header(mov._header),
+      _offset(mov._offset),
+      _stats(mov._stats)
     {
-      _cur.store(mov._cur.load(std::memory_order_acquire), std::memory_order_release);
-      mov._cur.store(0, std::memory_order_release);
-      mov._list = nullptr;
+      mov._cur   = mov._free = mov._all = nullptr;
+      mov._stats = Stats{ 0, 0 };
     }
-    explicit RingAllocVoid(size_t sz) : _lastsize(sz), _list(0)
+    inline explicit RingAlloc(size_t bucketsize = (1 << 16), size_t align = alignof(std::max_align_t)) :
+      _cur(nullptr),
+      _free(nullptr),
+      _all(nullptr),
+      _bucketsize(AlignSize(bucketsize, align)),
+      _align(align),
+      _header(AlignSize(sizeof(Bucket*), align)),
+      _offset(AlignSize(sizeof(Bucket), align)),
+      _stats{ 0, 0 }
     {
-      _gc.p = nullptr;
-      _gc.tag = 0;
-      _cur.store(_genBucket(sz), std::memory_order_release);
+      assert(!(align & (align - 1)) && align >= alignof(Bucket*));
     }
-    ~RingAllocVoid() { _clear(); }
+    inline ~RingAlloc() { _destroy(); }
 
-    inline void* Alloc(size_t num) noexcept
+    inline void* Alloc(size_t sz) noexcept
     {
-      size_t n = num + sizeof(Node);
-      Bucket* cur;
-      size_t r, rend;
-
-      for(;;)
-      {
-        _lock.RLock();
-        cur = _cur.load(std::memory_order_acquire);
-
-        if(!cur->lock.AttemptRLock()) // If this fails we probably got a bucket that was in the middle of being recycled
-        {
-          _lock.RUnlock();
-          continue;
-        }
-
-        r = cur->reserved.fetch_add(n, std::memory_order_acq_rel);
-        rend = r + n;
-
-        if(rend > cur->sz) // If we went over the limit, we'll have to grab another bucket
-        {
-          cur->reserved.fetch_sub(n, std::memory_order_release);
-          cur->lock.RUnlock();
-
-          if(!r) // If r was zero, it's theoretically possible for this bucket to get orphaned, so we send it into the
-_checkRecycle function _checkRecycle(cur); // Even if someone else acquires the lock before this runs, either the allocation
-will succeed or this check will
-
-          if(_lock.AttemptUpgrade())
-          {
-            _cur.store(_genBucket(n), std::memory_order_release);
-            _lock.Downgrade();
-          }
-          _lock.RUnlock();
-        }
-        else
-        {
-          _lock.RUnlock();
-          break;
-        }
-      }
-
-      Node* ret = (Node*)(((char*)(cur + 1)) + r);
-#ifdef BUN_DEBUG
-      uint8_t* check = (uint8_t*)ret;
-      for(size_t i = 0; i < n; ++i) assert(check[i] == 0xfc);
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      return ALIGNEDALLOC(AlignSize(sz, _align), _align);
 #endif
-      ret->sz = n;
-      ret->p = cur;
-      return ret + 1;
-    }
-    template<class T>
-    inline T* AllocT(size_t count = 1) noexcept { return (T*)Alloc(sizeof(T)*count); }
+      size_t n = _header + AlignSize(sz, _align);
+      if(n > _bucketsize)
+        return _place(_newBucket(n), n);
 
+      if(!_cur || _cur->used + n > _cur->size)
+        _cur = _popBucket(); // The old bucket is retired, and will be recycled once its last allocation is freed
+      return _place(_cur, n);
+    }
+    template<typename T> inline T* AllocT(size_t count = 1) noexcept { return (T*)Alloc(sizeof(T) * count); }
     inline void Dealloc(void* p) noexcept
     {
-      Node* n = ((Node*)p) - 1;
-      Bucket* b = n->p; // grab bucket pointer before we annihilate the node
-#ifdef BUN_DEBUG
-      memset(n, 0xfc, n->sz); // n->sz is the entire size of the node, including the node itself.
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      ALIGNEDFREE(p);
+      return;
 #endif
-      _lock.RLock();
-      b->lock.RUnlock();
-      _checkRecycle(b);
-      _lock.RUnlock();
+      Bucket* b = _bucket(p);
+      assert(b->live > 0);
+      if(--b->live)
+        return;
+      if(b == _cur) // The current bucket is completely free, so just start over at the beginning
+        b->used = 0;
+      else
+        _recycle(b);
     }
-    inline void Clear()
+    // Frees every bucket, invalidating every pointer given out
+    inline void Clear() noexcept
     {
-      _clear();
-      _lock.Lock();
-      _cur.store(_genBucket(_lastsize), std::memory_order_release);
-      _lock.Unlock();
+      _destroy();
+      _cur           = nullptr;
+      _free          = nullptr;
+      _all           = nullptr;
+      _stats.buckets = 0;
     }
+    inline Stats GetStats() const noexcept { return _stats; }
 
-    RingAllocVoid& operator=(RingAllocVoid&& mov) noexcept
-    {
-      _clear();
-      _gc = mov._gc;
-      _lastsize = mov._lastsize;
-      _list = mov._list;
-      _cur.store(mov._cur.load(std::memory_order_acquire), std::memory_order_release);
-      mov._cur.store(0, std::memory_order_release);
-      mov._list = 0;
+    RingAlloc& operator=(RingAlloc&& mov) noexcept
+    {
+      _destroy();
+      _cur        = mov._cur;
+      _free       = mov._free;
+      _all        = mov._all;
+      _bucketsize = mov._bucketsize;
+      _align      = mov._align;
+      _header     = mov._header;
+      _offset     = mov._offset;
+      _stats      = mov._stats;
+      mov._cur   = mov._free = mov._all = nullptr;
+      mov._stats = Stats{ 0, 0 };
       return *this;
     }
 
   protected:
-    BUN_FORCEINLINE static LLBase<Bucket>& _getBucket(Bucket* b) noexcept { return b->list; }
-
-    void _clear()
+    BUN_FORCEINLINE static Bucket* _bucket(void* p) noexcept { return reinterpret_cast<Bucket**>(p)[-1]; }
+    BUN_FORCEINLINE void* _place(Bucket* b, size_t n) noexcept
     {
-      Bucket* hold;
-
-      while(_list != 0)
+      std::byte* r = reinterpret_cast<std::byte*>(b) + _offset + b->used + _header;
+      reinterpret_cast<Bucket**>(r)[-1] = b;
+      b->used += n;
+      ++b->live;
+      return r;
+    }
+    inline Bucket* _newBucket(size_t size) noexcept
+    {
+      Bucket* b = reinterpret_cast<Bucket*>(ALIGNEDALLOC(_offset + size, _align));
+      assert(b != 0);
+      b->size = size;
+      b->used = 0;
+      b->live = 0;
+      _link(b);
+      ++_stats.buckets;
+      return b;
+    }
+    inline Bucket* _popBucket() noexcept
+    {
+      if(Bucket* b = _free)
       {
-        hold = _list;
-        _list = _list->list.next;
-        //assert(!hold->lock.ReaderCount()); // This check only works in single-threaded scenarios for testing purposes. In
-real world scenarios, ReaderCount can sporadically be nonzero due to attempted readlocks that haven't been undone yet.
-        free(hold);
+        _free = b->next;
+        _link(b);
+        ++_stats.recycled;
+        return b;
       }
-
-      _gc.p = nullptr;
-      _gc.tag = 0;
-      _lock.Lock();
-      _cur.store(0, std::memory_order_release);
-      _lock.Unlock();
+      return _newBucket(_bucketsize);
     }
-    // It is crucial that only allocation sizes are passed into this, or the ring allocator will simply keep allocating
-larger and larger buckets forever Bucket* _genBucket(size_t num) noexcept
+    // Buckets on the free list are taken off the list of every bucket, so both lists can share the same pointers
+    inline void _recycle(Bucket* b) noexcept
     {
-      if(_lastsize < num)
-        _lastsize = num;
-
-      // If there are buckets in _gc, see if they are big enough. If they aren't, throw them out
-      bun_PTag<Bucket> prev = { 0, 0 };
-      bun_PTag<Bucket> nval = { 0, 0 };
-      asmcasr<bun_PTag<Bucket>>(&_gc, prev, prev, prev);
-      Bucket* hold;
-
-      while((hold = prev.p) != 0)
+      _unlink(b);
+      if(b->size != _bucketsize)
       {
-        nval.p = prev.p->next;
-        nval.tag = prev.tag + 1;
-        if(!asmcasr<bun_PTag<Bucket>>(&_gc, nval, prev, prev)) // Loop until we atomically extract the first bucket from GC
-          continue;
-
-        if(hold->sz < num) // If a bucket is too small for this allocation, destroy it
+        ALIGNEDFREE(b);
+        --_stats.buckets;
+        return;
+      }
+      b->used = 0;
+      b->next = _free;
+      _free   = b;
+    }
+    BUN_FORCEINLINE void _link(Bucket* b) noexcept
+    {
+      b->prev = nullptr;
+      b->next = _all;
+      if(_all)
+        _all->prev = b;
+      _all = b;
+    }
+    BUN_FORCEINLINE void _unlink(Bucket* b) noexcept
+    {
+      if(b->prev)
+        b->prev->next = b->next;
+      else
+        _all = b->next;
+      if(b->next)
+        b->next->prev = b->prev;
+    }
+    inline void _destroy() noexcept
+    {
+      for(Bucket* list : { _all, _free })
+      {
+        while(Bucket* b = list)
         {
-          AltLLRemove<Bucket, &_getBucket>(hold, _list);
-          //assert(!hold->lock.ReaderCount()); // This check only works in single-threaded scenarios for testing purposes.
-In real world scenarios, ReaderCount can sporadically be nonzero due to attempted readlocks that haven't been undone yet.
-          free(hold);
-          prev = nval;
+          list = b->next;
+          ALIGNEDFREE(b);
         }
-        else // Otherwise, break out of the loop using this bucket
-          break;
       }
+    }
+
+    Bucket* _cur;
+    Bucket* _free;
+    Bucket* _all; // Every bucket that isn't on the free list
+    size_t _bucketsize;
+    size_t _align;
+    size_t _header; // Space in front of each allocation that points back to its bucket
+    size_t _offset; // Space at the start of each bucket for the Bucket struct
+    Stats _stats;
+  };
+
+  /* Multi-producer version of RingAlloc. Threads map onto a fixed set of slots, each with its own lock and its own
+   * current bucket, so threads bump allocate without touching each other. Any thread can free an allocation. Each time a
+   * bucket is handed to a slot it starts a new epoch: the slot counts allocations without any atomics while every free
+   * does one atomic decrement of a counter that starts at a huge bias. When the slot retires the bucket, it removes the
+   * bias minus the number of allocations it made, so the counter only reaches zero once the bucket has been retired and
+   * every allocation from its epoch has been freed, and whichever thread gets it there puts the bucket back in the pool. */
+  class RingAllocMT
+  {
+    RingAllocMT(const RingAllocMT& copy)            = delete;
+    RingAllocMT& operator=(const RingAllocMT& copy) = delete;
+
+    static constexpr size_t BIAS = ((size_t)~0) >> 1;
+
+    struct Bucket
+    {
+      Bucket* next;
+      Bucket* prev;
+      size_t size;
+      size_t used;
+      size_t count; // Allocations made during the current epoch, only touched by the slot that owns the bucket
+      std::atomic<size_t> refs;
+    };
+
+    struct alignas(64) Slot
+    {
+      std::atomic_flag lock;
+      Bucket* cur;
+    };
+
+  public:
+    struct Stats
+    {
+      uint64_t buckets;  // Buckets currently allocated, including dedicated ones
+      uint64_t recycled; // Times a bucket was retired and later reused
+    };
+
+    static constexpr size_t SLOTS = 32;
 
-      if(!hold) // If hold is nullptr we need a new bucket
+    inline explicit RingAllocMT(size_t bucketsize = (1 << 16), size_t align = alignof(std::max_align_t)) :
+      _free(nullptr),
+      _all(nullptr),
+      _bucketsize(AlignSize(bucketsize, align)),
+      _align(align),
+      _header(AlignSize(sizeof(Bucket*), align)),
+      _offset(AlignSize(sizeof(Bucket), align)),
+      _stats{ 0, 0 }
+    {
+      assert(!(align & (align - 1)) && align >= alignof(Bucket*));
+      for(auto& slot : _slots)
       {
-        _lastsize = T_FBNEXT(_lastsize);
-        hold = (Bucket*)calloc(1, sizeof(Bucket) + _lastsize);
-        new (&hold->lock) RWLock();
-        hold->sz = _lastsize;
-        AltLLAdd<Bucket, &_getBucket>(hold, _list);
-#ifdef BUN_DEBUG
-        memset(hold + 1, 0xfc, hold->sz);
+        slot.lock.clear(std::memory_order_relaxed);
+        slot.cur = nullptr;
+      }
+      _poollock.clear(std::memory_order_relaxed);
+    }
+    inline ~RingAllocMT() { _destroy(); }
+
+    inline void* Alloc(size_t sz) noexcept
+    {
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      return ALIGNEDALLOC(AlignSize(sz, _align), _align);
 #endif
+      size_t n = _header + AlignSize(sz, _align);
+      if(n > _bucketsize)
+      {
+        Bucket* b = _newBucket(n, 1);
+        return _place(b, n);
       }
-      else
+
+      Slot& slot = _slots[internal::MagazineThreadID() % SLOTS];
+      _lock(slot.lock);
+      Bucket* b = slot.cur;
+      if(!b || b->used + n > b->size)
       {
-#ifdef BUN_DEBUG
-        memset(hold + 1, 0xfc, hold->sz);
+        if(b)
+          _retire(b);
+        slot.cur = b = _popBucket();
+      }
+      void* r = _place(b, n);
+      ++b->count;
+      slot.lock.clear(std::memory_order_release);
+      return r;
+    }
+    template<typename T> inline T* AllocT(size_t count = 1) noexcept { return (T*)Alloc(sizeof(T) * count); }
+    inline void Dealloc(void* p) noexcept
+    {
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      ALIGNEDFREE(p);
+      return;
 #endif
-        hold->reserved.store(0, std::memory_order_relaxed);
-        hold->lock.Unlock();
+      Bucket* b = reinterpret_cast<Bucket**>(p)[-1];
+      if(b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        _recycle(b);
+    }
+    // Frees every bucket, invalidating every pointer given out. Only safe to call when no other thread is using it.
+    inline void Clear() noexcept
+    {
+      _destroy();
+      for(auto& slot : _slots)
+        slot.cur = nullptr;
+      _free          = nullptr;
+      _all           = nullptr;
+      _stats.buckets = 0;
+    }
+    inline Stats GetStats()
+    {
+      _lock(_poollock);
+      Stats stats = _stats;
+      _poollock.clear(std::memory_order_release);
+      return stats;
+    }
+
+  protected:
+    BUN_FORCEINLINE static void _lock(std::atomic_flag& flag)
+    {
+      while(flag.test_and_set(std::memory_order_acquire))
+        CPU_Pause();
+    }
+    BUN_FORCEINLINE void* _place(Bucket* b, size_t n) noexcept
+    {
+      std::byte* r = reinterpret_cast<std::byte*>(b) + _offset + b->used + _header;
+      reinterpret_cast<Bucket**>(r)[-1] = b;
+      b->used += n;
+      return r;
+    }
+    // Ends the bucket's epoch by swapping the bias for the number of allocations it actually made
+    BUN_FORCEINLINE void _retire(Bucket* b) noexcept
+    {
+      size_t diff = BIAS - b->count;
+      if(b->refs.fetch_sub(diff, std::memory_order_acq_rel) == diff)
+        _recycle(b);
+    }
+    inline Bucket* _newBucket(size_t size, size_t refs) noexcept
+    {
+      Bucket* b = reinterpret_cast<Bucket*>(ALIGNEDALLOC(_offset + size, _align));
+      assert(b != 0);
+      b->size  = size;
+      b->used  = 0;
+      b->count = 0;
+      new(&b->refs) std::atomic<size_t>(refs);
+      _lock(_poollock);
+      _link(b);
+      ++_stats.buckets;
+      _poollock.clear(std::memory_order_release);
+      return b;
+    }
+    inline Bucket* _popBucket() noexcept
+    {
+      _lock(_poollock);
+      Bucket* b = _free;
+      if(b)
+      {
+        _free = b->next;
+        _link(b);
+        ++_stats.recycled;
       }
+      _poollock.clear(std::memory_order_release);
 
-      return hold;
+      if(!b)
+        return _newBucket(_bucketsize, BIAS);
+      b->used  = 0;
+      b->count = 0;
+      b->refs.store(BIAS, std::memory_order_relaxed);
+      return b;
     }
+    inline void _recycle(Bucket* b) noexcept
+    {
+      _lock(_poollock);
+      _unlink(b);
+      if(b->size != _bucketsize)
+        --_stats.buckets;
+      else
+      {
+        b->next = _free;
+        _free   = b;
+      }
+      _poollock.clear(std::memory_order_release);
 
-    void _checkRecycle(Bucket* b) noexcept
+      if(b->size != _bucketsize)
+        ALIGNEDFREE(b);
+    }
+    BUN_FORCEINLINE void _link(Bucket* b) noexcept
+    {
+      b->prev = nullptr;
+      b->next = _all;
+      if(_all)
+        _all->prev = b;
+      _all = b;
+    }
+    BUN_FORCEINLINE void _unlink(Bucket* b) noexcept
+    {
+      if(b->prev)
+        b->prev->next = b->next;
+      else
+        _all = b->next;
+      if(b->next)
+        b->next->prev = b->prev;
+    }
+    inline void _destroy() noexcept
     {
-      if(b->lock.AttemptStrictLock())
+      for(Bucket* list : { _all, _free })
       {
-        if(b == _cur.load(std::memory_order_acquire)) // If this appears to be the current bucket, we can't recycle it
+        while(Bucket* b = list)
         {
-          if(_lock.AttemptUpgrade()) // So we attempt to acquire the lock for the _cur object
-          {
-            if(b == _cur.load(std::memory_order_acquire)) // If we get the lock, verify we are still the current bucket
-            {
-              b->reserved.store(0, std::memory_order_release); // If we are, we can "recycle" this bucket by just resetting
-the reserved to 0. b->lock.Unlock(); // Now we can unlock because we have been "recycled" into the current bucket.
-              _lock.Downgrade();
-              return;
-            }
-            _lock.Downgrade(); // Otherwise, drop the lock and recycle as normal
-          } // If we fail to get the lock, this just means _cur must have been replaced, so we can recycle this bucket
+          list = b->next;
+          ALIGNEDFREE(b);
         }
-        _recycle(b);
       }
     }
 
-    void _recycle(Bucket* b) noexcept
+    Slot _slots[SLOTS];
+    alignas(64) std::atomic_flag _poollock;
+    Bucket* _free;
+    Bucket* _all; // Every bucket that isn't on the free list
+    size_t _bucketsize;
+    size_t _align;
+    size_t _header;
+    size_t _offset;
+    Stats _stats;
+  };
+
+  template<typename T> struct BUN_COMPILER_DLLEXPORT RingPolicy : protected RingAlloc
+  {
+    RingPolicy() = default;
+    inline explicit RingPolicy(size_t bucketsize, size_t align = alignof(std::max_align_t)) : RingAlloc(bucketsize, align)
+    {}
+    inline T* allocate(std::size_t cnt, T* p = nullptr, size_t old = 0) noexcept
     {
-      bun_PTag<Bucket> prev = { 0, 0 };
-      bun_PTag<Bucket> nval = { b, 0 };
-      asmcasr<bun_PTag<Bucket>>(&_gc, prev, prev, prev); // This will almost always fail but it only serves to get the value
-of _gc do
+      if(cnt <= old)
+        return p;
+      T* n = RingAlloc::AllocT<T>(cnt);
+      if(p)
       {
-        b->next = prev.p;
-        nval.tag = prev.tag + 1;
-      } while(!asmcasr<bun_PTag<Bucket>>(&_gc, nval, prev, prev));
+        MEMCPY(n, cnt * sizeof(T), p, old * sizeof(T));
+        RingAlloc::Dealloc(p);
+      }
+      return n;
     }
-
-    alignas(16) bun_PTag<Bucket> _gc; // Contains a list of empty buckets that can be used to replace _root
-#pragma warning(push)
-#pragma warning(disable:4251)
-    alignas(16) std::atomic<Bucket*> _cur; // Current bucket
-    alignas(64) RWLock _lock;
-#pragma warning(pop)
-    size_t _lastsize; // Last size used for a bucket.
-    Bucket* _list; // root of permanent list of all buckets.
+    inline void deallocate(T* p, [[maybe_unused]] std::size_t num = 0) noexcept { RingAlloc::Dealloc(p); }
+    inline void Clear() noexcept { RingAlloc::Clear(); }
+    using RingAlloc::GetStats;
   };
 
-  template<class T>
-  class BUN_COMPILER_DLLEXPORT RingAlloc : public RingAllocVoid
+  template<typename T> struct RingPolicyMT : protected RingAllocMT
   {
-    RingAlloc(const RingAlloc& copy) = delete;
-    RingAlloc& operator=(const RingAlloc& copy) = delete;
-
-  public:
-    inline RingAlloc(RingAlloc&& mov) = default;
-    inline explicit RingAlloc(size_t init = 8) : RingAllocVoid(init) {}
-    inline T* allocate(size_t cnt, const T* p = nullptr, size_t old = 0) noexcept { assert(!p); return
-(T*)RingAllocVoid::Alloc(cnt * sizeof(T)); } inline void deallocate(T* p, size_t num = 0) noexcept { return
-RingAllocVoid::Dealloc(p); } inline RingAlloc& operator=(RingAlloc&& mov) noexcept = default;
+    RingPolicyMT() = default;
+    inline explicit RingPolicyMT(size_t bucketsize, size_t align = alignof(std::max_align_t)) :
+      RingAllocMT(bucketsize, align)
+    {}
+    inline T* allocate(std::size_t cnt, T* p = nullptr, size_t old = 0) noexcept
+    {
+      if(cnt <= old)
+        return p;
+      T* n = RingAllocMT::AllocT<T>(cnt);
+      if(p)
+      {
+        MEMCPY(n, cnt * sizeof(T), p, old * sizeof(T));
+        RingAllocMT::Dealloc(p);
+      }
+      return n;
+    }
+    inline void deallocate(T* p, [[maybe_unused]] std::size_t num = 0) noexcept { RingAllocMT::Dealloc(p); }
+    inline void Clear() noexcept { RingAllocMT::Clear(); }
+    using RingAllocMT::GetStats;
   };
-}*/
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -8,8 +8,12 @@
 #include "Str.h"
 #include "Trie.h"
 #include "Variant.h"
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <charconv>
 #include <iostream>
+#include <span>
 #include <sstream>
 #include <tuple>
 #include <type_traits>
@@ -27,6 +31,34 @@ namespace std {
 namespace bun {
   template<class T> std::pair<const char*, T&> GenPair(const char* l, T& r) { return std::pair<const char*, T&>(l, r); }
 
+  // Number formatting shared by the text serializers, which never goes through a locale or an ostream's formatting.
+  // Integers of any size are written as integers, even char types, and floating point numbers are written in the
+  // shortest form that parses back to exactly the same value in their own type, unlike an ostream's 6 digits.
+  static constexpr size_t NUMBER_BUFFER_SIZE = 64; // Enough room for any number FormatNumber can write
+
+  // Writes v to buf, which must be at least NUMBER_BUFFER_SIZE characters, and returns the end of what was written
+  template<typename T> inline char* FormatNumber(char* buf, T v)
+  {
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "T must be a number");
+    if constexpr(std::is_floating_point_v<T>)
+      return std::to_chars(buf, buf + NUMBER_BUFFER_SIZE, v).ptr;
+    else if constexpr(std::is_signed_v<T>)
+      return std::to_chars(buf, buf + NUMBER_BUFFER_SIZE, static_cast<int64_t>(v)).ptr;
+    else
+      return std::to_chars(buf, buf + NUMBER_BUFFER_SIZE, static_cast<uint64_t>(v)).ptr;
+  }
+  template<typename T> inline void AppendNumber(std::string& out, T v)
+  {
+    char buf[NUMBER_BUFFER_SIZE];
+    out.append(buf, FormatNumber<T>(buf, v));
+  }
+  // Writes v with a single unformatted write, so the stream's locale and precision are ignored
+  template<typename T> inline void WriteNumber(std::ostream& out, T v)
+  {
+    char buf[NUMBER_BUFFER_SIZE];
+    out.write(buf, FormatNumber<T>(buf, v) - buf);
+  }
+
   namespace internal {
     namespace serializer {
       template<class T> struct PushValue
@@ -66,6 +98,122 @@ namespace bun {
         };
       };
 
+      // Perfect hash from the field names given to EvaluateType to their positions, built once per type the first time
+      // it's used. Names are split into buckets of about two, and each bucket gets a seed that sends all of its names to
+      // slots no other name uses, so finding a key reads its characters once, looks at exactly one slot, and compares
+      // it against the only name that could be there. Returns NONE for unknown keys.
+      class FieldTable
+      {
+      public:
+        static constexpr uint16_t NONE = 0xFFFF;
+
+        FieldTable(std::initializer_list<const char*> names) : FieldTable(std::span(names.begin(), names.size())) {}
+        explicit FieldTable(std::span<const char* const> names)
+        {
+          assert(names.size() < NONE);
+          for(const char* name : names)
+            _names.emplace_back(name);
+          for(size_t slots = bun_max(std::bit_ceil(_names.size()) * 2, (size_t)2);; slots <<= 1)
+            if(_build(slots))
+              break;
+        }
+        inline uint16_t Find(const char* key) const
+        {
+          if(!key)
+            return NONE;
+          size_t len;
+          uint64_t h = _hash(key, len);
+          uint16_t i = _slots[_mix(h ^ _seeds[(h >> 32) & (_seeds.size() - 1)]) & (_slots.size() - 1)];
+          return (i != NONE && _names[i].size() == len && !memcmp(_names[i].data(), key, len)) ? i : NONE;
+        }
+
+      protected:
+        // FNV-1a, which also measures the key so it only has to be read once
+        static inline uint64_t _hash(const char* s, size_t& len)
+        {
+          uint64_t h = 0xcbf29ce484222325ULL;
+          const char* p = s;
+          for(; *p; ++p)
+            h = (h ^ uint8_t(*p)) * 0x100000001b3ULL;
+          len = p - s;
+          return _mix(h);
+        }
+        static BUN_FORCEINLINE uint64_t _mix(uint64_t h)
+        {
+          h ^= h >> 33;
+          h *= 0xff51afd7ed558ccdULL;
+          h ^= h >> 33;
+          h *= 0xc4ceb9fe1a85ec53ULL;
+          return h ^ (h >> 33);
+        }
+        // Seeds the largest buckets first, while most slots are still free. Gives up if a bucket can't be placed, which
+        // makes the caller try again with twice as many slots.
+        bool _build(size_t slots)
+        {
+          size_t n = _names.size();
+          std::vector<uint64_t> hashes(n);
+          std::vector<std::vector<uint16_t>> buckets(bun_max(std::bit_ceil((n + 1) / 2), (size_t)1));
+          for(size_t i = 0; i < n; ++i)
+          {
+            size_t len;
+            hashes[i] = _hash(_names[i].c_str(), len);
+            bool dup  = false;
+            for(uint16_t j : buckets[(hashes[i] >> 32) & (buckets.size() - 1)])
+              dup = dup || _names[j] == _names[i];
+            if(!dup) // Only the first field with a given name can be found
+              buckets[(hashes[i] >> 32) & (buckets.size() - 1)].push_back(uint16_t(i));
+          }
+
+          std::vector<size_t> order(buckets.size());
+          for(size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+          std::stable_sort(order.begin(), order.end(),
+                           [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+          _slots.assign(slots, NONE);
+          _seeds.assign(buckets.size(), 0);
+          for(size_t b : order)
+          {
+            if(buckets[b].empty())
+              break;
+            uint64_t seed = 0;
+            for(;; ++seed)
+            {
+              if(seed > 1024)
+                return false;
+              bool fits = true;
+              for(size_t k = 0; k < buckets[b].size() && fits; ++k)
+              {
+                size_t slot = _mix(hashes[buckets[b][k]] ^ seed) & (slots - 1);
+                fits        = _slots[slot] == NONE;
+                for(size_t j = 0; j < k && fits; ++j)
+                  fits = slot != (_mix(hashes[buckets[b][j]] ^ seed) & (slots - 1));
+              }
+              if(fits)
+                break;
+            }
+            _seeds[b] = seed;
+            for(uint16_t i : buckets[b])
+              _slots[_mix(hashes[i] ^ seed) & (slots - 1)] = i;
+          }
+          return true;
+        }
+
+        std::vector<std::string> _names;
+        std::vector<uint64_t> _seeds;
+        std::vector<uint16_t> _slots;
+      };
+
+      // Lets an istream read a buffer in place, so engines without a buffer fast path can still parse from one
+      struct SpanBuf : std::streambuf
+      {
+        explicit SpanBuf(std::span<const char> buf)
+        {
+          char* p = const_cast<char*>(buf.data());
+          setg(p, p, p + buf.size());
+        }
+      };
+
       template<class, class = void> struct is_serializer_array : std::false_type
       {};
       template<class T>
@@ -280,6 +428,8 @@ namespace bun {
     Engine engine;
     std::ostream* out;
     std::istream* in;
+    const char* _bufcur = nullptr; // Read position when parsing from a buffer, which engines can use instead of in
+    const char* _bufend = nullptr;
 
     template<class T> using ActionBind = internal::serializer::Action<Engine, T>;
 
@@ -294,16 +444,34 @@ namespace bun {
 
     template<typename T> void Parse(T& obj, std::istream& s, const char* name = 0)
     {
-      out = 0;
-      in  = &s;
+      out     = 0;
+      in      = &s;
+      _bufcur = _bufend = nullptr;
       Engine::Begin(*this);
       ActionBind<T>::Parse(*this, obj, name);
       Engine::End(*this);
     }
 
+    // Parses from a contiguous buffer. The buffer is exposed through _bufcur and _bufend so engines can read it directly,
+    // but in is also set to an istream over the same bytes for engines that can't.
+    template<typename T> void Parse(T& obj, std::span<const char> buf, const char* name = 0)
+    {
+      internal::serializer::SpanBuf sb(buf);
+      std::istream s(&sb);
+      out     = 0;
+      in      = &s;
+      _bufcur = buf.data();
+      _bufend = buf.data() + buf.size();
+      Engine::Begin(*this);
+      ActionBind<T>::Parse(*this, obj, name);
+      Engine::End(*this);
+      in      = 0;
+      _bufcur = _bufend = nullptr;
+    }
+
     template<typename T, typename... Args> inline void EvaluateType(std::pair<const char*, Args&>... args)
     {
-      static Trie<uint16_t> trie({ (args.first)... });
+      static internal::serializer::FieldTable table({ (args.first)... });
 
       if(out) // Serializing
         (ActionBind<Args>::Serialize(*this, args.second, args.first), ...);
@@ -316,7 +484,7 @@ namespace bun {
         {
           auto tmp = std::make_tuple<std::pair<const char*, Args&>...>(std::move(args)...);
           Engine::ParseMany(*this, [&](Serializer<Engine>& e, const char* id) {
-            Serializer<Engine>::template FindParse<Args...>(e, id, trie, tmp);
+            Serializer<Engine>::template FindParse<Args...>(e, id, table, tmp);
           });
         }
       }
@@ -361,46 +529,24 @@ namespace bun {
         Engine::template ParseArray<T[I], T, &FixedAdd<T[I]>, &FixedRead<T[I]>>(*this, obj, id);
     }
 
-    template<int I, typename... Args> struct _findparse
-    {
-      inline static void F(Serializer<Engine>& e, uint16_t index, const std::tuple<std::pair<const char*, Args&>...>& args)
-      {
-        if(index == I)
-          ActionBind<std::remove_reference_t<typename std::tuple_element_t<
-            I, std::tuple<std::pair<const char*, Args&>...>>::second_type>>::Parse(e, std::get<I>(args).second,
-                                                                                   std::get<I>(args).first);
-        else
-          _findparse<I - 1, Args...>::F(e, index, args);
-      }
-    };
-
-    template<typename... Args> struct _findparse<0, Args...>
+    template<size_t I, typename... Args>
+    inline static void _parseField(Serializer<Engine>& e, const std::tuple<std::pair<const char*, Args&>...>& args)
     {
-      inline static void F(Serializer<Engine>& e, uint16_t index, const std::tuple<std::pair<const char*, Args&>...>& args)
-      {
-        if(index == 0)
-          ActionBind<std::remove_reference_t<typename std::tuple_element_t<
-            0, std::tuple<std::pair<const char*, Args&>...>>::second_type>>::Parse(e, std::get<0>(args).second,
-                                                                                   std::get<0>(args).first);
-      }
-    };
+      ActionBind<std::tuple_element_t<I, std::tuple<Args...>>>::Parse(e, std::get<I>(args).second, std::get<I>(args).first);
+    }
 
-    /*template<int I, typename... Args>
-    inline static void r_findparse(Serializer<Engine>& e, uint16_t index, const std::tuple<std::pair<const char*,
-    Args&>...>& args)
-    {
-      if(index == I)
-        return ActionBind<std::remove_reference_t<typename std::tuple_element_t<I, std::tuple<std::pair<const char*,
-    Args&>...>>::second_type>>::Parse(e, std::get<I>(args).second, std::get<I>(args).first); if constexpr(I > 0)
-    r_findparse<I
-    - 1, Args...>(e, index, args);
-    }*/
     template<typename... Args> // This function must be static due to some corner cases on certain parsers
-    inline static void FindParse(Serializer<Engine>& e, const char* key, const Trie<uint16_t>& trie,
+    inline static void FindParse(Serializer<Engine>& e, const char* key, const internal::serializer::FieldTable& table,
                                  const std::tuple<std::pair<const char*, Args&>...>& args)
     {
-      _findparse<sizeof...(Args) - 1, Args...>::F(e, trie[key], args);
-      // r_findparse<sizeof...(Args)-1, Args...>(e, trie[key], args);
+      using PARSER = void (*)(Serializer<Engine>&, const std::tuple<std::pair<const char*, Args&>...>&);
+      static constexpr std::array<PARSER, sizeof...(Args)> jump = []<size_t... I>(std::index_sequence<I...>) {
+        return std::array<PARSER, sizeof...(Args)>{ &_parseField<I, Args...>... };
+      }(std::index_sequence_for<Args...>{});
+
+      uint16_t i = table.Find(key);
+      if(i < sizeof...(Args))
+        jump[i](e, args);
     }
 
     static inline void FixedAdd(Serializer<Engine>& e, auto& obj, int& n)
@@ -724,8 +724,7 @@ namespace bun {
       return;
     std::ostream& s = *e.out;
     WriteTOMLId(e, id, s);
-    s << (typename std::conditional<sizeof(T) <= 2, int, T>::type)
-        obj; // Converts all smaller numbers to integers to avoid character insertion bullshit
+    WriteNumber<T>(s, obj);
     if(e.engine.state != STATE_INLINE_TABLE && id)
       s << std::endl;
   }
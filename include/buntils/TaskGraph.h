@@ -0,0 +1,220 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#ifndef __TASK_GRAPH_H__BUN__
+#define __TASK_GRAPH_H__BUN__
+
+#include "ThreadPool.h"
+
+namespace bun {
+  // A dependency graph of tasks that is declared once and then run on a ThreadPool as many times as needed. Every node
+  // keeps an atomic count of its unfinished predecessors, and the thread that finishes the last predecessor of a node is
+  // the one that queues it, so each node starts as soon as it can without any global barrier. The graph is compiled into
+  // flat arrays the first time it is run after being modified, so running an unmodified graph again never allocates.
+  class TaskGraph
+  {
+    typedef void (*FN)(void*);
+
+    struct Node
+    {
+      FN f;
+      void* arg;
+      size_t first;          // Index of this node's first successor in _successors
+      size_t last;           // One past the index of this node's last successor
+      uint32_t dependencies; // Number of predecessors
+      uint32_t pending;      // Number of predecessors that haven't finished yet during the current run
+      TaskGraph* graph;
+    };
+
+    TaskGraph(const TaskGraph&)            = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+  public:
+    TaskGraph() : _continuation(nullptr), _contarg(nullptr), _pool(nullptr), _dirty(false), _remaining(0), _running(0) {}
+    ~TaskGraph() { Wait(); }
+
+    // Adds a node that calls f(arg) and returns its index.
+    inline size_t AddNode(FN f, void* arg)
+    {
+      assert(!Running());
+      _dirty = true;
+      return _nodes.Add(Node{ f, arg, 0, 0, 0, 0, this });
+    }
+    inline size_t AddNode(const Delegate<void>& task) { return AddNode(task.RawFunc(), task.RawSource()); }
+    // Makes the node at index after wait for the node at index before to finish. Edges must not form a cycle.
+    inline void AddEdge(size_t before, size_t after)
+    {
+      assert(!Running());
+      assert(before < _nodes.size() && after < _nodes.size() && before != after);
+      _dirty = true;
+      _edges.Add(std::pair<size_t, size_t>(before, after));
+    }
+    // Sets a function to call once every node has finished. It runs on whichever thread finished the last node, before
+    // Wait() returns, so it can hand the results off somewhere else. The graph still counts as running while it's called,
+    // so it must not run or modify the graph.
+    inline void SetContinuation(FN f, void* arg)
+    {
+      assert(!Running());
+      _continuation = f;
+      _contarg      = arg;
+    }
+    inline void SetContinuation(const Delegate<void>& task) { SetContinuation(task.RawFunc(), task.RawSource()); }
+    inline void Clear()
+    {
+      assert(!Running());
+      _nodes.Clear();
+      _edges.Clear();
+      _dirty = true;
+    }
+    // Starts every node that has no predecessors on the given pool. Prefer ThreadPool::Run(graph), which does the same
+    // thing.
+    inline TaskGraph& Run(ThreadPool& pool)
+    {
+      assert(!Running());
+      if(_dirty)
+        _compile();
+
+      _pool = &pool;
+      _running.store(1, std::memory_order_relaxed);
+      _remaining.store(_nodes.size(), std::memory_order_relaxed);
+      for(auto& node : _nodes)
+      {
+        node.graph = this;
+        node.pending = node.dependencies;
+      }
+
+      if(_roots.Empty()) // Only possible for an empty graph
+        _finish();
+      for(auto root : _roots)
+        pool.AddTask(&_exec, &_nodes[root]);
+      return *this;
+    }
+    // Blocks until every node and the continuation have finished. While waiting, the calling thread runs queued tasks
+    // from the pool, so this must not be called from inside one of the graph's own nodes.
+    inline void Wait()
+    {
+      for(uint32_t state; (state = _running.load(std::memory_order_acquire)) != 0;)
+      {
+        if(state == FINISHING)
+          CPU_Pause();
+        else if(!_pool->RunTask())
+          _running.wait(1, std::memory_order_acquire);
+      }
+    }
+    inline bool Running() const { return _running.load(std::memory_order_acquire) != 0; }
+    inline size_t size() const { return _nodes.size(); }
+
+  protected:
+    static constexpr uint32_t FINISHING = 2; // _running value while _finish() is still notifying waiters
+
+    // Runs a node, then decrements the pending count of each successor. The first successor that becomes ready is run
+    // inline on this thread to avoid a round trip through the pool, and any others are queued.
+    static void _exec(void* p)
+    {
+      Node* node      = reinterpret_cast<Node*>(p);
+      TaskGraph& self = *node->graph;
+
+      while(node)
+      {
+        (*node->f)(node->arg);
+
+        Node* next = nullptr;
+        for(size_t i = node->first; i < node->last; ++i)
+        {
+          Node* succ = &self._nodes[self._successors[i]];
+          if(std::atomic_ref<uint32_t>(succ->pending).fetch_sub(1, std::memory_order_acq_rel) == 1)
+          {
+            if(!next)
+              next = succ;
+            else
+              self._pool->AddTask(&_exec, succ);
+          }
+        }
+
+        // Once _remaining hits zero the graph may be destroyed, so nothing can be touched after this.
+        if(self._remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          self._finish();
+        node = next;
+      }
+    }
+    inline void _finish()
+    {
+      if(_continuation)
+        (*_continuation)(_contarg);
+      // Waiters can destroy the graph as soon as they see 0, so that has to be the very last thing written. FINISHING
+      // wakes them up and keeps them spinning until notify_all() is done with _running.
+      _running.store(FINISHING, std::memory_order_release);
+      _running.notify_all();
+      _running.store(0, std::memory_order_release);
+    }
+    // Flattens the edge list into a compact successor array and finds the root nodes.
+    inline void _compile()
+    {
+      for(auto& node : _nodes)
+      {
+        node.first        = 0;
+        node.dependencies = 0;
+      }
+      for(auto& [before, after] : _edges)
+      {
+        ++_nodes[before].first;
+        ++_nodes[after].dependencies;
+      }
+
+      size_t total = 0;
+      for(auto& node : _nodes)
+      {
+        size_t count = node.first;
+        node.first   = total;
+        node.last    = total;
+        total += count;
+      }
+
+      _successors.SetCapacityDiscard(total);
+      for(auto& [before, after] : _edges)
+        _successors[_nodes[before].last++] = after;
+
+      _roots.Clear();
+      for(size_t i = 0; i < _nodes.size(); ++i)
+        if(!_nodes[i].dependencies)
+          _roots.Add(i);
+
+      assert(_acyclic());
+      _dirty = false;
+    }
+    // Kahn's algorithm, only used to verify the graph in debug builds
+    inline bool _acyclic()
+    {
+      DynArray<size_t> stack(_roots);
+      for(auto& node : _nodes)
+        node.pending = node.dependencies;
+
+      size_t visited = 0;
+      while(!stack.Empty())
+      {
+        Node& node = _nodes[stack.Back()];
+        stack.RemoveLast();
+        ++visited;
+        for(size_t i = node.first; i < node.last; ++i)
+          if(!--_nodes[_successors[i]].pending)
+            stack.Add(_successors[i]);
+      }
+      return visited == _nodes.size();
+    }
+
+    DynArray<Node> _nodes;
+    DynArray<std::pair<size_t, size_t>> _edges;
+    Array<size_t> _successors;
+    DynArray<size_t> _roots;
+    FN _continuation;
+    void* _contarg;
+    ThreadPool* _pool;
+    bool _dirty;
+    std::atomic<size_t> _remaining;
+    std::atomic<uint32_t> _running;
+  };
+
+  inline TaskGraph& ThreadPool::Run(TaskGraph& graph) { return graph.Run(*this); }
+}
+
+#endif
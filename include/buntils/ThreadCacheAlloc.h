@@ -0,0 +1,413 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#ifndef __BUN_ALLOC_THREAD_CACHE_H__
+#define __BUN_ALLOC_THREAD_CACHE_H__
+
+#include "BlockAllocMT.h"
+
+namespace bun {
+  /* General purpose multi-producer multi-consumer allocator in the style of tcmalloc, using the same power of two size
+   * classes as LocklessBlockCollection. Every size class carves its blocks out of fixed size, span-aligned pages, so the
+   * page that owns a block is found by masking its address. Threads allocate from and free to a small cache of free lists,
+   * one per size class, and only touch the shared central list for a size class when their own list runs dry or grows too
+   * long, at which point a whole batch of blocks is moved at once. The central list tracks how many blocks of each page are
+   * still in use, and once a page is completely free it is handed back to the system, keeping one spare per size class
+   * to avoid thrashing. Allocations larger than MAXSIZE go straight to malloc. Like MagazineBlockAllocator, threads map
+   * onto a fixed set of caches with their own locks, so a cache is only contended if there are more than CACHES threads. */
+  template<size_t MAXSIZE = sizeof(void*) * 512, size_t SPANSIZE = (1 << 16)> class ThreadCacheCollection
+  {
+    static constexpr size_t COUNT = bun_Log2(MAXSIZE / sizeof(void*)) + 1;
+    static_assert(!(MAXSIZE & (MAXSIZE - 1)) && !(SPANSIZE & (SPANSIZE - 1)), "MAXSIZE and SPANSIZE must be powers of two");
+
+    struct Span
+    {
+      Span* prev;
+      Span* next;
+      void* freelist;
+      size_t cls;
+      size_t live;  // Blocks currently handed out to a thread cache or the program
+      size_t total; // Blocks that fit in this span
+    };
+
+    static constexpr size_t HEADER = AlignSize(sizeof(Span), 64);
+    static_assert(SPANSIZE >= HEADER + MAXSIZE * 2, "SPANSIZE must fit at least two of the largest blocks");
+
+    struct FreeList
+    {
+      void* head;
+      size_t count;
+      size_t limit; // How long the list can grow before a batch is sent back to the central list
+    };
+
+    struct alignas(64) Cache
+    {
+      std::atomic_flag lock;
+      FreeList lists[COUNT];
+    };
+
+    struct alignas(64) Central
+    {
+      std::atomic_flag lock;
+      Span* partial; // Spans with at least one free block
+      Span* full;    // Spans with every block handed out
+      Span* spare;   // One completely free span kept around so a size class doesn't thrash at a page boundary
+    };
+
+    inline static constexpr size_t _getindex(size_t n) { return bun_Log2(NextPow2(n) / sizeof(void*)); }
+    inline static constexpr size_t _blocksize(size_t cls) { return sizeof(void*) << cls; }
+    // Small blocks move in big batches so the central lock is rarely taken, large ones in small batches to bound how much
+    // memory can sit idle in a thread cache.
+    inline static constexpr size_t _batch(size_t cls)
+    {
+      return bun_max((size_t)2, bun_min((size_t)64, 8192 / _blocksize(cls)));
+    }
+    // A list starts out holding two batches and grows by a batch every time it overflows, up to a span worth of blocks,
+    // so a thread that keeps freeing and reallocating the same number of blocks stops going to the central list.
+    inline static constexpr size_t _maxlimit(size_t cls) { return bun_max(_batch(cls) * 2, SPANSIZE / _blocksize(cls)); }
+
+    ThreadCacheCollection(const ThreadCacheCollection&)            = delete;
+    ThreadCacheCollection& operator=(const ThreadCacheCollection&) = delete;
+
+  public:
+    // Counts how often threads had to go past their own cache, and how many pages are in use
+    struct Stats
+    {
+      uint64_t fetches;  // Batches moved from a central list into a thread cache
+      uint64_t releases; // Batches moved from a thread cache back to a central list
+      uint64_t spans;    // Spans currently allocated
+      uint64_t returned; // Spans given back to the system so far
+    };
+
+    static constexpr size_t CACHES = 32;
+
+    inline ThreadCacheCollection() : _stats{ 0, 0, 0, 0 }
+    {
+      for(auto& cache : _caches)
+      {
+        cache.lock.clear(std::memory_order_relaxed);
+        for(size_t i = 0; i < COUNT; ++i)
+          cache.lists[i] = FreeList{ nullptr, 0, _batch(i) * 2 };
+      }
+      for(auto& central : _central)
+      {
+        central.lock.clear(std::memory_order_relaxed);
+        central.partial = central.full = central.spare = nullptr;
+      }
+      _statlock.clear(std::memory_order_relaxed);
+    }
+    inline ~ThreadCacheCollection() { _freeSpans(); }
+
+    // Allocates num bytes. If p is not null, it must have been allocated with a size of old, and its contents are preserved
+    // up to the smaller of the two sizes, like realloc.
+    inline void* allocate(size_t num, void* p = nullptr, size_t old = 0) noexcept
+    {
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      return realloc(p, num);
+#endif
+      auto idx = _getindex(num);
+      if(p)
+      {
+        assert(old != 0);
+        auto prev = _getindex(old);
+        if(prev == idx && idx < COUNT)
+          return p;
+        if(prev >= COUNT && idx >= COUNT)
+          return realloc(p, num);
+
+        void* n = allocate(num);
+        memcpy(n, p, bun_min(num, old));
+        deallocate(p, old);
+        return n;
+      }
+
+      if(idx >= COUNT)
+        return malloc(num);
+
+      Cache& cache   = _lockCache();
+      FreeList& list = cache.lists[idx];
+      if(!list.head)
+        list.count = _fetch(idx, list.head);
+
+      void* r   = list.head;
+      list.head = *reinterpret_cast<void**>(r);
+      --list.count;
+      cache.lock.clear(std::memory_order_release);
+      return r;
+    }
+    template<class T> inline T* allocT(size_t num) { return reinterpret_cast<T*>(allocate(num * sizeof(T))); }
+    // Frees p, which must have been allocated with a size of num. If num is 0, the size class is read from the span that
+    // owns p instead, so this only works for blocks no larger than MAXSIZE.
+    inline void deallocate(void* p, size_t num) noexcept
+    {
+#ifdef BUN_DISABLE_CUSTOM_ALLOCATORS
+      size_t idx = COUNT;
+#else
+      size_t idx = num ? _getindex(num) : _span(p)->cls;
+#endif
+      if(idx >= COUNT)
+        return free(p);
+
+      assert(_span(p)->cls == idx);
+#ifdef BUN_DEBUG
+      memset(p, 0xfd, _blocksize(idx));
+#endif
+      Cache& cache                 = _lockCache();
+      FreeList& list               = cache.lists[idx];
+      *reinterpret_cast<void**>(p) = list.head;
+      list.head                    = p;
+
+      if(++list.count > list.limit)
+      {
+        if(list.limit < _maxlimit(idx))
+          list.limit += _batch(idx);
+        else
+        { // Cut one batch off the front of the list and give it back to the central list
+          void* release = list.head;
+          void* last    = list.head;
+          for(size_t i = 1; i < _batch(idx); ++i)
+            last = *reinterpret_cast<void**>(last);
+          list.head                       = *reinterpret_cast<void**>(last);
+          *reinterpret_cast<void**>(last) = nullptr;
+          list.count -= _batch(idx);
+          _release(idx, release);
+        }
+      }
+      cache.lock.clear(std::memory_order_release);
+    }
+    template<class T> inline void deallocT(T* p, size_t num) { deallocate(p, num * sizeof(T)); }
+
+    // Frees every span, invalidating every pointer given out. Only safe to call when no other thread is using it.
+    inline void Clear() noexcept
+    {
+      _freeSpans();
+      for(auto& cache : _caches)
+        for(size_t i = 0; i < COUNT; ++i)
+          cache.lists[i] = FreeList{ nullptr, 0, _batch(i) * 2 };
+      for(auto& central : _central)
+        central.partial = central.full = central.spare = nullptr;
+      _stats.spans = 0;
+    }
+    inline Stats GetStats()
+    {
+      _lock(_statlock);
+      Stats stats = _stats;
+      _statlock.clear(std::memory_order_release);
+      return stats;
+    }
+
+  protected:
+    BUN_FORCEINLINE static void _lock(std::atomic_flag& flag)
+    {
+      while(flag.test_and_set(std::memory_order_acquire))
+        CPU_Pause();
+    }
+    BUN_FORCEINLINE Cache& _lockCache()
+    {
+      Cache& cache = _caches[internal::MagazineThreadID() % CACHES];
+      _lock(cache.lock);
+      return cache;
+    }
+    BUN_FORCEINLINE static Span* _span(void* p)
+    {
+      return reinterpret_cast<Span*>(reinterpret_cast<size_t>(p) & ~(SPANSIZE - 1));
+    }
+    BUN_FORCEINLINE static void _unlink(Span*& root, Span* s)
+    {
+      if(s->prev)
+        s->prev->next = s->next;
+      else
+        root = s->next;
+      if(s->next)
+        s->next->prev = s->prev;
+    }
+    BUN_FORCEINLINE static void _link(Span*& root, Span* s)
+    {
+      s->prev = nullptr;
+      s->next = root;
+      if(root)
+        root->prev = s;
+      root = s;
+    }
+    inline Span* _allocSpan(size_t cls)
+    {
+      Span* s = reinterpret_cast<Span*>(ALIGNEDALLOC(SPANSIZE, SPANSIZE));
+      assert(s != 0);
+      size_t size = _blocksize(cls);
+      s->cls      = cls;
+      s->live     = 0;
+      s->total    = (SPANSIZE - HEADER) / size;
+      s->freelist = nullptr;
+
+      std::byte* base = reinterpret_cast<std::byte*>(s) + HEADER;
+      for(size_t i = s->total; i-- > 0;)
+      {
+        *reinterpret_cast<void**>(base + (i * size)) = s->freelist;
+        s->freelist                                  = base + (i * size);
+      }
+
+      _lock(_statlock);
+      ++_stats.spans;
+      _statlock.clear(std::memory_order_release);
+      return s;
+    }
+    // Pulls up to one batch of blocks out of the central list into a chain starting at head, and returns how many it got.
+    inline size_t _fetch(size_t cls, void*& head)
+    {
+      Central& central = _central[cls];
+      size_t count     = 0;
+      head             = nullptr;
+
+      _lock(central.lock);
+      while(count < _batch(cls))
+      {
+        Span* s = central.partial;
+        if(!s)
+        {
+          if((s = central.spare) != nullptr)
+            central.spare = nullptr;
+          else
+            s = _allocSpan(cls);
+          _link(central.partial, s);
+        }
+
+        while(s->freelist && count < _batch(cls))
+        {
+          void* p                      = s->freelist;
+          s->freelist                  = *reinterpret_cast<void**>(p);
+          *reinterpret_cast<void**>(p) = head;
+          head                         = p;
+          ++s->live;
+          ++count;
+        }
+
+        if(!s->freelist)
+        {
+          _unlink(central.partial, s);
+          _link(central.full, s);
+        }
+      }
+      central.lock.clear(std::memory_order_release);
+
+      _lock(_statlock);
+      ++_stats.fetches;
+      _statlock.clear(std::memory_order_release);
+      return count;
+    }
+    // Returns a null terminated chain of blocks to the spans they came from, freeing any span that becomes empty.
+    inline void _release(size_t cls, void* chain)
+    {
+      Central& central = _central[cls];
+      uint64_t freed   = 0;
+
+      _lock(central.lock);
+      while(void* p = chain)
+      {
+        chain   = *reinterpret_cast<void**>(p);
+        Span* s = _span(p);
+        assert(s->cls == cls && s->live > 0);
+
+        if(!s->freelist)
+        {
+          _unlink(central.full, s);
+          _link(central.partial, s);
+        }
+        *reinterpret_cast<void**>(p) = s->freelist;
+        s->freelist                  = p;
+
+        if(!--s->live)
+        {
+          _unlink(central.partial, s);
+          if(!central.spare)
+          {
+            s->next       = nullptr; // _freeSpans walks the spare like a list
+            central.spare = s;
+          }
+          else
+          {
+            ALIGNEDFREE(s);
+            ++freed;
+          }
+        }
+      }
+      central.lock.clear(std::memory_order_release);
+
+      _lock(_statlock);
+      ++_stats.releases;
+      _stats.spans -= freed;
+      _stats.returned += freed;
+      _statlock.clear(std::memory_order_release);
+    }
+    inline void _freeSpans()
+    {
+      for(auto& central : _central)
+      {
+        for(Span* list : { central.partial, central.full, central.spare })
+        {
+          while(Span* s = list)
+          {
+            list = s->next;
+            ALIGNEDFREE(s);
+          }
+        }
+      }
+    }
+
+    Cache _caches[CACHES];
+    Central _central[COUNT];
+    alignas(64) std::atomic_flag _statlock;
+    Stats _stats;
+  };
+
+  // Returns the process-wide ThreadCacheCollection used by ThreadCacheAllocator and ThreadCachePolicy. It is intentionally
+  // never destroyed, so objects with static lifetimes can still free into it during shutdown.
+  inline ThreadCacheCollection<>& GetThreadCache()
+  {
+    static ThreadCacheCollection<>* cache = new ThreadCacheCollection<>();
+    return *cache;
+  }
+
+  // Stateless standard allocator backed by the global thread cache, usable by DynArray, Hash, Str or any std container.
+  template<typename T> class ThreadCacheAllocator
+  {
+  public:
+    using value_type = T;
+    template<class U> struct rebind
+    {
+      typedef ThreadCacheAllocator<U> other;
+    };
+    ThreadCacheAllocator() = default;
+    template<class U> constexpr ThreadCacheAllocator(const ThreadCacheAllocator<U>&) noexcept {}
+
+    inline T* allocate(size_t cnt) const { return GetThreadCache().template allocT<T>(cnt); }
+    inline T* reallocate(size_t cnt, T* p, size_t oldsize) const
+    {
+      return reinterpret_cast<T*>(GetThreadCache().allocate(cnt * sizeof(T), p, oldsize * sizeof(T)));
+    }
+    inline void deallocate(T* p, size_t cnt) const noexcept { GetThreadCache().deallocT(p, cnt); }
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+    using is_always_equal                        = std::true_type;
+  };
+
+  template<class T, class U>
+  constexpr bool operator==(const ThreadCacheAllocator<T>&, const ThreadCacheAllocator<U>&) noexcept
+  {
+    return true;
+  }
+
+  // Policy for PolicyAllocator that forwards to the global thread cache.
+  template<class T> class ThreadCachePolicy
+  {
+  public:
+    inline T* allocate(size_t num, T* p = nullptr, size_t old = 0) noexcept
+    {
+      return reinterpret_cast<T*>(GetThreadCache().allocate(num * sizeof(T), p, old * sizeof(T)));
+    }
+    inline void deallocate(T* p, size_t num = 0) noexcept { GetThreadCache().deallocT(p, num); }
+  };
+}
+
+#endif
@@ -8,48 +8,245 @@
 #include "DynArray.h"
 #include "LocklessQueue.h"
 #include "Thread.h"
+#include "XorshiftEngine.h"
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <span>
 
 namespace bun {
+  class TaskGraph;
+
+  namespace internal {
+    struct FutureState;
+
+    // Chase-Lev work-stealing deque of tasks. Only the owning thread may call Push() and Pop(), which operate LIFO on the
+    // bottom of the deque. Any thread may call Steal(), which takes the oldest task from the top. Slots are stored as
+    // relaxed atomics so a thief racing with the owner never reads a torn value, and a stale read is discarded when the
+    // CAS on _top fails.
+    class TaskDeque
+    {
+      typedef void (*FN)(void*);
+      using TASK = std::pair<FN, void*>;
+
+      struct Slot
+      {
+        std::atomic<FN> f;
+        std::atomic<void*> arg;
+      };
+      struct Buffer
+      {
+        Buffer* prev; // Buffers are only freed when the deque is destroyed, because a thief might still be reading them
+        ptrdiff_t mask;
+
+        BUN_FORCEINLINE Slot& operator[](ptrdiff_t i) { return reinterpret_cast<Slot*>(this + 1)[i & mask]; }
+      };
+
+      TaskDeque(const TaskDeque&)            = delete;
+      TaskDeque& operator=(const TaskDeque&) = delete;
+
+    public:
+      inline explicit TaskDeque(size_t capacity = 256) : _top(0), _bottom(0)
+      {
+        _buffer.store(_allocBuffer(NextPow2(capacity), nullptr), std::memory_order_relaxed);
+      }
+      inline ~TaskDeque()
+      {
+        Buffer* hold = _buffer.load(std::memory_order_relaxed);
+        while(Buffer* b = hold)
+        {
+          hold = b->prev;
+          free(b);
+        }
+      }
+      inline void Push(const TASK& task)
+      {
+        ptrdiff_t b = _bottom.load(std::memory_order_relaxed);
+        ptrdiff_t t = _top.load(std::memory_order_acquire);
+        Buffer* a   = _buffer.load(std::memory_order_relaxed);
+        if(b - t > a->mask)
+          a = _grow(a, t, b);
+        (*a)[b].f.store(task.first, std::memory_order_relaxed);
+        (*a)[b].arg.store(task.second, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+      }
+      inline bool Pop(TASK& task)
+      {
+        ptrdiff_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* a   = _buffer.load(std::memory_order_relaxed);
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ptrdiff_t t = _top.load(std::memory_order_relaxed);
+
+        if(t > b) // The deque was already empty
+        {
+          _bottom.store(b + 1, std::memory_order_relaxed);
+          return false;
+        }
+
+        task = TASK((*a)[b].f.load(std::memory_order_relaxed), (*a)[b].arg.load(std::memory_order_relaxed));
+        if(t != b)
+          return true;
+
+        // This is the last task, so we have to race any thieves for it
+        bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+      }
+      // Returns false if the deque was empty or another thread took the task first.
+      inline bool Steal(TASK& task)
+      {
+        ptrdiff_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ptrdiff_t b = _bottom.load(std::memory_order_acquire);
+
+        if(t >= b)
+          return false;
+
+        Buffer* a = _buffer.load(std::memory_order_acquire);
+        task      = TASK((*a)[t].f.load(std::memory_order_relaxed), (*a)[t].arg.load(std::memory_order_relaxed));
+        return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      }
+      inline bool Empty() const
+      {
+        return _bottom.load(std::memory_order_acquire) <= _top.load(std::memory_order_acquire);
+      }
+
+    protected:
+      inline static Buffer* _allocBuffer(size_t capacity, Buffer* prev)
+      {
+        Buffer* r = reinterpret_cast<Buffer*>(malloc(sizeof(Buffer) + (sizeof(Slot) * capacity)));
+        assert(r != 0);
+        r->prev = prev;
+        r->mask = (ptrdiff_t)capacity - 1;
+        Slot* slots = reinterpret_cast<Slot*>(r + 1);
+        for(size_t i = 0; i < capacity; ++i)
+          new(slots + i) Slot();
+        return r;
+      }
+      inline Buffer* _grow(Buffer* a, ptrdiff_t t, ptrdiff_t b)
+      {
+        Buffer* n = _allocBuffer((size_t)(a->mask + 1) << 1, a);
+        for(ptrdiff_t i = t; i < b; ++i)
+        {
+          (*n)[i].f.store((*a)[i].f.load(std::memory_order_relaxed), std::memory_order_relaxed);
+          (*n)[i].arg.store((*a)[i].arg.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        _buffer.store(n, std::memory_order_release);
+        return n;
+      }
+
+      alignas(64) std::atomic<ptrdiff_t> _top; // Align to try and get them on different cache lines
+      alignas(64) std::atomic<ptrdiff_t> _bottom;
+      std::atomic<Buffer*> _buffer;
+    };
+  }
+
   // Stores a pool of threads that execute tasks.
   class ThreadPool
   {
     typedef void (*FN)(void*);
-    using TASK  = std::pair<FN, void*>;
-    using ALLOC = LocklessBlockCollection<512>;
+    using TASK      = std::pair<FN, void*>;
+    using ALLOC     = LocklessBlockCollection<512>;
+    using TASKALLOC = PolicyAllocator<internal::LQ_QNode<TASK>, MagazineBlockPolicy>;
+
+    // Snapshot of all worker deques that can be stolen from. AddThreads publishes a new list instead of modifying the old
+    // one, because thieves may still be reading it, so old lists are only freed when the pool is destroyed.
+    struct VictimList
+    {
+      VictimList* prev;
+      size_t count;
+
+      BUN_FORCEINLINE internal::TaskDeque** begin() { return reinterpret_cast<internal::TaskDeque**>(this + 1); }
+    };
 
     ThreadPool(const ThreadPool&)            = delete;
     ThreadPool& operator=(const ThreadPool&) = delete;
+    friend struct internal::FutureState;
 
   public:
+    // Determines how tasks are distributed among the worker threads.
+    enum MODE : uint8_t
+    {
+      MODE_SHARED   = 0, // All tasks go through a single shared queue
+      MODE_STEALING = 1, // Each worker has its own deque, and idle workers steal from the others
+    };
+
+    // Time spent by idle threads (including threads inside Wait()) since the pool was created or ResetIdleStats() was
+    // called.
+    struct IdleStats
+    {
+      uint64_t spinning; // Nanoseconds spent spinning or backing off
+      uint64_t parked;   // Nanoseconds spent parked
+      uint64_t parks;    // Number of times a thread parked
+    };
+
+    static constexpr uint32_t DEFAULT_SPIN    = 64;
+    static constexpr uint32_t DEFAULT_BACKOFF = 10;
+    static constexpr uint32_t NEVER_PARK      = ~uint32_t(0);
+
     ThreadPool(ThreadPool&& mov) :
       _run(mov._run.load(std::memory_order_relaxed)),
       _tasks(mov._tasks.load(std::memory_order_relaxed)),
+      _mode(mov._mode),
       _tasklist(std::move(mov._tasklist)),
-      _threads(std::move(mov._threads))
+      _threads(std::move(mov._threads)),
+      _deques(std::move(mov._deques)),
+      _victims(mov._victims.load(std::memory_order_relaxed)),
+      _signal(0),
+      _sleepers(0),
+      _spin(mov._spin.load(std::memory_order_relaxed)),
+      _backoff(mov._backoff.load(std::memory_order_relaxed)),
+      _spinning(0),
+      _parked(0),
+      _parks(0)
     {
       mov._run.store(0, std::memory_order_release);
+      mov._victims.store(nullptr, std::memory_order_relaxed);
     }
-    explicit ThreadPool(size_t count) :
-      _run(0), _tasks(0), _policy(), _tasklist(PolicyAllocator<internal::LQ_QNode<TASK>, LocklessBlockPolicy>{ _policy })
+    explicit ThreadPool(size_t count, MODE mode = MODE_SHARED) :
+      _run(0),
+      _tasks(0),
+      _mode(mode),
+      _policy(),
+      _tasklist(TASKALLOC{ _policy }),
+      _victims(nullptr),
+      _signal(0),
+      _sleepers(0),
+      _spin(DEFAULT_SPIN),
+      _backoff(DEFAULT_BACKOFF),
+      _spinning(0),
+      _parked(0),
+      _parks(0)
     {
       AddThreads(count);
     }
-    ThreadPool() :
-      _run(0), _tasks(0), _policy(), _tasklist(PolicyAllocator<internal::LQ_QNode<TASK>, LocklessBlockPolicy>{ _policy })
-    {
-      AddThreads(IdealWorkerCount());
-    }
+    explicit ThreadPool(MODE mode) : ThreadPool(IdealWorkerCount(), mode) {}
+    ThreadPool() : ThreadPool(IdealWorkerCount(), MODE_SHARED) {}
     ~ThreadPool()
     {
       Wait();
-      _run.store(-_run.load(std::memory_order_acquire),
-                 std::memory_order_release); // Negate the stop count, then wait for it to reach 0
-      _lock.Notify(_threads.size());
-      while(_run.load(std::memory_order_acquire) < 0)
-        ;
+      _run.store(-_run.load(std::memory_order_acquire), std::memory_order_release); // Negate the stop count
+      _wake(~size_t(0));
+      for(auto& thread : _threads)
+      {
+        if(thread.joinable())
+          thread.join();
+      }
+
+      for(auto deque : _deques)
+        delete deque;
+      VictimList* hold = _victims.load(std::memory_order_relaxed);
+      while(VictimList* list = hold)
+      {
+        hold = list->prev;
+        free(list);
+      }
     }
+    // Queues a task. In MODE_STEALING, tasks added from inside one of this pool's workers go on that worker's own deque
+    // and are run LIFO, while tasks added from any other thread go through the shared injection queue. Only threads that
+    // are actually parked get woken up, with a single notification for all instances.
     void AddTask(FN f, void* arg, size_t instances = 1)
     {
       if(!instances)
@@ -58,10 +255,18 @@ namespace bun {
       TASK task(f, arg);
       _tasks.fetch_add(instances, std::memory_order_release);
 
-      for(size_t i = 0; i < instances; ++i)
-        _tasklist.Push(task);
+      if(_mode == MODE_STEALING && _localpool == this)
+      {
+        for(size_t i = 0; i < instances; ++i)
+          _localdeque->Push(task);
+      }
+      else
+      {
+        for(size_t i = 0; i < instances; ++i)
+          _tasklist.Push(task);
+      }
 
-      _lock.Notify(instances);
+      _wake(instances);
     }
 
     template<typename R, typename... Args> void AddFunc(R (*f)(Args...), Args... args)
@@ -75,26 +280,71 @@ namespace bun {
 
     void AddThreads(size_t num = 1)
     {
+      if(_mode == MODE_STEALING)
+      {
+        for(size_t i = 0; i < num; ++i)
+          _deques.Add(new internal::TaskDeque());
+        _publishVictims();
+      }
+
       for(size_t i = 0; i < num; ++i)
       {
         _run.fetch_add(1, std::memory_order_release);
-        _threads.AddConstruct(_worker, std::ref(*this));
+        if(_mode == MODE_STEALING)
+          _threads.AddConstruct(_worker, std::ref(*this), _deques[_threads.size()], (uint64_t)_threads.size() + 1);
+        else
+          _threads.AddConstruct(_worker, std::ref(*this), nullptr, 0);
       }
     }
+    // Processes tasks on the calling thread until every task has finished. Once there is nothing left to run, the thread
+    // follows the idle policy until the remaining tasks are done.
     void Wait()
     {
       TASK task; // It is absolutely crucial that the main thread also process tasks to avoid the issue of orphaned tasks
-      while(_run.load(std::memory_order_acquire) > 0 && _tasklist.Pop(task))
+      while(_tasks.load(std::memory_order_acquire) > 0)
       {
-        auto [f, ptr] = task;
-        (*f)(ptr);
-        _tasks.fetch_sub(1, std::memory_order_release);
+        if(_run.load(std::memory_order_acquire) > 0 && _findTask(task))
+          _execute(task);
+        else
+          _idle(true);
       }
-
-      while(_tasks.load(std::memory_order_relaxed) > 0)
-        ; // Wait until all tasks actually stop processing
     }
+    // Runs a single queued task on the calling thread, if there is one. Threads waiting on something other than the
+    // whole pool can use this to help make progress instead of blocking.
+    inline bool RunTask()
+    {
+      TASK task;
+      if(_run.load(std::memory_order_acquire) <= 0 || !_findTask(task))
+        return false;
+      _execute(task);
+      return true;
+    }
+    // Starts running a task graph on this pool. Defined in TaskGraph.h.
+    TaskGraph& Run(TaskGraph& graph);
     inline size_t Busy() const { return _tasks.load(std::memory_order_relaxed); }
+    inline size_t Workers() const { return _threads.size(); }
+    inline MODE GetMode() const { return _mode; }
+
+    // Sets how long an idle thread spins before parking. It first polls for work spin times, then polls backoff more
+    // times with an exponentially increasing number of pause instructions in between. Pass NEVER_PARK as the backoff to
+    // keep threads spinning forever, which minimizes latency at the cost of burning CPU.
+    inline void SetIdlePolicy(uint32_t spin, uint32_t backoff)
+    {
+      _spin.store(spin, std::memory_order_relaxed);
+      _backoff.store(backoff, std::memory_order_relaxed);
+      _wake(~size_t(0)); // Wake parked threads so they pick up the new policy
+    }
+    inline IdleStats GetIdleStats() const
+    {
+      return IdleStats{ _spinning.load(std::memory_order_relaxed), _parked.load(std::memory_order_relaxed),
+                        _parks.load(std::memory_order_relaxed) };
+    }
+    inline void ResetIdleStats()
+    {
+      _spinning.store(0, std::memory_order_relaxed);
+      _parked.store(0, std::memory_order_relaxed);
+      _parks.store(0, std::memory_order_relaxed);
+    }
 
     static size_t IdealWorkerCount()
     {
@@ -103,20 +353,158 @@ namespace bun {
     }
 
   protected:
-    static void _worker(ThreadPool& pool)
+    using CLOCK = std::chrono::steady_clock;
+
+    BUN_FORCEINLINE void _execute(const TASK& task)
     {
-      while(pool._run.load(std::memory_order_acquire) > 0)
+      auto [f, ptr] = task;
+      (*f)(ptr);
+      if(_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        _wake(~size_t(0)); // Wake up anyone parked inside Wait()
+    }
+
+    // Bumps the signal so parked threads notice a change, but only makes a syscall if someone is actually parked.
+    inline void _wake(size_t count)
+    {
+      _signal.fetch_add(1, std::memory_order_seq_cst);
+      if(_sleepers.load(std::memory_order_seq_cst) > 0)
+      {
+        if(count == 1)
+          _signal.notify_one();
+        else
+          _signal.notify_all();
+      }
+    }
+
+    // Returns true if there might be a task for the current thread to run
+    inline bool _hasWork()
+    {
+      if(_tasklist.Peek())
+        return true;
+      if(_localpool == this && !_localdeque->Empty())
+        return true;
+
+      if(VictimList* list = _victims.load(std::memory_order_acquire))
+      {
+        for(size_t i = 0; i < list->count; ++i)
+          if(!list->begin()[i]->Empty())
+            return true;
+      }
+      return false;
+    }
+
+    inline bool _stopIdle(bool waiting)
+    {
+      return _hasWork() || _run.load(std::memory_order_acquire) <= 0 ||
+             (waiting && !_tasks.load(std::memory_order_acquire));
+    }
+
+    // Called when a thread can't find any work. Spins, then backs off, then parks until _signal changes.
+    inline void _idle(bool waiting)
+    {
+      uint32_t spin    = _spin.load(std::memory_order_relaxed);
+      uint32_t backoff = _backoff.load(std::memory_order_relaxed);
+      auto start       = CLOCK::now();
+
+      for(uint32_t i = 0; i < spin; ++i)
       {
-        pool._lock.Wait();
-        TASK task;
-        while(pool._tasklist.Pop(task))
+        if(_stopIdle(waiting))
         {
-          auto [f, ptr] = task;
-          (*f)(ptr);
-          pool._tasks.fetch_sub(1, std::memory_order_release);
+          _addIdleTime(_spinning, start);
+          return;
         }
       }
+      for(uint32_t i = 0; backoff == NEVER_PARK || i < backoff; ++i)
+      {
+        for(uint32_t j = (1u << bun_min(i, 10u)); j > 0; --j)
+          CPU_Pause();
+        if(_stopIdle(waiting))
+        {
+          _addIdleTime(_spinning, start);
+          return;
+        }
+      }
+      start = _addIdleTime(_spinning, start);
+
+      // The signal has to be read before we check for work again, so if a task is queued after the check, the signal will
+      // have changed and the wait will return immediately.
+      uint32_t signal = _signal.load(std::memory_order_seq_cst);
+      _sleepers.fetch_add(1, std::memory_order_seq_cst);
+      if(!_stopIdle(waiting))
+      {
+        _parks.fetch_add(1, std::memory_order_relaxed);
+        _signal.wait(signal, std::memory_order_seq_cst);
+        _addIdleTime(_parked, start);
+      }
+      _sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    BUN_FORCEINLINE static CLOCK::time_point _addIdleTime(std::atomic<uint64_t>& counter, CLOCK::time_point start)
+    {
+      auto now = CLOCK::now();
+      counter.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count(),
+                        std::memory_order_relaxed);
+      return now;
+    }
+
+    // Finds a task for the current thread, checking its own deque first (if it is one of our workers), then the injection
+    // queue, then attempting to steal from a random victim.
+    inline bool _findTask(TASK& task)
+    {
+      if(_localpool == this && _localdeque->Pop(task))
+        return true;
+      if(_tasklist.Pop(task))
+        return true;
+
+      VictimList* list = _victims.load(std::memory_order_acquire);
+      if(!list || !list->count)
+        return false;
+
+      if(!_localseed)
+        _localseed = (uint64_t)(size_t)&task | 1; // Any nonzero value works as a seed for threads that aren't workers
+      size_t start = (size_t)(xorshift64star(_localseed) % list->count);
+      for(size_t i = 0; i < list->count; ++i)
+      {
+        internal::TaskDeque* victim = list->begin()[(start + i) % list->count];
+        if(victim != _localdeque && victim->Steal(task))
+          return true;
+      }
+      return false;
+    }
+
+    inline void _publishVictims()
+    {
+      VictimList* prev = _victims.load(std::memory_order_relaxed);
+      VictimList* list =
+        reinterpret_cast<VictimList*>(malloc(sizeof(VictimList) + (sizeof(internal::TaskDeque*) * _deques.size())));
+      assert(list != 0);
+      list->prev  = prev;
+      list->count = _deques.size();
+      for(size_t i = 0; i < _deques.size(); ++i)
+        list->begin()[i] = _deques[i];
+      _victims.store(list, std::memory_order_release);
+    }
 
+    static void _worker(ThreadPool& pool, internal::TaskDeque* deque, uint64_t seed)
+    {
+      if(deque)
+      {
+        _localpool  = &pool;
+        _localdeque = deque;
+        _localseed  = seed;
+      }
+
+      TASK task;
+      while(pool._run.load(std::memory_order_acquire) > 0)
+      {
+        if(pool._findTask(task))
+          pool._execute(task);
+        else
+          pool._idle(false);
+      }
+
+      _localpool  = nullptr;
+      _localdeque = nullptr;
       pool._run.fetch_add(1, std::memory_order_release);
     }
 
@@ -128,37 +516,386 @@ namespace bun {
       fn->second->deallocT(fn, 1);
     }
 
-    LocklessBlockPolicy<internal::LQ_QNode<TASK>> _policy;
-    MicroLockQueue<TASK, size_t> _tasklist;
+    MagazineBlockPolicy<internal::LQ_QNode<TASK>> _policy;
+    MicroLockQueue<TASK, size_t, TASKALLOC> _tasklist; // In MODE_STEALING, this is the injection queue for external threads
     std::atomic<size_t> _tasks; // Count of tasks still being processed (this includes tasks that have been removed from the
                                 // queue, but haven't finished yet)
     DynArray<Thread, size_t> _threads;
+    DynArray<internal::TaskDeque*, size_t> _deques;
+    std::atomic<VictimList*> _victims;
     std::atomic<int32_t> _run;
-    Semaphore _lock;
+    alignas(64) std::atomic<uint32_t> _signal; // Parked threads wait on this (which is a futex on most platforms)
+    std::atomic<uint32_t> _sleepers;
+    std::atomic<uint32_t> _spin;
+    std::atomic<uint32_t> _backoff;
+    alignas(64) std::atomic<uint64_t> _spinning;
+    std::atomic<uint64_t> _parked;
+    std::atomic<uint64_t> _parks;
     ALLOC _falloc;
+    MODE _mode;
+
+    inline static thread_local ThreadPool* _localpool           = nullptr;
+    inline static thread_local internal::TaskDeque* _localdeque = nullptr;
+    inline static thread_local uint64_t _localseed              = 0;
   };
 
-  template<typename R, typename... Args> class Future : StoreFunction<R, Args...>
+  namespace internal {
+    // Reference counted state shared by every Future pointing at the same result. All states and continuation records are
+    // allocated from the owning pool's block allocator, so Futures must not outlive the pool that created them.
+    struct FutureState
+    {
+      enum STATUS : uint32_t
+      {
+        STATUS_PENDING = 0,
+        STATUS_READY   = 1,
+        STATUS_WAITING = 2, // Still pending, but at least one thread is parked on it
+      };
+
+      // A callback fired once this state is ready. Holds a reference to target until it has been called.
+      struct Continuation
+      {
+        Continuation* next;
+        void (*f)(Continuation*);
+        FutureState* target;
+        size_t index;
+      };
+
+      FutureState(ThreadPool& p, void (*d)(FutureState*)) :
+        pool(p), destroy(d), refs(1), status(STATUS_PENDING), listeners(nullptr)
+      {}
+
+      BUN_FORCEINLINE void Grab() { refs.fetch_add(1, std::memory_order_relaxed); }
+      BUN_FORCEINLINE void Drop()
+      {
+        if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          destroy(this);
+      }
+      BUN_FORCEINLINE bool Ready() const { return status.load(std::memory_order_acquire) == STATUS_READY; }
+
+      // Blocks until the state is ready. Instead of sleeping right away, the calling thread runs other tasks from the pool,
+      // which is what keeps a worker that waits on a Future from starving the pool of the thread that would finish it.
+      inline void Wait()
+      {
+        while(!Ready())
+        {
+          if(pool.RunTask())
+            continue;
+
+          uint32_t cur = STATUS_PENDING;
+          if(status.compare_exchange_strong(cur, STATUS_WAITING, std::memory_order_acq_rel) || cur == STATUS_WAITING)
+            status.wait(STATUS_WAITING, std::memory_order_acquire);
+        }
+      }
+
+      // Calls f with target and index once this state is ready, on whichever thread completes it. If it is already ready,
+      // f is called immediately on the current thread.
+      inline void Listen(void (*f)(Continuation*), FutureState* target, size_t index)
+      {
+        target->Grab();
+        Continuation* c = Alloc<Continuation>(pool);
+        c->f            = f;
+        c->target       = target;
+        c->index        = index;
+
+        Continuation* head = listeners.load(std::memory_order_acquire);
+        do
+        {
+          if(head == &_closed)
+          {
+            _fire(c);
+            return;
+          }
+          c->next = head;
+        } while(!listeners.compare_exchange_weak(head, c, std::memory_order_release, std::memory_order_acquire));
+      }
+
+      // Marks the state as ready, wakes anyone parked in Wait() and fires every continuation. The caller must hold a
+      // reference, since waking a waiter can otherwise drop the last one.
+      inline void Complete()
+      {
+        if(status.exchange(STATUS_READY, std::memory_order_acq_rel) == STATUS_WAITING)
+          status.notify_all();
+
+        Continuation* c = listeners.exchange(&_closed, std::memory_order_acq_rel);
+        while(c)
+        {
+          Continuation* next = c->next;
+          _fire(c);
+          c = next;
+        }
+      }
+
+      template<class T> BUN_FORCEINLINE static T* Alloc(ThreadPool& p) { return p._falloc.allocT<T>(1); }
+      template<class T> BUN_FORCEINLINE static void Free(ThreadPool& p, T* ptr) { p._falloc.deallocT<T>(ptr, 1); }
+
+      ThreadPool& pool;
+      void (*destroy)(FutureState*);
+      std::atomic<uint32_t> refs;
+      std::atomic<uint32_t> status;
+      std::atomic<Continuation*> listeners; // Set to &_closed once the state is ready
+
+    protected:
+      inline void _fire(Continuation* c)
+      {
+        (*c->f)(c);
+        c->target->Drop();
+        Free(pool, c);
+      }
+
+      inline static Continuation _closed = {};
+    };
+
+    template<typename R> struct FutureValue : FutureState
+    {
+      FutureValue(ThreadPool& p, void (*d)(FutureState*)) : FutureState(p, d) {}
+      ~FutureValue()
+      {
+        if(Ready())
+          value.~R();
+      }
+      template<typename... Args> inline void Set(Args&&... args)
+      {
+        new(&value) R(std::forward<Args>(args)...);
+        Complete();
+      }
+
+      union
+      {
+        R value; // Only constructed once the state is ready
+      };
+    };
+
+    template<> struct FutureValue<void> : FutureState
+    {
+      FutureValue(ThreadPool& p, void (*d)(FutureState*)) : FutureState(p, d) {}
+      inline void Set() { Complete(); }
+    };
+
+    // State of a Future that gets its value by running fn on the pool
+    template<typename R, typename F> struct FutureTask : FutureValue<R>
+    {
+      template<typename G> FutureTask(ThreadPool& p, G&& f) : FutureValue<R>(p, &_destroy), fn(std::forward<G>(f)) {}
+
+      static FutureTask* Create(ThreadPool& pool, F&& f)
+      {
+        return new(FutureState::Alloc<FutureTask>(pool)) FutureTask(pool, std::forward<F>(f));
+      }
+      // Queues fn on the pool. The queued task holds its own reference until it finishes.
+      inline void Start()
+      {
+        this->Grab();
+        this->pool.AddTask(&_run, this);
+      }
+      static void Schedule(FutureState::Continuation* c) { static_cast<FutureTask*>(c->target)->Start(); }
+
+      F fn;
+
+    protected:
+      static void _run(void* p)
+      {
+        FutureTask* self = reinterpret_cast<FutureTask*>(p);
+        if constexpr(std::is_void_v<R>)
+        {
+          self->fn();
+          self->Set();
+        }
+        else
+          self->Set(self->fn());
+        self->Drop();
+      }
+      static void _destroy(FutureState* p)
+      {
+        FutureTask* self = static_cast<FutureTask*>(p);
+        ThreadPool& pool = self->pool;
+        self->~FutureTask();
+        FutureState::Free(pool, self);
+      }
+    };
+
+    // State of a Future produced by WhenAll() or WhenAny(), which becomes ready once count reaches zero.
+    template<typename R> struct FutureJoin : FutureValue<R>
+    {
+      FutureJoin(ThreadPool& p, size_t n) : FutureValue<R>(p, &_destroy), count(n) {}
+
+      static FutureJoin* Create(ThreadPool& pool, size_t n)
+      {
+        return new(FutureState::Alloc<FutureJoin>(pool)) FutureJoin(pool, n);
+      }
+      static void All(FutureState::Continuation* c)
+      {
+        FutureJoin* self = static_cast<FutureJoin*>(c->target);
+        if(self->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          self->Set();
+      }
+      static void Any(FutureState::Continuation* c)
+      {
+        FutureJoin* self = static_cast<FutureJoin*>(c->target);
+        if(self->count.exchange(0, std::memory_order_acq_rel) != 0)
+          self->Set(c->index);
+      }
+
+      std::atomic<size_t> count;
+
+    protected:
+      static void _destroy(FutureState* p)
+      {
+        FutureJoin* self = static_cast<FutureJoin*>(p);
+        ThreadPool& pool = self->pool;
+        self->~FutureJoin();
+        FutureState::Free(pool, self);
+      }
+    };
+
+    template<typename R, typename F> struct FutureThen
+    {
+      using type = std::invoke_result_t<F&, R&>;
+    };
+    template<typename F> struct FutureThen<void, F>
+    {
+      using type = std::invoke_result_t<F&>;
+    };
+  }
+
+  // Handle to the result of a function running on a ThreadPool. Futures are reference counted, so they can be freely
+  // copied, and the result stays alive until the last copy is destroyed. A Future must not outlive its pool.
+  template<typename R> class Future
   {
-    inline Future(ThreadPool& pool, R (*f)(Args...), Args&&... args) :
-      StoreFunction<R, Args...>(f, std::forward<Args>(args)...)
+    using STATE = internal::FutureValue<R>;
+
+    template<typename U> friend class Future;
+    template<typename... Rs> friend Future<void> WhenAll(ThreadPool& pool, const Future<Rs>&... futures);
+    template<typename U> friend Future<void> WhenAll(ThreadPool& pool, std::span<const Future<U>> futures);
+    template<typename... Rs> friend Future<size_t> WhenAny(ThreadPool& pool, const Future<Rs>&... futures);
+    template<typename U> friend Future<size_t> WhenAny(ThreadPool& pool, std::span<const Future<U>> futures);
+
+  public:
+    // Queues f(args...) on the pool. The arguments are copied or moved into the Future's shared state.
+    template<typename F, typename... Args>
+      requires std::is_invocable_r_v<R, std::decay_t<F>&, std::decay_t<Args>&...>
+    inline Future(ThreadPool& pool, F&& f, Args&&... args) : Future(_start(pool, std::forward<F>(f), std::forward<Args>(args)...))
+    {}
+    inline Future(const Future& copy) : _state(copy._state)
+    {
+      if(_state)
+        _state->Grab();
+    }
+    inline Future(Future&& mov) : _state(mov._state) { mov._state = nullptr; }
+    inline Future() : _state(nullptr) {}
+    inline ~Future()
+    {
+      if(_state)
+        _state->Drop();
+    }
+    inline bool Valid() const { return _state != nullptr; }
+    inline bool Ready() const { return _state->Ready(); }
+    // Blocks until the result is available, running other pool tasks on this thread in the meantime.
+    inline void Wait() const { _state->Wait(); }
+    inline std::add_lvalue_reference_t<R> Get() const
+    {
+      _state->Wait();
+      if constexpr(!std::is_void_v<R>)
+        return _state->value;
+    }
+    // Returns a pointer to the result without blocking, or nullptr if it isn't ready yet.
+    inline R* Result() const
+      requires(!std::is_void_v<R>)
     {
-      pool.AddTask(_eval, this);
+      return _state->Ready() ? &_state->value : nullptr;
     }
-    ~Future() { assert(_finished.load(std::memory_order_acquire)); }
-    R* Result() { return _finished.load(std::memory_order_acquire) ? &result : 0; }
+
+    // Queues f on the pool once this Future is ready, passing it a reference to the result (or nothing for Future<void>),
+    // and returns a Future for whatever f returns.
+    template<typename F> inline auto Then(F&& f) const
+    {
+      using U = typename internal::FutureThen<R, std::decay_t<F>>::type;
+      auto fn = [parent = *this, f = std::forward<F>(f)]() mutable -> U {
+        if constexpr(std::is_void_v<R>)
+          return f();
+        else
+          return f(parent._state->value);
+      };
+
+      using TASK = internal::FutureTask<U, decltype(fn)>;
+      TASK* task = TASK::Create(_state->pool, std::move(fn));
+      _state->Listen(&TASK::Schedule, task, 0);
+      return Future<U>(task);
+    }
+
+    inline Future& operator=(const Future& copy)
+    {
+      Future(copy).swap(*this);
+      return *this;
+    }
+    inline Future& operator=(Future&& mov)
+    {
+      Future(std::move(mov)).swap(*this);
+      return *this;
+    }
+    inline void swap(Future& other) { std::swap(_state, other._state); }
 
   protected:
-    R result;
-    std::atomic_bool _finished;
+    inline explicit Future(STATE* state) : _state(state) {}
 
-    static void _eval(void* arg)
+    template<typename F, typename... Args> static STATE* _start(ThreadPool& pool, F&& f, Args&&... args)
     {
-      Future<R, Args...>* p = (Future<R, Args...>*)arg;
-      p->result             = p->Call();
-      p->_finished.store(true, std::memory_order_release);
+      auto fn = [f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable -> R { return f(args...); };
+
+      using TASK = internal::FutureTask<R, decltype(fn)>;
+      TASK* task = TASK::Create(pool, std::move(fn));
+      task->Start();
+      return task;
     }
+
+    STATE* _state;
   };
+
+  template<typename F, typename... Args>
+  Future(ThreadPool&, F&&, Args&&...) -> Future<std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>>;
+
+  // Returns a Future that becomes ready once every given Future is ready.
+  template<typename... Rs> inline Future<void> WhenAll(ThreadPool& pool, const Future<Rs>&... futures)
+  {
+    using JOIN = internal::FutureJoin<void>;
+    JOIN* join = JOIN::Create(pool, sizeof...(Rs) + 1);
+    (futures._state->Listen(&JOIN::All, join, 0), ...);
+
+    // The count starts one higher than the number of futures so the join can't complete while continuations are still
+    // being added, which is released here.
+    internal::FutureState::Continuation last{ nullptr, nullptr, join, 0 };
+    JOIN::All(&last);
+    return Future<void>(join);
+  }
+  template<typename R> inline Future<void> WhenAll(ThreadPool& pool, std::span<const Future<R>> futures)
+  {
+    using JOIN = internal::FutureJoin<void>;
+    JOIN* join = JOIN::Create(pool, futures.size() + 1);
+    for(auto& f : futures)
+      f._state->Listen(&JOIN::All, join, 0);
+
+    internal::FutureState::Continuation last{ nullptr, nullptr, join, 0 };
+    JOIN::All(&last);
+    return Future<void>(join);
+  }
+
+  // Returns a Future that becomes ready as soon as any of the given Futures is ready, holding the index of that Future.
+  template<typename... Rs> inline Future<size_t> WhenAny(ThreadPool& pool, const Future<Rs>&... futures)
+  {
+    static_assert(sizeof...(Rs) > 0, "WhenAny() needs at least one Future");
+    using JOIN = internal::FutureJoin<size_t>;
+    JOIN* join = JOIN::Create(pool, 1);
+    size_t i   = 0;
+    (futures._state->Listen(&JOIN::Any, join, i++), ...);
+    return Future<size_t>(join);
+  }
+  template<typename R> inline Future<size_t> WhenAny(ThreadPool& pool, std::span<const Future<R>> futures)
+  {
+    assert(!futures.empty());
+    using JOIN = internal::FutureJoin<size_t>;
+    JOIN* join = JOIN::Create(pool, 1);
+    for(size_t i = 0; i < futures.size(); ++i)
+      futures[i]._state->Listen(&JOIN::Any, join, i);
+    return Future<size_t>(join);
+  }
 }
 
 #endif
\ No newline at end of file
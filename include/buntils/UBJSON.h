@@ -324,13 +324,13 @@ namespace bun {
         {
         case UBJSONTuple::TYPE_NULL: break;
         case UBJSONTuple::TYPE_CHAR: obj.assign(reinterpret_cast<char*>(&tuple.Int8), 1);
-        case UBJSONTuple::TYPE_INT8: obj = std::to_string((int)tuple.Int8); break;
-        case UBJSONTuple::TYPE_UINT8: obj = std::to_string(tuple.UInt8); break;
-        case UBJSONTuple::TYPE_INT16: obj = std::to_string(tuple.Int16); break;
-        case UBJSONTuple::TYPE_INT32: obj = std::to_string(tuple.Int32); break;
-        case UBJSONTuple::TYPE_INT64: obj = std::to_string(tuple.Int64); break;
-        case UBJSONTuple::TYPE_FLOAT: obj = std::to_string(tuple.Float); break;
-        case UBJSONTuple::TYPE_DOUBLE: obj = std::to_string(tuple.Double); break;
+        case UBJSONTuple::TYPE_INT8: obj.clear(); AppendNumber(obj, tuple.Int8); break;
+        case UBJSONTuple::TYPE_UINT8: obj.clear(); AppendNumber(obj, tuple.UInt8); break;
+        case UBJSONTuple::TYPE_INT16: obj.clear(); AppendNumber(obj, tuple.Int16); break;
+        case UBJSONTuple::TYPE_INT32: obj.clear(); AppendNumber(obj, tuple.Int32); break;
+        case UBJSONTuple::TYPE_INT64: obj.clear(); AppendNumber(obj, tuple.Int64); break;
+        case UBJSONTuple::TYPE_FLOAT: obj.clear(); AppendNumber(obj, tuple.Float); break;
+        case UBJSONTuple::TYPE_DOUBLE: obj.clear(); AppendNumber(obj, tuple.Double); break;
         case UBJSONTuple::TYPE_BIGNUM:
         case UBJSONTuple::TYPE_STRING: obj = tuple.String; break;
         }
@@ -72,8 +72,8 @@ namespace bun {
       return index >= _nodes.size() ? nullptr : _nodes[index].get();
     }
     BUN_FORCEINLINE XMLNode* GetNode(size_t index) { return index >= _nodes.size() ? nullptr : _nodes[index].get(); }
-    BUN_FORCEINLINE const XMLNode* GetNode(const char* name) const { return GetNode(_nodehash[name]); }
-    BUN_FORCEINLINE XMLNode* GetNode(const char* name) { return GetNode(_nodehash[name]); }
+    BUN_FORCEINLINE const XMLNode* GetNode(const char* name) const { return GetNode(_nodehash.Get(_view(name))); }
+    BUN_FORCEINLINE XMLNode* GetNode(const char* name) { return GetNode(_nodehash.Get(_view(name))); }
     BUN_FORCEINLINE size_t GetNodes() const { return _nodes.size(); }
     BUN_FORCEINLINE const XMLValue* GetAttribute(size_t index) const
     {
@@ -83,21 +83,24 @@ namespace bun {
     {
       return index >= _attributes.size() ? nullptr : (_attributes.data() + index);
     }
-    BUN_FORCEINLINE const XMLValue* GetAttribute(const char* name) const { return GetAttribute(_attrhash[name]); }
-    BUN_FORCEINLINE XMLValue* GetAttribute(const char* name) { return GetAttribute(_attrhash[name]); }
+    BUN_FORCEINLINE const XMLValue* GetAttribute(const char* name) const
+    {
+      return GetAttribute(_attrhash.Get(_view(name)));
+    }
+    BUN_FORCEINLINE XMLValue* GetAttribute(const char* name) { return GetAttribute(_attrhash.Get(_view(name))); }
     BUN_FORCEINLINE const char* GetAttributeString(const char* name) const
     {
-      const XMLValue* r = GetAttribute(_attrhash[name]);
+      const XMLValue* r = GetAttribute(_attrhash.Get(_view(name)));
       return !r ? nullptr : r->String.c_str();
     }
     BUN_FORCEINLINE const int64_t GetAttributeInt(const char* name) const
     {
-      const XMLValue* r = GetAttribute(_attrhash[name]);
+      const XMLValue* r = GetAttribute(_attrhash.Get(_view(name)));
       return !r ? 0 : r->Integer;
     }
     BUN_FORCEINLINE const double GetAttributeFloat(const char* name) const
     {
-      const XMLValue* r = GetAttribute(_attrhash[name]);
+      const XMLValue* r = GetAttribute(_attrhash.Get(_view(name)));
       return !r ? 0 : r->Float;
     }
     BUN_FORCEINLINE size_t GetAttributes() const { return _attributes.size(); }
@@ -142,6 +145,11 @@ namespace bun {
     static void _parseEntity(std::istream& stream, Str& target);
     static void _evalValue(XMLValue& val);
     static void _writeString(std::ostream& stream, const char* s, bool attribute);
+    // Looks up names without copying them into a Str. A null name finds nothing, just like an empty one.
+    static BUN_FORCEINLINE std::string_view _view(const char* name)
+    {
+      return name ? std::string_view(name) : std::string_view();
+    }
 
     friend class XMLFile;
 
@@ -234,13 +242,8 @@ namespace bun {
         id ? e.engine.cur->AddAttribute(id) :
              &e.engine.cur->AddNode(e.engine.arrayID)
                 ->GetValue(); // We don't need to update e.engine.cur here because there's nothing else to serialize
-      std::ostringstream ss(std::ios_base::out);
-
-      if constexpr(std::is_floating_point<T>::value)
-        ss << static_cast<double>(t);
-      else
-        ss << static_cast<int64_t>(t);
-      v->String = ss.str();
+      v->String.clear();
+      AppendNumber<T>(v->String, t);
     }
     static void SerializeBool(Serializer<XMLEngine>& e, bool t, const char* id)
     {
@@ -1127,7 +1127,7 @@ namespace bun {
   #elif defined(BUN_COMPILER_GCC) && defined(BUN_64BIT)
     else
     {
-      uint32_t r = !v ? 0 : ((sizeof(uint64_t) << 3) - 1 - __builtin_clz(v));
+      uint32_t r = !v ? 0 : ((sizeof(uint64_t) << 3) - 1 - __builtin_clzll(v));
       return r;
     }
   #endif
@@ -38,6 +38,8 @@ struct bunCPUInfo
   unsigned int flags; // CPU_FLAGS
 };
 
+#define BUN_HUGE_PAGE_SIZE (2 << 20)
+
 extern BUN_DLLEXPORT const bun_VersionInfo bun_Version;
 struct tm;
 
@@ -48,6 +50,9 @@ extern BUN_DLLEXPORT int itoa_r(int value, char* buffer, int size,
 extern BUN_DLLEXPORT const char* GetProgramPath();
 extern BUN_DLLEXPORT size_t GetWorkingSet();
 extern BUN_DLLEXPORT size_t GetPeakWorkingSet();
+extern BUN_DLLEXPORT void* bun_HugeAlloc(size_t size); // Backs allocations of at least BUN_HUGE_PAGE_SIZE bytes with
+                                                       // huge pages if the OS allows it, otherwise uses normal pages.
+extern BUN_DLLEXPORT void bun_HugeFree(void* p, size_t size); // size must match the size given to bun_HugeAlloc
 extern BUN_DLLEXPORT void SetWorkDirToCur(); // Sets the working directory to the actual goddamn location of the EXE instead
                                              // of the freaking start menu, or possibly the desktop. The possibilities are
                                              // endless! Fuck you, windows.
@@ -7,6 +7,8 @@
 #ifdef BUN_COMPILER_MSC
   #include <intrin.h>
   #include <intrin0.inl.h>
+#elif defined(BUN_CPU_x86_64) || defined(BUN_CPU_x86)
+  #include <emmintrin.h>
 #endif
 
 #include "compiler.h"
@@ -69,6 +71,9 @@ namespace bun {
   }
   #pragma warning(pop)
 
+  // Tells the CPU we're inside a spin-wait loop, which saves power and avoids a pipeline flush when the loop exits
+  BUN_FORCEINLINE void CPU_Pause() { _mm_pause(); }
+
   template<typename T>
   BUN_FORCEINLINE bool asmcasr(volatile bun_PTag<T>* dest, bun_PTag<T> newval, bun_PTag<T> oldval, bun_PTag<T>& retval)
   {
@@ -85,7 +90,8 @@ namespace bun {
     return retval.i == oldval.i;
   #endif
   }
-
+#else
+  BUN_FORCEINLINE void CPU_Pause() {}
 #endif
 }
 
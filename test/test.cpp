@@ -101,6 +101,26 @@ int main(int argc, char** argv)
   seed          = 1686163994;
   bun_RandSeed(seed);
   // profile_ring_alloc();
+  // profile_threadpool();
+  // profile_parallel();
+  // profile_mpmc_queue();
+  // profile_spsc_queue();
+  // profile_magazine_alloc();
+  // profile_thread_cache_alloc();
+  // profile_hash();
+  // profile_hash_resize();
+  // profile_hash_batch();
+  // profile_string_hash();
+  // profile_concurrent_hash();
+  // profile_frozen_hash();
+  // profile_hash64();
+  // profile_field_dispatch();
+  // profile_trie();
+  // profile_json();
+  // profile_json_indexed();
+  // profile_json_document();
+  // profile_json_stream();
+  // profile_number_format();
 
   for(uint16_t i = 0; i < TESTNUM; ++i)
     testnums[i] = i;
@@ -114,8 +134,10 @@ int main(int argc, char** argv)
     { "BlockAlloc.h", &test_ALLOC_BLOCK },
     { "BlockAllocMT.h", &test_ALLOC_BLOCK_LOCKLESS },
     { "CacheAlloc.h", &test_ALLOC_CACHE },
+    { "RingAlloc.h", &test_ALLOC_RING },
     { "GreedyAlloc.h", &test_ALLOC_GREEDY },
     { "GreedyBlockAlloc.h", &test_ALLOC_GREEDY_BLOCK },
+    { "ThreadCacheAlloc.h", &test_ALLOC_THREAD_CACHE },
     { "Animation.h", &test_ANIMATION },
     { "Array.h", &test_ARRAY },
     { "ArrayCircular.h", &test_ARRAYCIRCULAR },
@@ -128,15 +150,18 @@ int main(int argc, char** argv)
     { "buntils.h", &test_buntils },
     { "Collision.h", &test_COLLISION },
     { "CompactArray.h", &test_COMPACTARRAY },
+    { "ConcurrentHash.h", &test_CONCURRENTHASH },
     { "depracated.h", &test_deprecated },
     { "Delegate.h", &test_DELEGATE },
     { "DisjointSet.h", &test_DISJOINTSET },
     { "Dual.h", &test_DUAL },
     { "DynArray.h", &test_DYNARRAY },
     { "FixedPt.h", &test_FIXEDPT },
+    { "FrozenHash.h", &test_FROZENHASH },
     { "Geometry.h", &test_GEOMETRY },
     { "Graph.h", &test_GRAPH },
     { "Hash.h", &test_HASH },
+    { "Hash64.h", &test_HASH64 },
     { "HighPrecisionTimer.h", &test_HIGHPRECISIONTIMER },
     { "INIstorage.h", &test_INISTORAGE },
     { "JSON.h", &test_JSON },
@@ -149,6 +174,7 @@ int main(int argc, char** argv)
     { "Log.h", &test_LOG },
     { "Map.h", &test_MAP },
     { "os.h", &test_OS },
+    { "Parallel.h", &test_PARALLEL },
     { "PriorityQueue.h", &test_PRIORITYQUEUE },
     { "profile.h", &test_PROFILE },
     { "Queue.h", &test_BUN_QUEUE },
@@ -157,12 +183,14 @@ int main(int argc, char** argv)
     { "RefCounter.h", &test_REFCOUNTER },
     { "RWLock.h", &test_RWLOCK },
     { "Scheduler.h", &test_SCHEDULER },
+    { "Serializer.h", &test_Serializer },
     { "Singleton.h", &test_SINGLETON },
     { "sseVec.h", &test_SSE },
     { "Stack.h", &test_BUN_STACK },
     { "Str.h", &test_STR },
     { "stream.h", &test_STREAM },
     { "StringTable.h", &test_STRTABLE },
+    { "TaskGraph.h", &test_TASKGRAPH },
     { "Thread.h", &test_THREAD },
     { "ThreadPool.h", &test_THREADPOOL },
     { "TOML.h", &test_TOML },
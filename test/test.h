@@ -225,6 +225,7 @@ TESTDEF::RETPAIR test_ALLOC_CACHE();
 TESTDEF::RETPAIR test_ALLOC_RING();
 TESTDEF::RETPAIR test_ALLOC_GREEDY();
 TESTDEF::RETPAIR test_ALLOC_GREEDY_BLOCK();
+TESTDEF::RETPAIR test_ALLOC_THREAD_CACHE();
 TESTDEF::RETPAIR test_deprecated();
 TESTDEF::RETPAIR test_GRAPH();
 TESTDEF::RETPAIR test_LOG();
@@ -238,8 +239,11 @@ TESTDEF::RETPAIR test_DISJOINTSET();
 TESTDEF::RETPAIR test_DUAL();
 TESTDEF::RETPAIR test_DYNARRAY();
 TESTDEF::RETPAIR test_FIXEDPT();
+TESTDEF::RETPAIR test_FROZENHASH();
 TESTDEF::RETPAIR test_GEOMETRY();
 TESTDEF::RETPAIR test_HASH();
+TESTDEF::RETPAIR test_HASH64();
+TESTDEF::RETPAIR test_CONCURRENTHASH();
 TESTDEF::RETPAIR test_HIGHPRECISIONTIMER();
 TESTDEF::RETPAIR test_INISTORAGE();
 TESTDEF::RETPAIR test_JSON();
@@ -251,6 +255,7 @@ TESTDEF::RETPAIR test_LOCKLESS();
 TESTDEF::RETPAIR test_LOCKLESSQUEUE();
 TESTDEF::RETPAIR test_MAP();
 TESTDEF::RETPAIR test_OS();
+TESTDEF::RETPAIR test_PARALLEL();
 TESTDEF::RETPAIR test_PRIORITYQUEUE();
 TESTDEF::RETPAIR test_PROFILE();
 TESTDEF::RETPAIR test_BUN_QUEUE();
@@ -265,6 +270,7 @@ TESTDEF::RETPAIR test_BUN_STACK();
 TESTDEF::RETPAIR test_STR();
 TESTDEF::RETPAIR test_STREAM();
 TESTDEF::RETPAIR test_STRTABLE();
+TESTDEF::RETPAIR test_TASKGRAPH();
 TESTDEF::RETPAIR test_THREAD();
 TESTDEF::RETPAIR test_THREADPOOL();
 TESTDEF::RETPAIR test_TOML();
@@ -274,4 +280,27 @@ TESTDEF::RETPAIR test_UBJSON();
 TESTDEF::RETPAIR test_VARIANT();
 TESTDEF::RETPAIR test_XML();
 
+// Benchmarks are not part of the test run, uncomment them at the top of main() to profile a specific component.
+void profile_ring_alloc();
+void profile_threadpool();
+void profile_parallel();
+void profile_mpmc_queue();
+void profile_spsc_queue();
+void profile_magazine_alloc();
+void profile_thread_cache_alloc();
+void profile_hash();
+void profile_hash_resize();
+void profile_hash_batch();
+void profile_string_hash();
+void profile_concurrent_hash();
+void profile_frozen_hash();
+void profile_hash64();
+void profile_field_dispatch();
+void profile_trie();
+void profile_json();
+void profile_json_indexed();
+void profile_json_document();
+void profile_json_stream();
+void profile_number_format();
+
 #endif
\ No newline at end of file
@@ -3,8 +3,10 @@
 
 #include "test.h"
 #include "buntils/BlockAllocMT.h"
+#include "buntils/HighPrecisionTimer.h"
 #include "buntils/Thread.h"
 #include "test_alloc.h"
+#include <iostream>
 
 using namespace bun;
 
@@ -14,6 +16,12 @@ template<class T> struct MTALLOCWRAP : LocklessBlockPolicy<T>
   inline void Clear() {}
 };
 
+template<class T> struct MAGALLOCWRAP : MagazineBlockPolicy<T>
+{
+  inline MAGALLOCWRAP(size_t init = 8) : MagazineBlockPolicy<T>(init, 4) {} // Tiny magazines exercise the depot
+  inline void Clear() {}
+};
+
 template<class T, size_t MAXSIZE = 32> class BUN_COMPILER_DLLEXPORT LocklessBlockCollectionPolicy
 {
 public:
@@ -50,7 +58,80 @@ TESTDEF::RETPAIR test_ALLOC_BLOCK_LOCKLESS()
     alloc.deallocate(p, 50);
   }
 
+  TEST_ALLOC_MT<MAGALLOCWRAP, size_t, 1, 50000, size_t>(__testret, 10000);
+  TEST_ALLOC_MT<MAGALLOCWRAP, size_t, 1, 20000>(__testret);
+
+  {
+    MagazineBlockPolicy<size_t> alloc(8, 4);
+    size_t* p[12];
+    for(auto& i : p)
+      i = alloc.allocate(1);
+    auto stats = alloc.GetStats();
+    TEST(stats.misses == 12);
+    TEST(stats.magazines == 2);
+    for(auto& i : p)
+      alloc.deallocate(i, 1); // Fills both magazines, then sends one full magazine to the depot
+    stats = alloc.GetStats();
+    TEST(stats.unloads == 1);
+    TEST(stats.magazines == 3);
+    bool check = true;
+    for(size_t i = 12; i-- > 0;)
+      check = check && (p[i] == alloc.allocate(1)); // Reuses the freed blocks in LIFO order
+    TEST(check);
+    stats = alloc.GetStats();
+    TEST(stats.loads == 1);
+    TEST(stats.misses == 12);
+    alloc.Clear();
+    TEST(alloc.allocate(1) != nullptr);
+  }
+
   TEST_ALLOC_FUZZER<LocklessBlockCollectionPolicy, std::byte, 400, 10000>(__testret);
   TEST_ALLOC_MT<LocklessBlockCollectionPolicy, std::byte, 400, 10000>(__testret);
   ENDTEST;
-}
\ No newline at end of file
+}
+
+template<class ALLOC> void _profile_block_churn(ALLOC* alloc, size_t iterations)
+{
+  while(!startflag.load())
+    ;
+  void* blocks[64];
+  for(size_t k = 0; k < iterations; ++k)
+  {
+    for(auto& p : blocks)
+      p = alloc->alloc(1);
+    for(auto& p : blocks)
+      alloc->dealloc(p);
+  }
+}
+
+template<class ALLOC> double _profile_block_alloc(ALLOC& alloc, size_t threads)
+{
+  const size_t ITERATIONS = 20000;
+  VARARRAY(Thread, workers, threads);
+  startflag.store(false);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i] = Thread(_profile_block_churn<ALLOC>, &alloc, ITERATIONS);
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  startflag.store(true);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i].join();
+  return HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+}
+
+// Compares LocklessBlockAllocator against MagazineBlockAllocator when several threads churn through blocks at once.
+void profile_magazine_alloc()
+{
+  for(size_t threads = 1; threads <= 32; threads <<= 1)
+  {
+    LocklessBlockAllocator lockless(sizeof(void*) * 4);
+    std::cout << "LocklessBlockAllocator " << threads << " threads: " << _profile_block_alloc(lockless, threads) << " ms"
+              << std::endl;
+
+    MagazineBlockAllocator magazine(sizeof(void*) * 4);
+    double ms  = _profile_block_alloc(magazine, threads);
+    auto stats = magazine.GetStats();
+    std::cout << "MagazineBlockAllocator " << threads << " threads: " << ms << " ms (" << stats.loads << " loads, "
+              << stats.unloads << " unloads, " << stats.misses << " misses, " << stats.magazines << " magazines)"
+              << std::endl;
+  }
+}
@@ -0,0 +1,175 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/RingAlloc.h"
+#include "buntils/GreedyAlloc.h"
+#include "buntils/HighPrecisionTimer.h"
+#include "buntils/Thread.h"
+#include "test_alloc.h"
+#include <iostream>
+
+using namespace bun;
+
+TESTDEF::RETPAIR test_ALLOC_RING()
+{
+  BEGINTEST;
+  TEST_ALLOC_FUZZER<RingPolicy, char, 400, 10000>(__testret);
+  TEST_ALLOC_FUZZER<RingPolicy, char, 400, 10000, size_t>(__testret, 256); // Tiny buckets force dedicated buckets
+  TEST_ALLOC_MT<RingPolicyMT, char, 400, 10000>(__testret);
+  TEST_ALLOC_MT<RingPolicyMT, size_t, 400, 10000, size_t>(__testret, 1024);
+
+  {
+    RingAlloc alloc(4096);
+    void* p = alloc.Alloc(100);
+    alloc.Dealloc(p);
+    TEST(alloc.Alloc(100) == p); // A completely free current bucket starts over from the beginning
+
+    void* held = alloc.Alloc(8); // Keeps the first bucket alive while frames cycle through the rest
+    void* frame[100];
+    for(int k = 0; k < 50; ++k)
+    {
+      for(auto& f : frame)
+        f = alloc.Alloc(100);
+      for(auto& f : frame)
+        alloc.Dealloc(f);
+    }
+    auto stats = alloc.GetStats();
+    TEST(stats.buckets <= 5);
+    TEST(stats.recycled > 50);
+    alloc.Dealloc(held);
+    alloc.Dealloc(p);
+
+    void* big = alloc.Alloc(10000);
+    TEST(alloc.GetStats().buckets == stats.buckets + 1);
+    alloc.Dealloc(big);
+    TEST(alloc.GetStats().buckets == stats.buckets);
+  }
+
+  {
+    RingAllocMT alloc(4096);
+    constexpr size_t NUM  = 2000;
+    constexpr int THREADS = 4;
+    void* blocks[THREADS][NUM];
+    bool check = true;
+
+    for(int round = 0; round < 3; ++round)
+    {
+      Thread threads[THREADS];
+      for(int i = 0; i < THREADS; ++i)
+        threads[i] = Thread([&, i]() {
+          for(auto& b : blocks[i])
+            memset(b = alloc.Alloc(64), i, 64);
+        });
+      for(auto& t : threads)
+        t.join();
+
+      for(int i = 0; i < THREADS; ++i) // Frees everything from a different thread than the one that allocated it
+        for(auto b : blocks[i])
+        {
+          check = check && reinterpret_cast<uint8_t*>(b)[63] == i;
+          alloc.Dealloc(b);
+        }
+    }
+    TEST(check);
+    auto stats = alloc.GetStats();
+    TEST(stats.recycled > 0);
+    TEST(stats.buckets < (NUM * THREADS * 80 * 2) / 4096); // Later rounds reuse the buckets from the first one
+  }
+  ENDTEST;
+}
+
+template<class F> double _profile_frames(size_t threads, F&& f)
+{
+  VARARRAY(Thread, workers, threads);
+  startflag.store(false);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i] = Thread([&f]() {
+      while(!startflag.load())
+        ;
+      f();
+    });
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  startflag.store(true);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i].join();
+  return HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+}
+
+// Simulates frame scoped scratch memory: every frame makes a few hundred allocations of mixed sizes, then frees them all.
+// GreedyAlloc can only free everything at once, so it's only compared on a single thread.
+void profile_ring_alloc()
+{
+  constexpr size_t FRAMES = 2000;
+  constexpr size_t ALLOCS = 256;
+  size_t sizes[ALLOCS];
+  for(auto& sz : sizes)
+    sz = (size_t)bun_RandInt(16, 2048);
+
+  {
+    void* p[ALLOCS];
+    double ms = _profile_frames(1, [&]() {
+      for(size_t k = 0; k < FRAMES; ++k)
+      {
+        for(size_t i = 0; i < ALLOCS; ++i)
+          p[i] = malloc(sizes[i]);
+        for(auto i : p)
+          free(i);
+      }
+    });
+    std::cout << "malloc 1 thread: " << ms << " ms" << std::endl;
+
+    GreedyAlloc greedy(1 << 20, alignof(std::max_align_t));
+    ms = _profile_frames(1, [&]() {
+      for(size_t k = 0; k < FRAMES; ++k)
+      {
+        for(size_t i = 0; i < ALLOCS; ++i)
+          p[i] = greedy.Alloc(sizes[i]);
+        greedy.Clear();
+      }
+    });
+    std::cout << "GreedyAlloc 1 thread: " << ms << " ms" << std::endl;
+
+    RingAlloc ring;
+    ms = _profile_frames(1, [&]() {
+      for(size_t k = 0; k < FRAMES; ++k)
+      {
+        for(size_t i = 0; i < ALLOCS; ++i)
+          p[i] = ring.Alloc(sizes[i]);
+        for(auto i : p)
+          ring.Dealloc(i);
+      }
+    });
+    std::cout << "RingAlloc 1 thread: " << ms << " ms (" << ring.GetStats().buckets << " buckets)" << std::endl;
+  }
+
+  for(size_t threads = 1; threads <= 16; threads <<= 1)
+  {
+    double ms = _profile_frames(threads, [&]() {
+      void* p[ALLOCS];
+      for(size_t k = 0; k < FRAMES; ++k)
+      {
+        for(size_t i = 0; i < ALLOCS; ++i)
+          p[i] = malloc(sizes[i]);
+        for(auto i : p)
+          free(i);
+      }
+    });
+    std::cout << "malloc " << threads << " threads: " << ms << " ms" << std::endl;
+
+    RingAllocMT ring;
+    ms = _profile_frames(threads, [&]() {
+      void* p[ALLOCS];
+      for(size_t k = 0; k < FRAMES; ++k)
+      {
+        for(size_t i = 0; i < ALLOCS; ++i)
+          p[i] = ring.Alloc(sizes[i]);
+        for(auto i : p)
+          ring.Dealloc(i);
+      }
+    });
+    auto stats = ring.GetStats();
+    std::cout << "RingAllocMT " << threads << " threads: " << ms << " ms (" << stats.buckets << " buckets, "
+              << stats.recycled << " recycled)" << std::endl;
+  }
+}
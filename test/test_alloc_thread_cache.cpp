@@ -0,0 +1,159 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/ThreadCacheAlloc.h"
+#include "buntils/Hash.h"
+#include "buntils/HighPrecisionTimer.h"
+#include "buntils/Str.h"
+#include "buntils/Thread.h"
+#include "test_alloc.h"
+#include <iostream>
+
+using namespace bun;
+
+template<class T> class ThreadCacheCollectionPolicy
+{
+public:
+  inline T* allocate(size_t num, T* p = nullptr, size_t old = 0) noexcept
+  {
+    return reinterpret_cast<T*>(_collection.allocate(num * sizeof(T), p, old * sizeof(T)));
+  }
+  inline void deallocate(T* p, size_t num = 0) noexcept { _collection.deallocate(p, num * sizeof(T)); }
+  inline void Clear() noexcept { _collection.Clear(); }
+
+protected:
+  ThreadCacheCollection<> _collection;
+};
+
+TESTDEF::RETPAIR test_ALLOC_THREAD_CACHE()
+{
+  BEGINTEST;
+  TEST_ALLOC_FUZZER<ThreadCacheCollectionPolicy, std::byte, 600, 10000>(__testret);
+  TEST_ALLOC_MT<ThreadCacheCollectionPolicy, std::byte, 600, 10000>(__testret);
+  TEST_ALLOC_MT<ThreadCacheCollectionPolicy, size_t, 800, 10000>(__testret); // Goes past MAXSIZE into malloc
+
+  {
+    ThreadCacheCollection<> alloc;
+    char* p = alloc.allocT<char>(5);
+    memcpy(p, "test", 5);
+    size_t sizes[] = { 5, 9, 17, 100, 3000, 9000, 20000, 64, 5 };
+    bool check     = true;
+    for(size_t i = 1; i < sizeof(sizes) / sizeof(size_t); ++i)
+    {
+      p     = reinterpret_cast<char*>(alloc.allocate(sizes[i], p, sizes[i - 1]));
+      check = check && !strcmp(p, "test");
+    }
+    TEST(check);
+    alloc.deallocate(p, 5);
+  }
+
+  {
+    ThreadCacheCollection<> alloc;
+    constexpr size_t NUM = 20000;
+    DynArray<void*> blocks(NUM);
+    for(size_t i = 0; i < NUM; ++i)
+      blocks.Add(alloc.allocate(64));
+    auto stats  = alloc.GetStats();
+    size_t peak = stats.spans;
+    TEST(peak >= (NUM * 64) / (1 << 16));
+    TEST(stats.fetches > 1);
+    for(auto p : blocks)
+      alloc.deallocate(p, 64);
+    stats = alloc.GetStats();
+    TEST(stats.releases > 1);
+    TEST(stats.returned > 0);
+    TEST(stats.spans < peak / 4); // Only the spare and whatever spans the thread cache is still holding blocks from
+  }
+
+  {
+    DynArray<int, size_t, ThreadCacheAllocator<int>> arr;
+    for(int i = 0; i < 10000; ++i)
+      arr.Add(i);
+    bool check = true;
+    for(int i = 0; i < 10000; ++i)
+      check = check && arr[i] == i;
+    TEST(check);
+
+    Hash<int, int, &KH_AUTO_HASH<int, false>, &KH_AUTO_EQUAL<int, false>, ThreadCacheAllocator<std::byte>> hash;
+    for(int i = 0; i < 1000; ++i)
+      hash.Insert(i, i * 2);
+    check = true;
+    for(int i = 0; i < 1000; ++i)
+      check = check && hash[i] == i * 2;
+    TEST(check);
+
+    StrT<char, ThreadCacheAllocator<char>> s("a long string that doesn't fit in the small string buffer");
+    s += s;
+    TEST(s.length() == 114);
+
+    ThreadCachePolicy<int> policy;
+    DynArray<int, size_t, PolicyAllocator<int, ThreadCachePolicy>> parr(0, PolicyAllocator<int, ThreadCachePolicy>(policy));
+    for(int i = 0; i < 1000; ++i)
+      parr.Add(i);
+    TEST(parr.Back() == 999);
+
+    int* block = policy.allocate(10);
+    policy.deallocate(block); // Without a size, the size class comes from the block's span
+    TEST(policy.allocate(10) == block);
+    policy.deallocate(block, 10);
+  }
+  ENDTEST;
+}
+
+template<class F> double _profile_general_alloc(size_t threads, F&& f)
+{
+  VARARRAY(Thread, workers, threads);
+  startflag.store(false);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i] = Thread([&f]() {
+      while(!startflag.load())
+        ;
+      f();
+    });
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  startflag.store(true);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i].join();
+  return HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+}
+
+// Compares ThreadCacheCollection against malloc when several threads churn through mixed sizes at once.
+void profile_thread_cache_alloc()
+{
+  constexpr size_t ITERATIONS = 20000;
+  constexpr size_t BLOCKS     = 64;
+  size_t sizes[BLOCKS];
+  for(auto& sz : sizes)
+    sz = (size_t)bun_RandInt(8, 1024);
+
+  for(size_t threads = 1; threads <= 32; threads <<= 1)
+  {
+    double ms = _profile_general_alloc(threads, [&]() {
+      void* blocks[BLOCKS];
+      for(size_t k = 0; k < ITERATIONS; ++k)
+      {
+        for(size_t i = 0; i < BLOCKS; ++i)
+          blocks[i] = malloc(sizes[i]);
+        for(auto p : blocks)
+          free(p);
+      }
+    });
+    std::cout << "malloc " << threads << " threads: " << ms << " ms" << std::endl;
+
+    ThreadCacheCollection<> alloc;
+    ms = _profile_general_alloc(threads, [&]() {
+      void* blocks[BLOCKS];
+      for(size_t k = 0; k < ITERATIONS; ++k)
+      {
+        for(size_t i = 0; i < BLOCKS; ++i)
+          blocks[i] = alloc.allocate(sizes[i]);
+        for(size_t i = 0; i < BLOCKS; ++i)
+          alloc.deallocate(blocks[i], sizes[i]);
+      }
+    });
+    auto stats = alloc.GetStats();
+    std::cout << "ThreadCacheCollection " << threads << " threads: " << ms << " ms (" << stats.fetches << " fetches, "
+              << stats.releases << " releases, " << stats.returned << " spans returned)" << std::endl;
+  }
+}
@@ -0,0 +1,216 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/ConcurrentHash.h"
+#include "buntils/HighPrecisionTimer.h"
+#include "buntils/Thread.h"
+#include "buntils/XorshiftEngine.h"
+#include <iostream>
+
+using namespace bun;
+
+TESTDEF::RETPAIR test_CONCURRENTHASH()
+{
+  BEGINTEST;
+
+  {
+    ConcurrentHash<uint64_t, uint64_t> hash;
+    uint64_t v = 0;
+    TEST(!hash.Get(5, v));
+    TEST(hash.Insert(5, 10));
+    TEST(!hash.Insert(5, 11));
+    TEST(hash.Get(5, v) && v == 11);
+    TEST(hash.Exists(5));
+    TEST(hash.GetOrInsert(5, 20) == 11);
+    TEST(hash.GetOrInsert(6, 20) == 20);
+    TEST(hash.GetOrInsert(7, []() -> uint64_t { return 30; }) == 30);
+    TEST(hash.Update(7, [](uint64_t& x) { ++x; }));
+    TEST(!hash.Update(8, [](uint64_t& x) { ++x; }));
+    TEST(hash.Get(7, v) && v == 31);
+    TEST(hash.Remove(6));
+    TEST(!hash.Remove(6));
+    TEST(hash.size() == 2);
+
+    for(uint64_t i = 0; i < 10000; ++i)
+      hash.Insert(i, i * 2);
+    for(uint64_t i = 0; i < 10000; i += 2)
+      hash.Remove(i);
+    for(uint64_t i = 0; i < 10000; i += 2) // Churn through deleted buckets to force rebuilds
+      hash.Insert(i + 10000, i);
+    bool check = true;
+    for(uint64_t i = 1; i < 10000; i += 2)
+      check = check && hash.Get(i, v) && v == i * 2;
+    TEST(check);
+    TEST(hash.size() == 10000);
+
+    size_t count = 0;
+    uint64_t sum = 0;
+    hash.ForEach([&](const uint64_t& k, const uint64_t&) {
+      ++count;
+      sum += k;
+    });
+    TEST(count == 10000);
+    TEST(sum == 99995000);
+
+    hash.Reclaim();
+    TEST(hash.Get(9999, v) && v == 9999 * 2);
+    hash.Clear();
+    TEST(hash.size() == 0);
+    TEST(!hash.Exists(9999));
+  }
+
+  {
+    ConcurrentHash<int, Str, &KH_AUTO_HASH<int, false>, &KH_AUTO_EQUAL<int, false>, StandardAllocator<std::byte>, 4> hash;
+    for(int i = 0; i < 100; ++i)
+      hash.Insert(i, Str("value"));
+    TEST(hash.Update(3, [](Str& s) { s += "!"; }));
+    Str s;
+    TEST(hash.Get(3, s) && s == "value!");
+    TEST(hash.GetOrInsert(200, "new") == "new");
+    TEST(hash.size() == 101);
+  }
+
+  {
+    constexpr int THREADS  = 4;
+    constexpr uint64_t NUM = 20000;
+    ConcurrentHash<uint64_t, uint64_t> hash;
+    std::atomic<bool> done(false);
+    std::atomic<size_t> torn(0);
+    Thread threads[THREADS];
+    Thread readers[2];
+
+    for(auto& r : readers) // Readers race writers that keep growing the shards, and must never see a bad value
+      r = Thread([&]() {
+        uint64_t v;
+        while(!done.load(std::memory_order_relaxed))
+          for(uint64_t i = 0; i < NUM * THREADS; i += 7)
+            if(hash.Get(i, v) && v != i * 3)
+              torn.fetch_add(1, std::memory_order_relaxed);
+      });
+    for(int t = 0; t < THREADS; ++t)
+      threads[t] = Thread([&, t]() {
+        for(uint64_t i = t * NUM; i < (t + 1) * NUM; ++i)
+          hash.Insert(i, i * 3);
+        for(uint64_t i = NUM * THREADS; i < NUM * THREADS + 1000; ++i) // Every thread bumps the same counters
+        {
+          hash.GetOrInsert(i, 0);
+          hash.Update(i, [](uint64_t& x) { ++x; });
+        }
+      });
+    for(auto& t : threads)
+      t.join();
+    done.store(true);
+    for(auto& r : readers)
+      r.join();
+
+    TEST(!torn.load());
+    TEST(hash.size() == NUM * THREADS + 1000);
+    bool check = true;
+    uint64_t v;
+    for(uint64_t i = 0; i < NUM * THREADS; ++i)
+      check = check && hash.Get(i, v) && v == i * 3;
+    TEST(check);
+    check = true;
+    for(uint64_t i = 0; i < 1000; ++i)
+      check = check && hash.Get(NUM * THREADS + i, v) && v == THREADS;
+    TEST(check);
+  }
+
+  {
+    ConcurrentHash<int, int> hash;
+    int results[8];
+    Thread threads[8];
+    for(int t = 0; t < 8; ++t)
+      threads[t] = Thread([&, t]() { results[t] = hash.GetOrInsert(42, t); });
+    for(auto& t : threads)
+      t.join();
+    int v = -1;
+    TEST(hash.Get(42, v));
+    bool check = true;
+    for(auto r : results)
+      check = check && r == v;
+    TEST(check); // Whichever thread won, every thread got its value back
+  }
+  ENDTEST;
+}
+
+template<class F> double _profile_concurrent_hash(size_t threads, F&& f)
+{
+  VARARRAY(Thread, workers, threads);
+  startflag.store(false);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i] = Thread([&f, i]() {
+      while(!startflag.load())
+        ;
+      f(i);
+    });
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  startflag.store(true);
+  for(size_t i = 0; i < threads; ++i)
+    workers[i].join();
+  return HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+}
+
+// Compares a single Hash behind one RWLock against ConcurrentHash, with each thread doing a mix of lookups and inserts on
+// a shared set of keys.
+void profile_concurrent_hash()
+{
+  constexpr uint64_t KEYS = 1 << 16;
+  constexpr size_t OPS    = 200000;
+
+  for(int writes : { 1, 10, 50 })
+  {
+    for(size_t threads = 1; threads <= 16; threads <<= 1)
+    {
+      Hash<uint64_t, uint64_t> single;
+      RWLock lock;
+      for(uint64_t i = 0; i < KEYS; i += 2)
+        single.Insert(i, i);
+
+      double ms = _profile_concurrent_hash(threads, [&](size_t t) {
+        XorshiftEngine<uint64_t> rng(t + 1);
+        uint64_t sum = 0;
+        for(size_t k = 0; k < OPS; ++k)
+        {
+          uint64_t key = rng() & (KEYS - 1);
+          if((int)(rng() % 100) < writes)
+          {
+            lock.Lock();
+            single.Insert(key, k);
+            lock.Unlock();
+          }
+          else
+          {
+            lock.RLock();
+            sum += single.Get(key);
+            lock.RUnlock();
+          }
+        }
+        if(sum == 1)
+          std::cout << sum;
+      });
+      std::cout << "RWLock<Hash> " << writes << "% writes, " << threads << " threads: " << ms << " ms" << std::endl;
+
+      ConcurrentHash<uint64_t, uint64_t> concurrent;
+      for(uint64_t i = 0; i < KEYS; i += 2)
+        concurrent.Insert(i, i);
+
+      ms = _profile_concurrent_hash(threads, [&](size_t t) {
+        XorshiftEngine<uint64_t> rng(t + 1);
+        uint64_t sum = 0, v;
+        for(size_t k = 0; k < OPS; ++k)
+        {
+          uint64_t key = rng() & (KEYS - 1);
+          if((int)(rng() % 100) < writes)
+            concurrent.Insert(key, k);
+          else if(concurrent.Get(key, v))
+            sum += v;
+        }
+        if(sum == 1)
+          std::cout << sum;
+      });
+      std::cout << "ConcurrentHash " << writes << "% writes, " << threads << " threads: " << ms << " ms" << std::endl;
+    }
+  }
+}
@@ -0,0 +1,166 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/FrozenHash.h"
+#include "buntils/HighPrecisionTimer.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace bun;
+
+TESTDEF::RETPAIR test_FROZENHASH()
+{
+  BEGINTEST;
+
+  {
+    Hash<uint64_t, uint64_t> source;
+    for(uint64_t i = 0; i < 10000; ++i)
+      source.Insert(i * 7919, i);
+    FrozenHash<uint64_t, uint64_t> frozen(source);
+    TEST(frozen.size() == 10000);
+    bool check = true;
+    for(uint64_t i = 0; i < 10000; ++i)
+      check = check && frozen.Get(i * 7919) && *frozen.Get(i * 7919) == i;
+    TEST(check);
+    check = true;
+    for(uint64_t i = 0; i < 10000; ++i)
+      check = check && !frozen.Exists(i * 7919 + 1);
+    TEST(check);
+    TEST(!frozen.Get(3));
+    TEST(frozen.Iterator(3) == frozen.size());
+
+    check = true; // Every key must land in its own slot
+    for(size_t i = 0; i < frozen.size(); ++i)
+      check = check && frozen.Iterator(frozen.GetKey(i)) == i && *frozen.GetValue(i) == frozen.GetKey(i) / 7919;
+    TEST(check);
+
+    std::stringstream ss;
+    frozen.Save(ss);
+    FrozenHash<uint64_t, uint64_t> loaded;
+    TEST(loaded.Load(ss));
+    TEST(loaded.IsOwner());
+    TEST(loaded.size() == 10000);
+    TEST(*loaded.Get(7919 * 5000) == 5000);
+
+    FrozenHash<uint64_t, uint64_t> borrowed(frozen.Blob());
+    TEST(!borrowed.IsOwner());
+    TEST(borrowed.Blob().data() == frozen.Blob().data());
+    TEST(*borrowed.Get(7919 * 42) == 42);
+    FrozenHash<uint64_t, uint64_t> copy(loaded);
+    TEST(copy.Blob().data() != loaded.Blob().data());
+    TEST(*copy.Get(7919 * 42) == 42);
+
+    FrozenHash<uint32_t, uint64_t> wrongtype;
+    TEST(!wrongtype.Load(frozen.Blob()));
+    TEST(wrongtype.size() == 0);
+    TEST(!wrongtype.Exists(5));
+  }
+
+  {
+    std::vector<std::pair<Str, Str>> strings;
+    for(int i = 0; i < 2000; ++i)
+      strings.emplace_back(Str("msg.") + std::to_string(i).c_str(), Str("Message #") + std::to_string(i).c_str());
+    strings.emplace_back("", "empty");
+    FrozenHash<Str, Str> frozen(strings.begin(), strings.end());
+    TEST(frozen.size() == 2001);
+    bool check = true;
+    for(auto& [k, v] : strings)
+      check = check && frozen.Get(k) == std::string_view(v.c_str());
+    TEST(check);
+    TEST(frozen.Get("") == "empty");
+    TEST(frozen.Get(std::string_view("msg.1999 trailing", 8)) == "Message #1999");
+    TEST(frozen.Get("msg.10x", 6) == "Message #10");
+    TEST(!frozen.Get("msg.2000").data());
+    TEST(frozen.GetValue(frozen.Iterator("msg.7")).data()[10] == 0); // Strings in the pool are null-terminated
+
+    std::stringstream ss;
+    frozen.Save(ss);
+    std::string blob = ss.str();
+    std::vector<uint64_t> aligned((blob.size() + 7) / 8); // Stands in for a memory mapped file
+    memcpy(aligned.data(), blob.data(), blob.size());
+    const std::byte* p = reinterpret_cast<const std::byte*>(aligned.data());
+    FrozenHash<Str, Str> mapped(std::span<const std::byte>(p, blob.size()));
+    TEST(mapped.size() == 2001);
+    TEST(mapped.Get("msg.1234") == "Message #1234");
+    TEST(!mapped.Load(std::span<const std::byte>(p, 16)));
+    TEST(!mapped.Load(std::span<const std::byte>(p + 1, blob.size())));
+
+    strings.emplace_back("msg.5", "duplicate");
+    FrozenHash<Str, Str> duplicates(strings.begin(), strings.end());
+    TEST(duplicates.size() == 0);
+  }
+
+  {
+    HashIns<const char*, int> source;
+    source.Insert("Content-Type", 1);
+    source.Insert("Content-Length", 2);
+    source.Insert("Host", 3);
+    FrozenHashIns<const char*, int> frozen(source);
+    TEST(*frozen.Get("content-type") == 1);
+    TEST(*frozen.Get(std::string_view("HOST")) == 3);
+    TEST(frozen.Exists("CONTENT-LENGTH"));
+    TEST(!frozen.Exists("Content"));
+
+    const char* words[] = { "alpha", "beta", "gamma", "delta" };
+    FrozenHash<const char*> set(std::begin(words), std::end(words));
+    TEST(set.size() == 4);
+    TEST(set.Exists("gamma"));
+    TEST(!set.Exists("epsilon"));
+    TEST(set.GetKey(set.Iterator("delta")) == "delta");
+
+    std::pair<int, int>* none = nullptr;
+    FrozenHash<int, int> empty(none, none);
+    TEST(empty.size() == 0);
+    TEST(!empty.Get(0));
+  }
+
+  {
+    FrozenHash<std::wstring, int, true> wide;
+    std::pair<std::wstring, int> items[] = { { L"Straße", 1 }, { L"Ärger", 2 } };
+    TEST(wide.Build(std::begin(items), std::end(items)));
+    TEST(*wide.Get(L"ÄRGER") == 2);
+    TEST(*wide.Get(std::wstring_view(L"STRAßE")) == 1);
+    TEST(!wide.Get(L"Strasse"));
+  }
+  ENDTEST;
+}
+
+// Compares lookups in a frozen table against the Hash it was built from, and the cost of building it against loading it
+void profile_frozen_hash()
+{
+  constexpr int NUM = 1 << 20;
+  Hash<Str, int> source;
+  std::vector<std::string> keys;
+  for(int i = 0; i < NUM; ++i)
+  {
+    keys.push_back("symbol::" + std::to_string(i * 2654435761u));
+    source.Insert(Str(keys.back().c_str()), i);
+  }
+
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  FrozenHash<Str, int> frozen(source);
+  double build  = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+  std::cout << "FrozenHash build: " << build << " ms, " << frozen.Blob().size() << " bytes" << std::endl;
+
+  std::stringstream ss;
+  frozen.Save(ss);
+  prof = HighPrecisionTimer::OpenProfiler();
+  FrozenHash<Str, int> loaded;
+  loaded.Load(ss);
+  std::cout << "FrozenHash load: " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+
+  int64_t sum = 0;
+  prof        = HighPrecisionTimer::OpenProfiler();
+  for(auto& k : keys)
+    sum += source.Get(std::string_view(k));
+  std::cout << "Hash lookup: " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+
+  prof = HighPrecisionTimer::OpenProfiler();
+  for(auto& k : keys)
+    sum += *frozen.Get(std::string_view(k));
+  std::cout << "FrozenHash lookup: " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+  if(sum == 1)
+    std::cout << sum;
+}
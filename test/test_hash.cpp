@@ -3,6 +3,11 @@
 
 #include "test.h"
 #include "buntils/Hash.h"
+#include "buntils/HighPrecisionTimer.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
 
 using namespace bun;
 
@@ -244,5 +249,451 @@ TESTDEF::RETPAIR test_HASH()
     TEST(h[2] == 0);
     static_assert(std::is_same<decltype(h[0]), int*>::value, "wrong GET type");
   }
+  {
+    SwissHash<int, int> swiss;
+    std::unordered_map<int, int> check;
+    bool pass = true;
+    for(int k = 0; k < 50000; ++k)
+    {
+      int key = (int)bun_RandInt(-2000, 2000); // A small key range forces plenty of removals and reinsertions
+      if(bun_RandInt(0, 3) != 0)
+      {
+        swiss.Insert(key, k);
+        check[key] = k;
+      }
+      else
+        pass = pass && (swiss.Remove(key) == (check.erase(key) > 0));
+    }
+    TEST(pass);
+    TEST(swiss.size() == check.size());
+    for(int key = -2000; key < 2000; ++key)
+    {
+      auto i = check.find(key);
+      pass   = pass && (swiss[key] == ((i == check.end()) ? -1 : i->second));
+    }
+    TEST(pass);
+    size_t count = 0;
+    for(auto [k, v] : swiss)
+      pass = pass && (check[k] == v && ++count);
+    TEST(pass);
+    TEST(count == check.size());
+
+    SwissHash<int, int> copy(swiss);
+    TEST(copy.size() == swiss.size());
+    TEST(copy[check.begin()->first] == check.begin()->second);
+    SwissHash<int, int> moved(std::move(copy));
+    TEST(moved.size() == swiss.size());
+    TEST(!copy.size());
+    swiss.Clear();
+    TEST(!swiss.size());
+    TEST(!swiss.Exists(check.begin()->first));
+    swiss.Insert(3, 4);
+    TEST(swiss[3] == 4);
+  }
+  {
+    SwissHash<Str, DEBUG_CDT<true>> swiss;
+    for(int i = 0; i < 64; ++i)
+      swiss.Insert(Str("key") + std::to_string(i).c_str(), DEBUG_CDT<true>());
+    for(int i = 0; i < 64; i += 2)
+      swiss.Remove(Str("key") + std::to_string(i).c_str());
+    TEST(swiss.size() == 32);
+    TEST(swiss(Str("key1")));
+    TEST(!swiss(Str("key2")));
+    TEST(DEBUG_CDT<true>::count == 32);
+    swiss.Clear();
+    TEST(DEBUG_CDT<true>::count == 0);
+
+    SwissHash<const char*> set;
+    set.Insert("a");
+    set.Insert("b");
+    set.Insert("a");
+    TEST(set.size() == 2);
+    TEST(set.Exists("b"));
+  }
+  {
+    IncrementalHash<int, int> inc;
+    inc.SetMigrationStep(1); // Keeps a migration going for as long as possible
+    std::unordered_map<int, int> check;
+    bool pass = true, migrated = false;
+    for(int k = 0; k < 50000; ++k)
+    {
+      int key = (int)bun_RandInt(-4000, 4000);
+      if(bun_RandInt(0, 3) != 0)
+      {
+        inc.Insert(key, k);
+        check[key] = k;
+      }
+      else
+        pass = pass && (inc.Remove(key) == (check.erase(key) > 0));
+      pass     = pass && (inc[key] == (check.count(key) ? check[key] : -1));
+      migrated = migrated || inc.IsMigrating();
+    }
+    TEST(pass);
+    TEST(migrated);
+    TEST(inc.size() == check.size());
+
+    for(int i = 0; i < 10000 && !inc.IsMigrating(); ++i)
+    {
+      inc.Insert(i + 10000, i);
+      check[i + 10000] = i;
+    }
+    TEST(inc.IsMigrating());
+    size_t count = 0;
+    for(auto [k, v] : inc) // Iterating covers both the old and new buckets
+      pass = pass && (check[k] == v && ++count);
+    TEST(pass);
+    TEST(count == check.size());
+
+    khiter_t old = inc.Back();
+    for(auto [k, v] : check) // Finds a key that hasn't been moved yet
+      if((old = inc.Iterator(k)) > inc.Capacity())
+        break;
+    TEST(old > inc.Capacity());
+    TEST(inc.ExistsIter(old));
+    TEST(inc.SetValue(old, 12345));
+    TEST(inc[inc.GetKey(old)] == 12345);
+    check[inc.GetKey(old)] = 12345;
+
+    IncrementalHash<int, int> copy(inc);
+    TEST(!copy.IsMigrating());
+    TEST(copy.size() == check.size());
+    for(auto [k, v] : check)
+      pass = pass && copy[k] == v;
+    TEST(pass);
+
+    int removed = inc.GetKey(old);
+    TEST(inc.RemoveIter(old));
+    TEST(!inc.Exists(removed));
+    check.erase(removed);
+
+    IncrementalHash<int, int> moved(std::move(inc));
+    TEST(!inc.size());
+    TEST(moved.size() == check.size());
+    while(moved.Migrate(100))
+      ;
+    TEST(!moved.IsMigrating());
+    for(auto [k, v] : check)
+      pass = pass && moved[k] == v;
+    TEST(pass);
+  }
+  {
+    IncrementalHash<Str, DEBUG_CDT<true>> inc;
+    inc.SetMigrationStep(1);
+    for(int i = 0; i < 64; ++i)
+      inc.Insert(Str("key") + std::to_string(i).c_str(), DEBUG_CDT<true>());
+    for(int i = 0; i < 64; i += 2)
+      inc.Remove(Str("key") + std::to_string(i).c_str());
+    TEST(inc.size() == 32);
+    TEST(inc(Str("key1")));
+    TEST(!inc(Str("key2")));
+    TEST(DEBUG_CDT<true>::count == 32);
+    inc.Clear();
+    TEST(DEBUG_CDT<true>::count == 0);
+  }
+  {
+    // Every way of hashing the same string must agree, or lookups with a different key type would miss
+    const char* text = "The quick brown fox jumps over the lazy dog, then over the lazy dog again";
+    bool pass        = true;
+    for(size_t len = 0; len < strlen(text); ++len)
+    {
+      Str key(text, len);
+      Str lower(key);
+      for(auto& c : lower)
+        c = (char)tolower(c);
+      pass = pass && KH_AUTO_HASH<Str, false>(key) == KH_STR_HASH<char, false>(key.c_str());
+      pass = pass && KH_AUTO_HASH<std::string, false>(std::string(key)) == KH_STR_HASH<char, false>(key.c_str(), len);
+      pass = pass && KH_AUTO_HASH<Str, true>(key) == KH_AUTO_HASH<Str, false>(lower);
+      pass = pass && KH_AUTO_HASH<HashedStr, false>(HashedStr(key)) == KH_AUTO_HASH<Str, false>(key);
+    }
+    TEST(pass);
+    TEST((KH_STR_HASH<char, false>("abc") != KH_STR_HASH<char, false>("abd")));
+    TEST((KH_STR_HASH<char, true>("ABC\xC4") == KH_STR_HASH<char, true>("abc\xC4")));
+    TEST((KH_STR_HASH<char, true>("abc\xC4") != KH_STR_HASH<char, true>("abc\xE4"))); // Only ASCII letters are folded
+    TEST((KH_STR_HASH<char, false>("a\0b", 3) != KH_STR_HASH<char, false>("a\0c", 3)));
+    TEST((KH_STR_HASH<wchar_t, true>(L"ABC") == KH_STR_HASH<wchar_t, true>(L"abc")));
+
+    Hash<HashedStr, int> hashed;
+    for(int i = 0; i < 1000; ++i)
+      hashed.Insert(Str("identifier") + std::to_string(i).c_str(), i);
+    pass = true;
+    for(int i = 0; i < 1000; ++i)
+      pass = pass && hashed[Str("identifier") + std::to_string(i).c_str()] == i;
+    TEST(pass);
+    TEST(!hashed.Exists("identifier"));
+
+    HashIns<HashedKey<Str, true>, int> hashedins;
+    hashedins.Insert("Content-Type", 1);
+    TEST(hashedins["content-type"] == 1);
+    TEST(hashedins["CONTENT-TYPE"] == 1);
+  }
+
+  {
+    const char* text = "alpha beta gamma";
+    Hash<Str, int> hash;
+    hash.Insert("alpha", 1);
+    hash.Insert("beta", 2);
+    TEST(hash.Get(std::string_view(text, 5)) == 1);
+    TEST(hash.Get(text + 6, 4) == 2);
+    TEST(hash.Iterator(text + 6, 4) == hash.Iterator("beta"));
+    TEST(!hash.Exists(text, 4));
+    TEST(!hash.Exists(text + 11, 5));
+    TEST(hash.Exists(HashedKey<std::string_view>(std::string_view(text, 5))));
+    TEST(hash.Remove(std::string_view(text, 5)));
+    TEST(!hash.Remove(text, 5));
+    TEST(hash.size() == 1);
+    TEST((Hash<Str, int>::IsTransparent && !Hash<int, int>::IsTransparent));
+
+    HashIns<const char*, int> ins;
+    ins.Insert("Content-Type", 1);
+    TEST(ins.Get(std::string_view("CONTENT-TYPE: text", 12)) == 1);
+    TEST(ins.Get(HashedKey<std::string_view, true>(std::string_view("content-type"))) == 1);
+    TEST(!ins.Exists("content", 7));
+
+    SwissHash<HashedStr, int> swiss;
+    IncrementalHash<Str, int> incremental;
+    incremental.SetMigrationStep(1);
+    for(int i = 0; i < 1000; ++i)
+    {
+      swiss.Insert(Str("key") + std::to_string(i).c_str(), i);
+      incremental.Insert(Str("key") + std::to_string(i).c_str(), i);
+    }
+    bool pass = true;
+    for(int i = 0; i < 1000; ++i)
+    {
+      std::string key = "key" + std::to_string(i);
+      pass = pass && swiss.Get(std::string_view(key)) == i && incremental.Get(key.data(), key.size()) == i;
+    }
+    TEST(pass);
+    TEST(!swiss.Exists(std::string_view("key")));
+  }
+
+  {
+    auto batch = [&]<class H>() {
+      H hash;
+      std::vector<uint64_t> keys, values;
+      for(uint64_t i = 0; i < 5000; ++i)
+      {
+        keys.push_back(i * 31);
+        values.push_back(i);
+      }
+      keys.push_back(31); // A key repeated later in the same batch overwrites its value
+      values.push_back(99);
+      std::vector<khiter_t> out(keys.size());
+      TEST(hash.InsertBatch(keys, values, out) == 5000);
+      TEST(hash.size() == 5000);
+      TEST(hash.Get(31) == 99);
+      bool pass = true;
+      for(size_t i = 0; i < keys.size(); ++i)
+        pass = pass && out[i] == hash.Iterator(keys[i]);
+      TEST(pass);
+      TEST(hash.InsertBatch(std::span(keys).first(100), std::span(values).first(100)) == 0);
+      TEST(hash.Get(31) == 1);
+
+      for(uint64_t i = 0; i < 20000; ++i) // Grows the table again, which leaves a HASH_INCREMENTAL table migrating
+        hash.Insert(i * 31 + 7, i);
+      std::vector<uint64_t> probe;
+      for(uint64_t i = 0; i < 10000; ++i)
+        probe.push_back(i * 31 + (i & 1) * 3);
+      std::vector<khiter_t> found(probe.size());
+      hash.FindBatch(probe, found);
+      pass = true;
+      for(size_t i = 0; i < probe.size(); ++i)
+        pass = pass && found[i] == hash.Iterator(probe[i]) && hash.ExistsIter(found[i]) == (i < 5000 && !(i & 1));
+      TEST(pass);
+    };
+    batch.template operator()<Hash<uint64_t, uint64_t>>();
+    batch.template operator()<SwissHash<uint64_t, uint64_t>>();
+    batch.template operator()<IncrementalHash<uint64_t, uint64_t>>();
+
+    Hash<Str> set;
+    Str words[] = { "a", "b", "c", "a" };
+    TEST(set.InsertBatch(words) == 3);
+    khiter_t found[4];
+    set.FindBatch(std::span(words).first(3), found);
+    TEST(set.GetKey(found[1]) == "b");
+  }
   ENDTEST;
 }
+
+template<class H> void _profile_hash_lookup(const char* name, const DynArray<int>& keys)
+{
+  H hash;
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < keys.size(); i += 2)
+    hash.Insert(keys[i], (int)i);
+  double insert = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  int64_t sum = 0;
+  prof        = HighPrecisionTimer::OpenProfiler();
+  for(int k = 0; k < 10; ++k)
+    for(auto key : keys) // Half of these are hits and half are misses
+      sum += hash[key];
+  double lookup = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < keys.size(); i += 4)
+    hash.Remove(keys[i]);
+  double remove = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::cout << name << ": insert " << insert << " ms, lookup " << lookup << " ms, remove " << remove << " ms (" << sum
+            << ")" << std::endl;
+}
+
+// Compares the khash layout against the swiss table layout on integer keys
+void profile_hash()
+{
+  for(size_t n = 1000; n <= 1000000; n *= 10)
+  {
+    DynArray<int> keys(n * 2);
+    for(size_t i = 0; i < n * 2; ++i)
+      keys.Add((int)bun_RandInt(INT32_MIN, INT32_MAX));
+    std::cout << n << " keys" << std::endl;
+    _profile_hash_lookup<Hash<int, int>>("  HASH_KHASH", keys);
+    _profile_hash_lookup<SwissHash<int, int>>("  HASH_SWISS", keys);
+  }
+}
+
+template<class H> void _profile_hash_latency(const char* name, const DynArray<int>& keys)
+{
+  H hash;
+  DynArray<uint64_t> times(keys.size());
+  uint64_t total = HighPrecisionTimer::OpenProfiler();
+  for(auto key : keys)
+  {
+    uint64_t prof = HighPrecisionTimer::OpenProfiler();
+    hash.Insert(key, key);
+    times.Add(HighPrecisionTimer::CloseProfiler(prof));
+  }
+  double ms = HighPrecisionTimer::CloseProfiler(total) / 1000000.0;
+
+  std::sort(times.begin(), times.end());
+  std::cout << name << ": total " << ms << " ms, p50 " << times[times.size() / 2] << " ns, p99.9 "
+            << times[times.size() - times.size() / 1000 - 1] << " ns, max " << times.Back() / 1000000.0 << " ms"
+            << std::endl;
+}
+
+// Measures the latency of individual insertions into a growing table, where HASH_KHASH occasionally stalls on a resize
+void profile_hash_resize()
+{
+  DynArray<int> keys(4000000);
+  for(size_t i = 0; i < keys.Capacity(); ++i)
+    keys.Add((int)bun_RandInt(INT32_MIN, INT32_MAX));
+  _profile_hash_latency<Hash<int, int>>("HASH_KHASH", keys);
+  _profile_hash_latency<IncrementalHash<int, int>>("HASH_INCREMENTAL", keys);
+}
+
+template<class H> void _profile_hash_batch(const char* name, const std::vector<uint64_t>& keys,
+                                           const std::vector<uint64_t>& probe)
+{
+  H hash;
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  for(auto key : keys)
+    hash.Insert(key, key);
+  double insert = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  H batched;
+  prof = HighPrecisionTimer::OpenProfiler();
+  batched.InsertBatch(keys, keys);
+  double insertbatch = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::vector<khiter_t> found(probe.size());
+  prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < probe.size(); ++i)
+    found[i] = hash.Iterator(probe[i]);
+  double find = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  prof = HighPrecisionTimer::OpenProfiler();
+  hash.FindBatch(probe, found);
+  double findbatch = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::cout << name << ": Insert " << insert << " ms, InsertBatch " << insertbatch << " ms, Iterator " << find
+            << " ms, FindBatch " << findbatch << " ms" << std::endl;
+}
+
+// Probes a table far larger than the last level cache with random keys, like the probe side of a hash join. Part of
+// InsertBatch's advantage comes from reserving room for the whole batch instead of growing step by step.
+void profile_hash_batch()
+{
+  constexpr size_t NUM = 1 << 24;
+  std::vector<uint64_t> keys(NUM), probe(NUM);
+  for(auto& k : keys)
+    k = bun_RandInt(0, INT64_MAX);
+  for(size_t i = 0; i < NUM; ++i) // Half hits, half misses
+    probe[i] = (i & 1) ? keys[bun_RandInt(0, NUM - 1)] : bun_RandInt(0, INT64_MAX);
+
+  _profile_hash_batch<Hash<uint64_t, uint64_t>>("HASH_KHASH", keys, probe);
+  _profile_hash_batch<SwissHash<uint64_t, uint64_t>>("HASH_SWISS", keys, probe);
+}
+
+// The byte-at-a-time hash that KH_STR_HASH used to be, kept as a baseline
+static khint_t _legacy_str_hash(const char* s)
+{
+  khint_t h = *s;
+  if(h)
+    for(++s; *s; ++s)
+      h = (h << 5) - h + *s;
+  return h;
+}
+
+// Compares string hashing throughput against the old hash, and the cost of building tables of URL-like Str keys with
+// and without a cached hash
+void profile_string_hash()
+{
+  for(size_t len : { 8, 32, 128, 1024 })
+  {
+    DynArray<Str> keys(1000);
+    for(size_t i = 0; i < keys.Capacity(); ++i)
+    {
+      Str key;
+      for(size_t j = 0; j < len; ++j)
+        key += (char)bun_RandInt('A', 'z');
+      keys.Add(key);
+    }
+    constexpr int ROUNDS = 1000;
+    double mb            = ROUNDS * keys.size() * len / (1024.0 * 1024.0);
+
+    khint_t sum   = 0;
+    uint64_t prof = HighPrecisionTimer::OpenProfiler();
+    for(int k = 0; k < ROUNDS; ++k)
+      for(auto& key : keys)
+        sum += _legacy_str_hash(key.c_str());
+    double legacy = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+    prof = HighPrecisionTimer::OpenProfiler();
+    for(int k = 0; k < ROUNDS; ++k)
+      for(auto& key : keys)
+        sum += KH_AUTO_HASH<Str, false>(key);
+    double fast = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+    prof = HighPrecisionTimer::OpenProfiler();
+    for(int k = 0; k < ROUNDS; ++k)
+      for(auto& key : keys)
+        sum += KH_AUTO_HASH<Str, true>(key);
+    double ins = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+    std::cout << len << " byte strings: legacy " << (mb / legacy) * 1000.0 << " MB/s, KH_STR_HASH " << (mb / fast) * 1000.0
+              << " MB/s, case-insensitive " << (mb / ins) * 1000.0 << " MB/s (" << sum << ")" << std::endl;
+  }
+
+  DynArray<Str> urls(200000);
+  for(size_t i = 0; i < urls.Capacity(); ++i)
+    urls.Add(Str("https://example.com/api/v2/resources/") + std::to_string(bun_RandInt(0, INT32_MAX)).c_str() + "/details");
+
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  {
+    Hash<Str, int> table;
+    for(auto& url : urls)
+      table.Insert(url, 0);
+  }
+  double plain = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  prof = HighPrecisionTimer::OpenProfiler();
+  {
+    Hash<HashedStr, int> table;
+    for(auto& url : urls)
+      table.Insert(url, 0);
+  }
+  double cached = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+  std::cout << "Building a table of " << urls.size() << " URLs: Str " << plain << " ms, HashedStr " << cached << " ms"
+            << std::endl;
+}
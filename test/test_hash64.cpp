@@ -0,0 +1,184 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/Hash64.h"
+#include "buntils/HighPrecisionTimer.h"
+#include <iostream>
+#include <vector>
+
+using namespace bun;
+
+TESTDEF::RETPAIR test_HASH64()
+{
+  BEGINTEST;
+
+  {
+    Hash64<uint64_t, uint64_t> hash;
+    TEST(hash.GetMaxLoad() == __ac_HASH_UPPER);
+    TEST(!hash.Exists(5));
+    TEST(hash.Get(5) == (uint64_t)~0);
+    for(uint64_t i = 0; i < 100000; ++i)
+      hash.Insert(i << 32, i); // Keys that only differ above the low 32 bits
+    TEST(hash.size() == 100000);
+    bool check = true;
+    for(uint64_t i = 0; i < 100000; ++i)
+      check = check && hash.Get(i << 32) == i;
+    TEST(check);
+    TEST(!hash.Exists(1));
+    TEST(hash.Iterator(1) == hash.Capacity());
+
+    hash.Insert(5ULL << 32, 42);
+    TEST(hash.size() == 100000);
+    TEST(hash[5ULL << 32] == 42);
+    TEST(hash.Set(5ULL << 32, 43));
+    TEST(!hash.Set(3, 1));
+    uint64_t v = 0;
+    TEST(hash(5ULL << 32, v) && v == 43);
+    hash.Set(5ULL << 32, 5);
+
+    check = true;
+    for(uint64_t i = 0; i < 100000; i += 2)
+      check = check && hash.Remove(i << 32);
+    TEST(check);
+    TEST(!hash.Remove(0));
+    TEST(hash.size() == 50000);
+    size_t count = 0;
+    check        = true;
+    for(auto [k, val] : hash)
+    {
+      check = check && (k >> 32) == val && (val & 1);
+      ++count;
+    }
+    TEST(check);
+    TEST(count == 50000);
+
+    Hash64<uint64_t, uint64_t> copy(hash);
+    TEST(copy.size() == 50000);
+    TEST(copy.Get(7ULL << 32) == 7);
+    Hash64<uint64_t, uint64_t> moved(std::move(copy));
+    TEST(copy.size() == 0);
+    TEST(moved.Get(9ULL << 32) == 9);
+    hash.Clear();
+    TEST(hash.size() == 0);
+    TEST(!hash.Exists(7ULL << 32));
+    hash = moved;
+    TEST(hash.Get(11ULL << 32) == 11);
+  }
+
+  {
+    Hash64<int> set;
+    set.SetMaxLoad(0.95);
+    for(int i = 0; i < 10000; ++i)
+      set.Insert(i);
+    TEST(set.size() == 10000);
+    TEST(set.Capacity() == 16384); // 10000 keys only fit in 16384 buckets because the load is above 0.61
+    set.SetMaxLoad(0.3);
+    TEST(set.Capacity() == 65536);
+    TEST(set.GetMaxLoad() == 0.3);
+    set.SetMaxLoad(2.0);
+    TEST(set.GetMaxLoad() == 0.95);
+
+    Hash64<int> low;
+    low.SetMaxLoad(0.25);
+    bool check = true;
+    for(int round = 0; round < 5; ++round) // Churning a sparse table must clear out deleted buckets without growing
+    {
+      for(int i = 0; i < 1000; ++i)
+        low.Insert(round * 1000 + i);
+      for(int i = 0; i < 1000; ++i)
+        check = check && low.Remove(round * 1000 + i);
+    }
+    TEST(check);
+    TEST(low.size() == 0);
+    TEST(low.Capacity() <= 8192);
+  }
+
+  {
+    Hash64<Str, int> strings;
+    strings.Insert("Video", 1);
+    strings.Insert("Physics", 2);
+    strings.Insert("", 3);
+    TEST(strings.Get("Video") == 1);
+    TEST(strings.Get(std::string_view("Physics")) == 2);
+    TEST(strings.Get("Physics engine", 7) == 2);
+    TEST(strings.Get(std::string_view()) == 3);
+    TEST(!strings.Exists(std::string_view("video")));
+    TEST(strings.Remove(std::string_view("Video")));
+    TEST(strings.size() == 2);
+
+    Hash64<const char*, int, &KH_AUTO_HASH64<const char*, true>, &KH_AUTO_EQUAL<const char*, true>> ins;
+    TEST((ins.IsTransparent && ins.IgnoreCase));
+    ins.Insert("Content-Type", 5);
+    TEST(ins.Get("CONTENT-TYPE") == 5);
+    TEST(ins.Get(std::string_view("content-type")) == 5);
+
+    Hash64<HashedStr, int> hashed;
+    hashed.Insert(HashedStr("key"), 9);
+    TEST(hashed.Get(HashedStr("key")) == 9);
+    TEST(hashed.Get(std::string_view("key")) == 9);
+
+    Hash64<std::pair<int, int>> pairs;
+    pairs.Insert({ 1, 2 });
+    TEST(pairs.Exists({ 1, 2 }));
+    TEST(!pairs.Exists({ 2, 1 }));
+    TEST(KH_AUTO_HASH64<uint64_t>(1) != KH_AUTO_HASH64<uint64_t>(1ULL << 32));
+  }
+
+  {
+    std::vector<uint64_t> keys;
+    for(uint64_t i = 0; i < 1000; ++i)
+      keys.push_back(i * 0x9E3779B97F4A7C15ULL);
+    HugeHash64<uint64_t, uint64_t> huge(1 << 20); // Big enough that its buckets are put on huge pages
+    TEST(huge.InsertBatch(keys, keys) == 1000);
+    TEST(huge.InsertBatch(keys, keys) == 0);
+    std::vector<uint64_t> found(keys.size());
+    huge.FindBatch(keys, found);
+    bool check = true;
+    for(size_t i = 0; i < keys.size(); ++i)
+      check = check && found[i] == huge.Iterator(keys[i]) && huge.Value(found[i]) == keys[i];
+    TEST(check);
+
+    HugeHash64<uint64_t> hugeset;
+    TEST(hugeset.InsertBatch(keys) == 1000);
+    TEST(hugeset.Exists(keys[500]));
+
+    void* p = bun_HugeAlloc(BUN_HUGE_PAGE_SIZE * 3 + 5);
+    TEST(p != nullptr);
+    memset(p, 1, BUN_HUGE_PAGE_SIZE * 3 + 5);
+    bun_HugeFree(p, BUN_HUGE_PAGE_SIZE * 3 + 5);
+  }
+  ENDTEST;
+}
+
+template<class H> void _profile_hash64(const char* name, const std::vector<uint64_t>& keys,
+                                       const std::vector<uint64_t>& probe)
+{
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  H hash;
+  for(auto key : keys)
+    hash.Insert(key, key);
+  double insert = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  uint64_t sum = 0;
+  prof         = HighPrecisionTimer::OpenProfiler();
+  for(auto key : probe)
+    sum += hash.Exists(key);
+  double find = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+  std::cout << name << ": Insert " << insert << " ms, Exists " << find << " ms (" << sum << " found)" << std::endl;
+}
+
+// Compares Hash against Hash64 with normal pages and with huge pages, on a table far larger than the TLB can cover
+void profile_hash64()
+{
+  constexpr size_t NUM = 1 << 24;
+  std::vector<uint64_t> keys(NUM), probe(NUM);
+  for(auto& k : keys)
+    k = bun_RandInt(0, INT64_MAX);
+  for(size_t i = 0; i < NUM; ++i) // Half hits, half misses
+    probe[i] = (i & 1) ? keys[bun_RandInt(0, NUM - 1)] : bun_RandInt(0, INT64_MAX);
+
+  _profile_hash64<Hash<uint64_t, uint64_t>>("Hash", keys, probe);
+  _profile_hash64<Hash64<uint64_t, uint64_t>>("Hash64", keys, probe);
+  _profile_hash64<HugeHash64<uint64_t, uint64_t>>("HugeHash64", keys, probe);
+}
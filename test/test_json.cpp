@@ -3,8 +3,10 @@
 
 #include "test.h"
 #include "buntils/Geometry.h"
+#include "buntils/HighPrecisionTimer.h"
 #include "buntils/JSON.h"
 #include <fstream>
+#include <iostream>
 
 using namespace bun;
 
@@ -55,6 +57,22 @@ struct JSONtest
   }
 };
 
+struct JSONviews
+{
+  std::string_view name;
+  std::string_view raw;
+  Str copy;
+  double d;
+  int64_t i;
+  std::vector<float> list;
+
+  template<typename Engine> void Serialize(Serializer<Engine>& s, const char*)
+  {
+    s.template EvaluateType<JSONviews>(GenPair("name", name), GenPair("raw", raw), GenPair("copy", copy),
+                                       GenPair("d", d), GenPair("i", i), GenPair("list", list));
+  }
+};
+
 static_assert(internal::serializer::is_serializable<JSONEngine, JSONtest>::value,
               "object missing Serialize<Engine>(Serializer<Engine>&, const char*) function!");
 
@@ -138,6 +156,74 @@ void dotest_JSON(JSONtest& o, TESTDEF::RETPAIR& __testret)
   TEST(c == 3.0);
 }
 
+// Byte at a time version of JSONStructuralIndex
+static std::vector<uint32_t> _referenceIndex(std::string_view s)
+{
+  std::vector<uint32_t> r;
+  bool str = false, backslash = false, scalar = false;
+  for(uint32_t i = 0; i < s.size(); ++i)
+  {
+    char c       = s[i];
+    bool escaped = backslash;
+    backslash    = c == '\\' && !escaped;
+    if(str)
+      str = c != '"' || escaped;
+    else if(c == '"' && !escaped)
+    {
+      if(!scalar)
+        r.push_back(i);
+      str = true;
+    }
+    else if(strchr("{}[]:,", c))
+      r.push_back(i);
+    else if(!strchr(" \t\n\r", c) && !scalar)
+      r.push_back(i);
+    scalar = !str && !strchr("{}[]:, \t\n\r", c) && (c != '"' || escaped);
+  }
+  return r;
+}
+
+// Drains every event the reader has left, describing each one in out, and returns the event that stopped it
+static JSONEvent _drainEvents(JSONReader& r, std::string& out)
+{
+  for(;;)
+  {
+    JSONEvent ev = r.Next();
+    switch(ev)
+    {
+    case JSONEvent::StartObject: out += '{'; break;
+    case JSONEvent::EndObject: out += '}'; break;
+    case JSONEvent::StartArray: out += '['; break;
+    case JSONEvent::EndArray: out += ']'; break;
+    case JSONEvent::Key: out += "k" + std::string(r.String()) + ':'; break;
+    case JSONEvent::String: out += "s" + std::string(r.String()) + ' '; break;
+    case JSONEvent::Int: out += "i" + std::to_string(r.Int()) + ' '; break;
+    case JSONEvent::Double: out += "d" + std::to_string(r.Double()) + ' '; break;
+    case JSONEvent::Bool: out += r.Bool() ? "T " : "F "; break;
+    case JSONEvent::Null: out += "N "; break;
+    default: return ev;
+    }
+  }
+}
+
+// Copies every event from a reader into a writer
+static void _copyEvent(JSONReader& r, JSONEvent ev, JSONWriter& w)
+{
+  switch(ev)
+  {
+  case JSONEvent::StartObject: w.StartObject(); break;
+  case JSONEvent::EndObject: w.EndObject(); break;
+  case JSONEvent::StartArray: w.StartArray(); break;
+  case JSONEvent::EndArray: w.EndArray(); break;
+  case JSONEvent::Key: w.Key(r.String()); break;
+  case JSONEvent::String: w.String(r.String()); break;
+  case JSONEvent::Int: w.Int(r.Int()); break;
+  case JSONEvent::Double: w.Double(r.Double()); break;
+  case JSONEvent::Bool: w.Bool(r.Bool()); break;
+  case JSONEvent::Null: w.Null(); break;
+  }
+}
+
 TESTDEF::RETPAIR test_JSON()
 {
   BEGINTEST;
@@ -249,6 +335,315 @@ TESTDEF::RETPAIR test_JSON()
   fs4.close();
   dotest_JSON(o4, __testret);
 
+  {
+    std::ifstream fs5("pretty.json", std::ios_base::in | std::ios_base::binary);
+    std::string file((std::istreambuf_iterator<char>(fs5)), std::istreambuf_iterator<char>());
+    JSONtest o5;
+    o5.btrue  = false;
+    o5.bfalse = true;
+    ParseJSON(o5, std::span<const char>(file)); // Parses the pretty output straight from memory
+    dotest_JSON(o5, __testret);
+  }
+
+  {
+    // Long runs of whitespace and long strings on either side of escapes cover both the SSE loops and their tails
+    std::string views = "{\n                                        \"name\" : \"a string that is longer than 16 bytes\","
+                        "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"
+                        "\"raw\": \"0123456789abcdef\\\"quoted\\\" 0123456789abcdef\\n\", "
+                        "\"copy\": \"0123456789abcdef\\\"quoted\\\" 0123456789abcdef\\n\", \"d\": -1.5e3, "
+                        "\"list\": [ 1e-2, +4, 2.5 ], \"i\": \"-9000000000\" }";
+    JSONviews v;
+    ParseJSON(v, views);
+    TEST(v.name == "a string that is longer than 16 bytes");
+    TEST(v.name.data() > views.data() && v.name.data() < views.data() + views.size()); // points into the buffer
+    TEST(v.raw == "0123456789abcdef\\\"quoted\\\" 0123456789abcdef\\n");
+    TEST(v.copy == "0123456789abcdef\"quoted\" 0123456789abcdef\n");
+    TEST(v.d == -1500.0);
+    TEST(v.i == -9000000000LL);
+    TEST((v.list.size() == 3 && v.list[0] == 0.01f && v.list[1] == 4.0f && v.list[2] == 2.5f));
+
+    std::stringstream ss(views);
+    JSONviews v2;
+    ParseJSON(v2, ss);
+    TEST(v2.name.empty()); // There is no buffer for a view to point into
+    TEST(v2.copy == v.copy);
+    TEST(v2.d == v.d);
+    TEST(v2.i == v.i);
+
+    std::stringstream out;
+    WriteJSON(v, out);
+    JSONviews v3;
+    std::string written = out.str();
+    ParseJSON(v3, written);
+    TEST(v3.name == v.name);
+    TEST(v3.copy == v.copy);
+  }
+
+  {
+    bool check = true;
+    std::vector<uint32_t> scalar, sse2, avx2, simd;
+    const char alphabet[] = "\"\"\"\\\\\\{}[]:, \nab1";
+    for(int k = 0; k < 2000; ++k) // Random soup of quotes and backslashes across block boundaries
+    {
+      std::string soup(bun_RandInt(0, 300), ' ');
+      for(auto& c : soup)
+        c = alphabet[bun_RandInt(0, sizeof(alphabet) - 2)];
+      auto ref = _referenceIndex(soup);
+      internal::JSONStructuralIndexScalar(soup, scalar = {});
+      JSONStructuralIndex(soup, simd = {});
+      check = check && scalar == ref && simd == ref;
+#ifdef BUN_SSE_ENABLED
+      internal::JSONStructuralIndexSSE2(soup, sse2 = {});
+      check = check && sse2 == ref;
+      if(bunGetCPUInfo().sse >= bunCPUInfo::SSE_AVX2)
+      {
+        internal::JSONStructuralIndexAVX2(soup, avx2 = {});
+        check = check && avx2 == ref;
+      }
+#endif
+    }
+    TEST(check);
+
+    std::ifstream fs6("pretty.json", std::ios_base::in | std::ios_base::binary);
+    std::string file((std::istreambuf_iterator<char>(fs6)), std::istreambuf_iterator<char>());
+    JSONValue direct, indexed;
+    ParseJSON(direct, std::span<const char>(file));
+    TEST(ParseJSONIndexed(indexed, file));
+    std::stringstream a, b;
+    WriteJSON(direct, a);
+    WriteJSON(indexed, b);
+    TEST(a.str() == b.str());
+
+    JSONValue lenient;
+    TEST(ParseJSONIndexed(lenient, std::string_view(json)));
+    auto& root = lenient.get<JSONValue::JSONObject>();
+    TEST(root.size() == 21);
+    TEST(root[0].second.get<int64_t>() == -5);
+    TEST(root[2].second.get<double>() == 23.7193);
+    TEST(root[6].second.get<Str>() == var1[3].second.get<Str>()); // Escapes decode the same way as ParseJSON
+    TEST(root[11].second.get<JSONValue::JSONArray>().size() == 2);
+
+    JSONValue bad;
+    TEST(!ParseJSONIndexed(bad, std::string_view("{\"a\": [1, 2}")));
+    TEST(!ParseJSONIndexed(bad, std::string_view("[1, 2, tru]")));
+    TEST(!ParseJSONIndexed(bad, std::string_view("{\"a\" 1}")));
+    TEST(!ParseJSONIndexed(bad, std::string_view("")));
+    for(size_t i = 0; i < strlen(json); ++i) // Every truncation of a valid document is malformed
+      check = check && !ParseJSONIndexed(bad, std::string_view(json, i));
+    TEST(check);
+  }
+
+  {
+    JSONDocument doc;
+    TEST(doc.Parse(json));
+    auto root = doc.Root();
+    TEST(root.IsObject());
+    TEST(root.size() == 21);
+    TEST(root["a"].get<int>() == -5);
+    TEST(root["a"].is<int64_t>());
+    TEST(root["c"].is<double>());
+    TEST(root["c"].get<double>() == 23.7193);
+    TEST(root["c"].get<int>() == 23);
+    TEST(root["btrue"].get<bool>());
+    TEST(!root["bfalse"].get<bool>());
+    TEST(root["test"].get<std::string_view>() == std::string_view(var1[3].second.get<Str>()));
+    TEST(root["test"].get<std::string_view>().data() == root["test"].get<std::string_view>().data()); // Decoded once
+    TEST(root["foobar"][0].get<std::string_view>() == "moar");
+    TEST(root["foobar"][1].get<std::string_view>().empty());
+    TEST(root["nested"]["ia"][1].get<int>() == 2);
+    TEST(root["nested"]["value"].size() == 2);
+    TEST(root["foo"].size() == 6);
+    TEST(root["nested2"].IsNull());
+    TEST(root["nestarray"][1]["a"].IsNull());
+    TEST(root["nestarray"][1]["b"].get<int>() == 34);
+    TEST(root["hash"]["41"].get<int>() == 45);
+    TEST(!root["missing"]);
+    TEST(!root["foo"][6]);
+    TEST(!root["a"]["a"]);
+    TEST(root[20][1].get<std::string_view>() == "2");
+
+    int64_t sum = 0;
+    for(auto n : root["sector"])
+      sum += n.get<int64_t>();
+    TEST(sum == 21);
+    size_t count = 0;
+    for(auto n : root)
+      count += (n.Key() == root[count].Key());
+    TEST(count == 21);
+    TEST(root[3].Key() == "btrue");
+
+    std::string big = "{"; // Large enough to build a key table
+    for(int i = 0; i < 100; ++i)
+      big += (i ? ",\"k" : "\"k") + std::to_string(i) + "\":" + std::to_string(i * 3);
+    big += "}";
+    JSONDocument large;
+    TEST(large.Parse(big));
+    bool check = true;
+    for(int i = 0; i < 100; ++i)
+      check = check && large.Root()["k" + std::to_string(i)].get<int>() == i * 3;
+    TEST(check);
+    TEST(!large.Root()["k100"]);
+    TEST(!large.Root()["k"]);
+
+    std::ifstream fs7("pretty.json", std::ios_base::in | std::ios_base::binary);
+    std::string file((std::istreambuf_iterator<char>(fs7)), std::istreambuf_iterator<char>());
+    JSONValue direct, copied;
+    ParseJSON(direct, std::span<const char>(file));
+    TEST(doc.Parse(file));
+    doc.Root().CopyTo(copied);
+    std::stringstream a, b;
+    WriteJSON(direct, a);
+    WriteJSON(copied, b);
+    TEST(a.str() == b.str());
+
+    JSONDocument moved(std::move(large));
+    TEST(moved.Root()["k7"].get<int>() == 21);
+    TEST(!large.Root());
+
+    TEST(!doc.Parse("{\"a\": [1, 2}"));
+    TEST(!doc.Parse("[1, 2, tru]"));
+    TEST(!doc.Parse("{\"a\" 1}"));
+    TEST(!doc.Parse(""));
+    TEST(!doc.Root());
+    for(size_t i = 0; i < strlen(json); ++i)
+      check = check && !doc.Parse(std::span<const char>(json, i));
+    TEST(check);
+  }
+
+  {
+    std::string whole;
+    JSONReader reader;
+    reader.Feed(std::span<const char>(json, strlen(json)));
+    TEST(_drainEvents(reader, whole) == JSONEvent::NeedMore);
+    reader.Finish();
+    TEST(_drainEvents(reader, whole) == JSONEvent::End);
+    TEST(reader.Depth() == 0);
+    TEST(whole.starts_with("{ka:i-5 kb:i342 kc:d23.719300 kbtrue:T kbfalse:F "));
+    TEST(whole.find("kfixed:[d0.200000 d23.100000 i-3 d4.000000 ]") != std::string::npos);
+    TEST(whole.find("ktest:s" + std::string(var1[3].second.get<Str>()) + ' ') != std::string::npos);
+    TEST(whole.find("kfoo:[i5 i6 i4 i2 i2 i3 ]") != std::string::npos); // Trailing comma
+    TEST(whole.find("knestarray:[N {ka:N kb:i34 }]") != std::string::npos); // Missing value
+
+    bool check = true;
+    for(size_t i = 0; i <= strlen(json); ++i) // Splitting the input anywhere has to produce the same events
+    {
+      std::string split;
+      reader.Reset();
+      reader.Feed(std::span<const char>(json, i));
+      check = check && _drainEvents(reader, split) == JSONEvent::NeedMore;
+      reader.Feed(std::span<const char>(json + i, strlen(json) - i));
+      check = check && _drainEvents(reader, split) == JSONEvent::NeedMore;
+      reader.Finish();
+      check = check && _drainEvents(reader, split) == JSONEvent::End && split == whole;
+    }
+    TEST(check);
+
+    std::string bytes;
+    reader.Reset();
+    for(size_t i = 0; i < strlen(json); ++i)
+    {
+      reader.Feed(std::span<const char>(json + i, 1));
+      check = check && _drainEvents(reader, bytes) == JSONEvent::NeedMore;
+    }
+    reader.Finish();
+    TEST(_drainEvents(reader, bytes) == JSONEvent::End);
+    TEST(bytes == whole);
+
+    std::ifstream fs8("pretty.json", std::ios_base::in | std::ios_base::binary);
+    std::stringstream copy;
+    {
+      JSONWriter writer(copy, 16);
+      TEST(ParseJSONEvents(fs8, [&](JSONReader& r, JSONEvent ev) { _copyEvent(r, ev, writer); }, 7));
+    }
+    std::string written = copy.str();
+    TEST(written.back() == '\n');
+    std::ifstream fs9("pretty.json", std::ios_base::in | std::ios_base::binary);
+    std::string file((std::istreambuf_iterator<char>(fs9)), std::istreambuf_iterator<char>());
+    JSONValue direct, rewritten;
+    ParseJSON(direct, std::span<const char>(file));
+    TEST(ParseJSONIndexed(rewritten, written));
+    std::stringstream a, b;
+    WriteJSON(direct, a);
+    WriteJSON(rewritten, b);
+    TEST(a.str() == b.str());
+
+    JSONWriter lines; // Several root values become newline-delimited JSON
+    for(int i = 0; i < 3; ++i)
+    {
+      lines.StartObject();
+      lines.Key("i");
+      lines.Int(i);
+      lines.Key("s\"\n\x01/");
+      lines.StartArray();
+      lines.Double(0.1);
+      lines.Double(1e300);
+      lines.Double(std::numeric_limits<double>::infinity());
+      lines.UInt(UINT64_MAX);
+      lines.Bool(true);
+      lines.Null();
+      lines.EndArray();
+      lines.EndObject();
+    }
+    lines.String("end");
+    TEST(lines.Depth() == 0);
+    std::string_view expected = "{\"i\":0,\"s\\\"\\n\\u0001\\/\":[0.1,1e+300,null,18446744073709551615,true,null]}\n";
+    TEST(lines.Buffer().substr(0, expected.size()) == expected);
+    std::stringstream ndjson(std::string(lines.Buffer()));
+    std::string events;
+    size_t roots = 0;
+    TEST(ParseJSONEvents(ndjson, [&](JSONReader& r, JSONEvent ev) {
+      roots += (r.Depth() == 0);
+      if(ev == JSONEvent::Key)
+        events += r.String();
+    }));
+    TEST(roots == 4);
+    TEST(events == "is\"\n\x01/is\"\n\x01/is\"\n\x01/");
+
+    for(const char* bad : { "{\"a\" 1}", "[1, 2}", "[tru]", "{\"a\": 1]", "[1 2]", "{1: 2}", "]", "[+1]", "[\"abc" })
+    {
+      std::string discard;
+      reader.Reset();
+      reader.Feed(std::span<const char>(bad, strlen(bad)));
+      JSONEvent ev = _drainEvents(reader, discard);
+      if(ev == JSONEvent::NeedMore)
+      {
+        reader.Finish();
+        ev = _drainEvents(reader, discard);
+      }
+      check = check && ev == JSONEvent::Error && reader.Next() == JSONEvent::Error;
+    }
+    TEST(check);
+    for(size_t i = 1; i < strlen(json); ++i) // Every truncation of a valid document is malformed
+    {
+      std::string discard;
+      reader.Reset();
+      reader.Feed(std::span<const char>(json, i));
+      reader.Finish();
+      check = check && _drainEvents(reader, discard) == JSONEvent::Error;
+    }
+    TEST(check);
+  }
+
+  {
+    JSONValue::JSONArray numbers; // Doubles have to survive a round trip through text exactly
+    numbers.Add(JSONValue(0.1234567891234567));
+    numbers.Add(JSONValue(1.0 / 3.0));
+    numbers.Add(JSONValue(-2.2250738585072014e-308));
+    numbers.Add(JSONValue(std::numeric_limits<double>::infinity()));
+    numbers.Add(JSONValue(int64_t(INT64_MIN)));
+    std::stringstream out;
+    out.precision(3); // The stream's formatting is ignored
+    WriteJSON(JSONValue(numbers), out);
+    TEST(out.str() == "[0.1234567891234567,0.3333333333333333,-2.2250738585072014e-308,null,-9223372036854775808]");
+    JSONValue back;
+    ParseJSON(back, out.str());
+    auto& arr = back.get<JSONValue::JSONArray>();
+    TEST(arr[0].get<double>() == 0.1234567891234567);
+    TEST(arr[1].get<double>() == 1.0 / 3.0);
+    TEST(arr[2].get<double>() == -2.2250738585072014e-308);
+    TEST(arr[4].get<int64_t>() == INT64_MIN);
+  }
+
   Str s; // test to ensure that invalid data does not crash or lock up the parser
   for(int i = (int)strlen(json); i > 0; --i)
   {
@@ -257,4 +652,170 @@ TESTDEF::RETPAIR test_JSON()
     ParseJSON(var, s);
   }
   ENDTEST;
-}
\ No newline at end of file
+}
+// Compares parsing the same JSON through an istream against parsing it directly out of memory
+void profile_json()
+{
+  JSONtest2 inner;
+  inner.ia = { -1, 2 };
+  std::ostringstream gen;
+  gen << "{ \"value\": [";
+  for(int i = 0; i < 100000; ++i)
+    gen << (i ? ",\n    " : "") << "{ \"value\": [], \"ia\": [" << i << ", " << -i << "] }";
+  gen << "], \"ia\": [3, 4] }";
+  std::string json = gen.str();
+
+  JSONtest2 a;
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  std::istringstream ss(json);
+  ParseJSON(a, ss);
+  double stream = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  JSONtest2 b;
+  prof = HighPrecisionTimer::OpenProfiler();
+  ParseJSON(b, std::span<const char>(json));
+  double buffer = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::cout << json.size() << " bytes: istream " << stream << " ms, buffer " << buffer << " ms (" << a.value.size()
+            << ", " << b.value.size() << ")" << std::endl;
+}
+
+// Generates documents shaped like the standard twitter.json (objects full of strings) and canada.json (huge arrays of
+// coordinates) benchmarks, then measures stage 1 alone and both ways of parsing into a JSONValue.
+void profile_json_indexed()
+{
+  std::ostringstream twitter, canada;
+  twitter << "{ \"statuses\": [";
+  for(int i = 0; i < 20000; ++i)
+    twitter << (i ? "," : "") << "\n  { \"id\": " << 505874924095815681LL + i
+            << ", \"text\": \"@aym0566x \\u540d\\u524d: \\\"tweet\\\" number " << i << " with a link https:\\/\\/t.co\\/"
+            << i * 7919 << "\", \"truncated\": false, \"user\": { \"id\": " << i * 31
+            << ", \"name\": \"\\u3075\\u3049\\u3063\", \"screen_name\": \"user" << i
+            << "\", \"followers_count\": 262, \"verified\": false, \"url\": null }, \"retweet_count\": " << i % 17
+            << ", \"entities\": { \"hashtags\": [], \"urls\": [ { \"indices\": [ 12, 34 ] } ] } }";
+  twitter << "] }";
+
+  canada << "{ \"type\": \"FeatureCollection\", \"features\": [ { \"geometry\": { \"coordinates\": [ [";
+  canada.precision(15);
+  for(int i = 0; i < 100000; ++i)
+    canada << (i ? "," : "") << "[" << -65.613616999999977 + i * 1e-6 << "," << 43.420273000000009 - i * 1e-6 << "]";
+  canada << "] ] } } ] }";
+
+  for(auto [name, json] : { std::pair{ "twitter", twitter.str() }, std::pair{ "canada", canada.str() } })
+  {
+    auto gbs = [&](uint64_t ns) { return (json.size() / (ns / 1000000000.0)) / (1024.0 * 1024.0 * 1024.0); };
+    std::vector<uint32_t> index;
+    JSONStructuralIndex(json, index); // Warm up, so neither timing includes allocating the index
+    index.clear();
+    uint64_t prof = HighPrecisionTimer::OpenProfiler();
+    internal::JSONStructuralIndexSSE2(json, index);
+    double sse2 = gbs(HighPrecisionTimer::CloseProfiler(prof));
+
+    double avx2 = 0;
+    if(bunGetCPUInfo().sse >= bunCPUInfo::SSE_AVX2)
+    {
+      index.clear();
+      prof = HighPrecisionTimer::OpenProfiler();
+      internal::JSONStructuralIndexAVX2(json, index);
+      avx2 = gbs(HighPrecisionTimer::CloseProfiler(prof));
+    }
+
+    JSONValue a, b;
+    prof          = HighPrecisionTimer::OpenProfiler();
+    bool ok       = ParseJSONIndexed(a, json);
+    double staged = gbs(HighPrecisionTimer::CloseProfiler(prof));
+    prof          = HighPrecisionTimer::OpenProfiler();
+    ParseJSON(b, std::span<const char>(json));
+    double direct = gbs(HighPrecisionTimer::CloseProfiler(prof));
+
+    std::cout << name << " (" << json.size() << " bytes, " << index.size() << " structurals): stage 1 SSE2 " << sse2
+              << " GB/s, AVX2 " << avx2 << " GB/s, ParseJSONIndexed " << staged << " GB/s (" << ok << "), ParseJSON "
+              << direct << " GB/s" << std::endl;
+  }
+}
+
+// Reads a handful of fields out of every record in a large twitter-like document, which is what most services do with
+// their payloads, through a full JSONValue tree and through a lazy JSONDocument.
+void profile_json_document()
+{
+  std::ostringstream gen;
+  gen << "{ \"statuses\": [";
+  for(int i = 0; i < 20000; ++i)
+    gen << (i ? "," : "") << "\n  { \"id\": " << 505874924095815681LL + i
+        << ", \"text\": \"@aym0566x \\u540d\\u524d: \\\"tweet\\\" number " << i
+        << "\", \"truncated\": false, \"user\": { \"id\": " << i * 31
+        << ", \"name\": \"\\u3075\\u3049\\u3063\", \"screen_name\": \"user" << i
+        << "\", \"followers_count\": 262, \"verified\": false, \"url\": null }, \"retweet_count\": " << i % 17
+        << ", \"entities\": { \"hashtags\": [], \"urls\": [ { \"indices\": [ 12, 34 ] } ] } }";
+  gen << "] }";
+  std::string json = gen.str();
+
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  JSONValue v;
+  ParseJSONIndexed(v, json);
+  int64_t a = 0;
+  for(auto& status : v.get<JSONValue::JSONObject>()[0].second.get<JSONValue::JSONArray>())
+  {
+    auto& obj = status.get<JSONValue::JSONObject>();
+    a += obj[4].second.get<int64_t>() + obj[3].second.get<JSONValue::JSONObject>()[0].second.get<int64_t>();
+  }
+  double tree = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  prof = HighPrecisionTimer::OpenProfiler();
+  JSONDocument doc;
+  doc.Parse(json);
+  int64_t b = 0;
+  for(auto status : doc.Root()["statuses"])
+    b += status["retweet_count"].get<int64_t>() + status["user"]["id"].get<int64_t>();
+  double lazy = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::cout << json.size() << " bytes: ParseJSONIndexed " << tree << " ms, JSONDocument " << lazy << " ms (" << a << ", "
+            << b << ")" << std::endl;
+}
+
+// Streams a newline-delimited log through JSONReader in 64 KiB chunks, copying every event into a JSONWriter
+void profile_json_stream()
+{
+  std::string log;
+  {
+    JSONWriter gen;
+    for(int i = 0; i < 200000; ++i)
+    {
+      gen.StartObject();
+      gen.Key("ts");
+      gen.Int(1700000000000LL + i * 17);
+      gen.Key("level");
+      gen.String((i % 7) ? "info" : "warn");
+      gen.Key("msg");
+      gen.String("request \"GET /api/v1/items\" finished");
+      gen.Key("latency");
+      gen.Double(i * 0.0173);
+      gen.Key("tags");
+      gen.StartArray();
+      gen.String("web");
+      gen.Int(i % 13);
+      gen.EndArray();
+      gen.EndObject();
+    }
+    log = gen.Buffer();
+  }
+  auto gbs = [&](uint64_t ns) { return (log.size() / (ns / 1000000000.0)) / (1024.0 * 1024.0 * 1024.0); };
+
+  std::istringstream in(log);
+  size_t events = 0;
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  bool ok       = ParseJSONEvents(in, [&](JSONReader&, JSONEvent) { ++events; });
+  double read   = gbs(HighPrecisionTimer::CloseProfiler(prof));
+
+  std::istringstream in2(log);
+  std::ostringstream out;
+  prof = HighPrecisionTimer::OpenProfiler();
+  {
+    JSONWriter writer(out);
+    ParseJSONEvents(in2, [&](JSONReader& r, JSONEvent ev) { _copyEvent(r, ev, writer); });
+  }
+  double copy = gbs(HighPrecisionTimer::CloseProfiler(prof));
+
+  std::cout << log.size() << " bytes, " << events << " events: read " << read << " GB/s (" << ok << "), read and write "
+            << copy << " GB/s (" << (out.str() == log) << ")" << std::endl;
+}
@@ -6,6 +6,7 @@
 #include "buntils/LocklessQueue.h"
 #include "buntils/Thread.h"
 #include <algorithm>
+#include <iostream>
 
 using namespace bun;
 
@@ -41,6 +42,113 @@ template<class T> void _locklessqueue_produce(void* p)
 }
 #pragma warning(pop)
 
+template<class T> void _ringqueue_consume(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  uint16_t c;
+  while((c = lq_pos.fetch_add(1, std::memory_order_relaxed)) < TESTNUM)
+  {
+    while(!q->TryPop(lq_end[c]))
+      ;
+  }
+}
+
+template<class T> void _ringqueue_produce(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  size_t c;
+  while((c = lq_c.fetch_add(1, std::memory_order_relaxed)) <= TESTNUM)
+  {
+    while(!q->TryPush((uint16_t)c))
+      ;
+  }
+}
+
+template<class T> void _ringqueue_consume_batch(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  uint16_t buf[8];
+  while(lq_pos.load(std::memory_order_relaxed) < TESTNUM)
+  {
+    if(size_t n = q->TryPopBatch(buf, 8))
+    {
+      size_t c = lq_pos.fetch_add((uint16_t)n, std::memory_order_relaxed);
+      for(size_t i = 0; i < n; ++i)
+        lq_end[c + i] = buf[i];
+    }
+  }
+}
+
+template<class T> void _ringqueue_produce_batch(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  uint16_t buf[8];
+  size_t c;
+  while((c = lq_c.fetch_add(8, std::memory_order_relaxed)) <= TESTNUM)
+  {
+    size_t n = bun_min(TESTNUM + 1 - c, (size_t)8);
+    for(size_t i = 0; i < n; ++i)
+      buf[i] = (uint16_t)(c + i);
+    for(size_t i = 0; i < n;)
+      i += q->TryPushBatch(buf + i, n - i);
+  }
+}
+
+void _spscring_produce(void* p)
+{
+  while(!startflag.load())
+    ;
+  auto q = (SPSCRingQueue<uint16_t>*)p;
+  size_t c = 1;
+  while(c <= TESTNUM)
+  {
+    if(c & 64) // Alternate between single pushes and batches
+    {
+      while(!q->TryPush((uint16_t)c))
+        ;
+      ++c;
+    }
+    else
+    {
+      auto span = q->Reserve(TESTNUM + 1 - c);
+      for(auto& item : span)
+        item = (uint16_t)c++;
+      q->Commit(span.size());
+    }
+  }
+}
+
+void _spscring_consume(void* p)
+{
+  while(!startflag.load())
+    ;
+  auto q   = (SPSCRingQueue<uint16_t>*)p;
+  size_t c = 0;
+  while(c < TESTNUM)
+  {
+    if(c & 32)
+    {
+      if(q->TryPop(lq_end[c]))
+        ++c;
+    }
+    else
+    {
+      auto span = q->Peek(TESTNUM - c);
+      for(auto item : span)
+        lq_end[c++] = item;
+      q->Release(span.size());
+    }
+  }
+}
+
 typedef void (*VOIDFN)(void*);
 
 TESTDEF::RETPAIR test_LOCKLESSQUEUE()
@@ -130,5 +238,360 @@ TESTDEF::RETPAIR test_LOCKLESSQUEUE()
     }
   }
 
+  {
+    RingQueue<int64_t> q(3); // Basic sanity test
+    TEST(q.Capacity() == 4);
+    int64_t c;
+    TEST(!q.TryPop(c));
+    TEST(!q.Peek());
+    TEST(q.TryPush(1));
+    TEST(q.TryPush(2));
+    TEST(q.TryPush(3));
+    TEST(q.TryPush(4));
+    TEST(!q.TryPush(5));
+    TEST(q.size() == 4);
+    TEST(q.TryPop(c));
+    TEST(c == 1);
+    TEST(q.TryPush(5));
+    int64_t batch[8] = { 6, 7, 8 };
+    TEST(q.TryPushBatch(batch, 3) == 0);
+    TEST(q.TryPopBatch(batch, 8) == 4);
+    TEST(batch[0] == 2 && batch[1] == 3 && batch[2] == 4 && batch[3] == 5);
+    TEST(q.TryPushBatch(std::span<const int64_t>(batch, 8)) == 4);
+    TEST(q.TryPopBatch(batch + 4, 2) == 2);
+    TEST(batch[4] == 2 && batch[5] == 3);
+    TEST(q.TryPop(c));
+    TEST(c == 4);
+    TEST(q.Peek());
+  }
+
+  {
+    SPSCRingQueue<int64_t> q(3); // Basic sanity test
+    TEST(q.Capacity() == 4);
+    int64_t c;
+    TEST(!q.TryPop(c));
+    TEST(q.Peek().empty());
+    TEST(q.TryPush(1));
+    TEST(q.TryPush(2));
+    TEST(q.TryPush(3));
+    auto span = q.Reserve(4);
+    TEST(span.size() == 1);
+    span[0] = 4;
+    q.Commit(1);
+    TEST(!q.TryPush(5));
+    TEST(q.Reserve(4).empty());
+    TEST(q.TryPop(c));
+    TEST(c == 1);
+    TEST(q.TryPop(c));
+    TEST(c == 2);
+    span = q.Reserve(4);
+    TEST(span.size() == 2); // Stops at the end of the ring
+    span[0] = 5;
+    span[1] = 6;
+    q.Commit(2);
+    TEST(q.size() == 4);
+    span = q.Peek();
+    TEST(span.size() == 2);
+    TEST(span[0] == 3 && span[1] == 4);
+    q.Release(1);
+    span = q.Peek(1);
+    TEST(span.size() == 1 && span[0] == 4);
+    q.Release(1);
+    span = q.Peek();
+    TEST(span.size() == 2 && span[0] == 5 && span[1] == 6);
+    q.Release(2);
+    TEST(!q.TryPop(c));
+  }
+
+  {
+    lq_pos = 0;
+    bun_Fill(lq_end, 0);
+    SPSCRingQueue<uint16_t> q(128);
+    startflag.store(false);
+    threads[0] = Thread(_spscring_produce, &q);
+    threads[1] = Thread(_spscring_consume, &q);
+    startflag.store(true);
+    threads[0].join();
+    threads[1].join();
+    bool check = true;
+    for(size_t i = 0; i < TESTNUM; ++i)
+      check = check && (lq_end[i] == i + 1);
+    TEST(check);
+  }
+
+  for(auto batch : { false, true })
+  {
+    using RINGQUEUE = RingQueue<uint16_t>;
+    for(size_t j = 2; j <= NUMTHREADS; j = fbnext(j))
+    {
+      lq_c   = 1;
+      lq_pos = 0;
+      bun_Fill(lq_end, 0);
+      RINGQUEUE q(64); // Small enough that the ring wraps around many times
+      startflag.store(false);
+      for(size_t i = 0; i < j; ++i)
+      {
+        if(batch)
+          threads[i] = Thread((i & 1) ? _ringqueue_produce_batch<RINGQUEUE> : _ringqueue_consume_batch<RINGQUEUE>, &q);
+        else
+          threads[i] = Thread((i & 1) ? _ringqueue_produce<RINGQUEUE> : _ringqueue_consume<RINGQUEUE>, &q);
+      }
+      startflag.store(true);
+      for(size_t i = 0; i < j; ++i)
+        threads[i].join();
+
+      std::sort(std::begin(lq_end), std::end(lq_end));
+      bool check = true;
+      for(size_t i = 0; i < TESTNUM - 1; ++i)
+        check = check && (lq_end[i] == i + 1);
+      TEST(check);
+      TEST(!q.Peek());
+    }
+  }
+
   ENDTEST;
 }
+
+const size_t PROFILE_QUEUE_ITEMS = 2000000;
+std::atomic<size_t> pq_produced;
+std::atomic<size_t> pq_consumed;
+
+template<class T, bool RING> void _profile_queue_produce(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  while(pq_produced.fetch_add(1, std::memory_order_relaxed) < PROFILE_QUEUE_ITEMS)
+  {
+    if constexpr(RING)
+    {
+      while(!q->TryPush(1))
+        std::this_thread::yield(); // Don't burn the rest of our timeslice if there are more threads than cores
+    }
+    else
+      q->Push(1);
+  }
+}
+
+template<class T, bool RING> void _profile_queue_consume(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  size_t item;
+  while(pq_consumed.load(std::memory_order_relaxed) < PROFILE_QUEUE_ITEMS)
+  {
+    bool popped;
+    if constexpr(RING)
+      popped = q->TryPop(item);
+    else
+      popped = q->Pop(item);
+    if(popped)
+      pq_consumed.fetch_add(1, std::memory_order_relaxed);
+    else
+      std::this_thread::yield();
+  }
+}
+
+template<class T, bool RING> double _profile_queue(T& q, size_t count)
+{
+  Thread threads[64];
+  pq_produced = 0;
+  pq_consumed = 0;
+  startflag.store(false);
+  for(size_t i = 0; i < count; ++i)
+  {
+    threads[i * 2]     = Thread(_profile_queue_produce<T, RING>, &q);
+    threads[i * 2 + 1] = Thread(_profile_queue_consume<T, RING>, &q);
+  }
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  startflag.store(true);
+  for(size_t i = 0; i < count * 2; ++i)
+    threads[i].join();
+  return HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+}
+
+// Compares the throughput of MicroLockQueue and RingQueue with the same number of producers and consumers.
+void profile_mpmc_queue()
+{
+  for(size_t count = 1; count <= 32; count <<= 1)
+  {
+    {
+      LocklessBlockPolicy<internal::LQ_QNode<size_t>> policy;
+      MicroLockQueue<size_t> q{ PolicyAllocator<internal::LQ_QNode<size_t>, LocklessBlockPolicy>{ policy } };
+      double ms = _profile_queue<MicroLockQueue<size_t>, false>(q, count);
+      std::cout << "MicroLockQueue " << count << "P/" << count << "C: " << ms << " ms ("
+                << PROFILE_QUEUE_ITEMS / (ms * 1000.0) << " M items/s)" << std::endl;
+    }
+    {
+      RingQueue<size_t> q(1024);
+      double ms = _profile_queue<RingQueue<size_t>, true>(q, count);
+      std::cout << "RingQueue      " << count << "P/" << count << "C: " << ms << " ms ("
+                << PROFILE_QUEUE_ITEMS / (ms * 1000.0) << " M items/s)" << std::endl;
+    }
+  }
+}
+
+const size_t PROFILE_SPSC_ITEMS = 10000000;
+
+template<class T> void _profile_spsc_produce(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  for(size_t i = 0; i < PROFILE_SPSC_ITEMS; ++i)
+  {
+    if constexpr(std::is_same_v<T, SPSCRingQueue<size_t>>)
+    {
+      while(!q->TryPush(i))
+        std::this_thread::yield();
+    }
+    else
+      q->Push(i);
+  }
+}
+
+template<class T> void _profile_spsc_consume(void* p)
+{
+  while(!startflag.load())
+    ;
+  T* q = (T*)p;
+  size_t item;
+  for(size_t i = 0; i < PROFILE_SPSC_ITEMS;)
+  {
+    bool popped;
+    if constexpr(std::is_same_v<T, SPSCRingQueue<size_t>>)
+      popped = q->TryPop(item);
+    else
+      popped = q->Pop(item);
+    if(popped)
+      ++i;
+    else
+      std::this_thread::yield();
+  }
+}
+
+void _profile_spsc_produce_batch(void* p)
+{
+  while(!startflag.load())
+    ;
+  auto q = (SPSCRingQueue<size_t>*)p;
+  for(size_t i = 0; i < PROFILE_SPSC_ITEMS;)
+  {
+    auto span = q->Reserve(bun_min(PROFILE_SPSC_ITEMS - i, (size_t)256));
+    for(auto& item : span)
+      item = i++;
+    q->Commit(span.size());
+    if(span.empty())
+      std::this_thread::yield();
+  }
+}
+
+void _profile_spsc_consume_batch(void* p)
+{
+  while(!startflag.load())
+    ;
+  auto q = (SPSCRingQueue<size_t>*)p;
+  for(size_t i = 0; i < PROFILE_SPSC_ITEMS;)
+  {
+    auto span = q->Peek();
+    i += span.size();
+    q->Release(span.size());
+    if(span.empty())
+      std::this_thread::yield();
+  }
+}
+
+template<class T> double _profile_spsc(T& q, VOIDFN produce, VOIDFN consume)
+{
+  startflag.store(false);
+  Thread producer(produce, &q);
+  Thread consumer(consume, &q);
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  startflag.store(true);
+  producer.join();
+  consumer.join();
+  return HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+}
+
+// Bounces a single item back and forth between two threads, so each round trip measures two queue handoffs.
+template<class T> double _profile_spsc_latency(T& ping, T& pong, size_t trips)
+{
+  Thread echo(
+    [](T* in, T* out, size_t n) {
+      size_t item;
+      for(size_t i = 0; i < n; ++i)
+      {
+        if constexpr(std::is_same_v<T, SPSCRingQueue<size_t>>)
+        {
+          while(!in->TryPop(item))
+            std::this_thread::yield();
+          while(!out->TryPush(item))
+            std::this_thread::yield();
+        }
+        else
+        {
+          while(!in->Pop(item))
+            std::this_thread::yield();
+          out->Push(item);
+        }
+      }
+    },
+    &ping, &pong, trips);
+
+  size_t item;
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < trips; ++i)
+  {
+    if constexpr(std::is_same_v<T, SPSCRingQueue<size_t>>)
+    {
+      while(!ping.TryPush(i))
+        std::this_thread::yield();
+      while(!pong.TryPop(item))
+        std::this_thread::yield();
+    }
+    else
+    {
+      ping.Push(i);
+      while(!pong.Pop(item))
+        std::this_thread::yield();
+    }
+  }
+  double ns = HighPrecisionTimer::CloseProfiler(prof) / (double)trips;
+  echo.join();
+  return ns;
+}
+
+// Compares the throughput and round trip latency of LocklessQueue and SPSCRingQueue.
+void profile_spsc_queue()
+{
+  using LQUEUE = LocklessQueue<size_t>;
+  {
+    BlockPolicy<internal::LQ_QNode<size_t>> policy;
+    LQUEUE q{ PolicyAllocator<internal::LQ_QNode<size_t>, BlockPolicy>{ policy } };
+    double ms = _profile_spsc(q, _profile_spsc_produce<LQUEUE>, _profile_spsc_consume<LQUEUE>);
+    std::cout << "LocklessQueue throughput: " << PROFILE_SPSC_ITEMS / (ms * 1000.0) << " M items/s" << std::endl;
+  }
+  {
+    SPSCRingQueue<size_t> q(4096);
+    double ms = _profile_spsc(q, _profile_spsc_produce<SPSCRingQueue<size_t>>, _profile_spsc_consume<SPSCRingQueue<size_t>>);
+    std::cout << "SPSCRingQueue throughput: " << PROFILE_SPSC_ITEMS / (ms * 1000.0) << " M items/s" << std::endl;
+  }
+  {
+    SPSCRingQueue<size_t> q(4096);
+    double ms = _profile_spsc(q, _profile_spsc_produce_batch, _profile_spsc_consume_batch);
+    std::cout << "SPSCRingQueue batch throughput: " << PROFILE_SPSC_ITEMS / (ms * 1000.0) << " M items/s" << std::endl;
+  }
+
+  const size_t TRIPS = 100000;
+  {
+    BlockPolicy<internal::LQ_QNode<size_t>> policy1, policy2;
+    LQUEUE ping{ PolicyAllocator<internal::LQ_QNode<size_t>, BlockPolicy>{ policy1 } };
+    LQUEUE pong{ PolicyAllocator<internal::LQ_QNode<size_t>, BlockPolicy>{ policy2 } };
+    std::cout << "LocklessQueue round trip: " << _profile_spsc_latency(ping, pong, TRIPS) << " ns" << std::endl;
+  }
+  {
+    SPSCRingQueue<size_t> ping(64), pong(64);
+    std::cout << "SPSCRingQueue round trip: " << _profile_spsc_latency(ping, pong, TRIPS) << " ns" << std::endl;
+  }
+}
@@ -0,0 +1,119 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/ArraySort.h"
+#include "buntils/HighPrecisionTimer.h"
+#include "buntils/Parallel.h"
+#include <iostream>
+#include <numeric>
+
+using namespace bun;
+
+TESTDEF::RETPAIR test_PARALLEL()
+{
+  BEGINTEST;
+  for(auto mode : { ThreadPool::MODE_SHARED, ThreadPool::MODE_STEALING })
+  {
+    ThreadPool pool(std::thread::hardware_concurrency(), mode);
+
+    DynArray<uint64_t> a(100000);
+    a.SetLength(100000);
+    ParallelFor(pool, 0, a.size(), [&](size_t begin, size_t end) {
+      for(size_t i = begin; i < end; ++i)
+        a[i] = i;
+    });
+    ParallelFor(pool, a, [](uint64_t& x) { x = x * 3 + 1; });
+    bool check = true;
+    for(size_t i = 0; i < a.size(); ++i)
+      check = check && a[i] == i * 3 + 1;
+    TEST(check);
+
+    std::atomic<size_t> count = 0;
+    ParallelFor(pool, 0, 1000, [&](size_t begin, size_t end) { count.fetch_add(end - begin); }, 1);
+    TEST(count.load() == 1000);
+    ParallelFor(pool, 5, 5, [&](size_t begin, size_t end) { count.fetch_add(1); });
+    TEST(count.load() == 1000);
+
+    TEST(ParallelReduce(pool, a, (uint64_t)7) == std::accumulate(a.begin(), a.end(), (uint64_t)7));
+    TEST(ParallelReduce(pool, DynArray<int>(), 3) == 3);
+    TEST(ParallelReduce(pool, a, (uint64_t)0, [](uint64_t l, uint64_t r) { return bun_max(l, r); }) == a.Back());
+
+    ArraySort<int> sorted;
+    for(int i = 0; i < 1000; ++i)
+      sorted.Insert((i * 7919) % 1000);
+    TEST(ParallelReduce(pool, sorted, 0) == 499500);
+
+    Array<uint64_t> scan(a.size());
+    std::inclusive_scan(a.begin(), a.end(), scan.begin());
+    ParallelScan(pool, a, a.begin());
+    TEST(std::equal(a.begin(), a.end(), scan.begin()));
+    int tiny[1] = { 4 };
+    ParallelScan(pool, tiny, tiny);
+    TEST(tiny[0] == 4);
+
+    XorshiftEngine<uint64_t> engine(42);
+    for(size_t n : { 0, 1, 2, 3, 17, 1000, 100003 })
+    {
+      DynArray<int> values(n);
+      values.SetLength(n);
+      for(auto& v : values)
+        v = (int)(engine() % 1000);
+      Array<int> expected(values);
+      std::sort(expected.begin(), expected.end());
+      ParallelSort(pool, values);
+      TEST(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+    }
+
+    DynArray<std::pair<int, int>> pairs;
+    for(int i = 0; i < 50000; ++i)
+      pairs.Add({ (int)(engine() % 100), i });
+    ParallelSort(pool, pairs, [](const std::pair<int, int>& l, const std::pair<int, int>& r) { return r.first <=> l.first; });
+    check = true;
+    for(size_t i = 1; i < pairs.size(); ++i)
+      check = check && pairs[i - 1].first >= pairs[i].first;
+    TEST(check);
+
+    pool.Wait();
+    TEST(!pool.Busy());
+  }
+  ENDTEST;
+}
+
+// Compares the parallel algorithms against their serial std counterparts.
+void profile_parallel()
+{
+  ThreadPool pool(ThreadPool::MODE_STEALING);
+  XorshiftEngine<uint64_t> engine(42);
+
+  for(size_t n : { 1000000, 10000000, 100000000 })
+  {
+    DynArray<uint32_t> values(n);
+    values.SetLength(n);
+    for(auto& v : values)
+      v = (uint32_t)engine();
+    DynArray<uint32_t> copy(values);
+
+    uint64_t prof = HighPrecisionTimer::OpenProfiler();
+    uint64_t sum  = std::accumulate(values.begin(), values.end(), (uint64_t)0);
+    std::cout << "std::accumulate " << n << ": " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms"
+              << std::endl;
+
+    prof = HighPrecisionTimer::OpenProfiler();
+    if(ParallelReduce(pool, values, (uint64_t)0) != sum)
+      std::cout << "ParallelReduce returned the wrong sum!" << std::endl;
+    std::cout << "ParallelReduce " << n << ": " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms"
+              << std::endl;
+
+    prof = HighPrecisionTimer::OpenProfiler();
+    std::sort(copy.begin(), copy.end());
+    std::cout << "std::sort " << n << ": " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+
+    prof = HighPrecisionTimer::OpenProfiler();
+    ParallelSort(pool, values);
+    std::cout << "ParallelSort " << n << ": " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms"
+              << std::endl;
+    if(!std::equal(values.begin(), values.end(), copy.begin(), copy.end()))
+      std::cout << "ParallelSort returned the wrong order!" << std::endl;
+  }
+}
@@ -2,7 +2,14 @@
 // For conditions of distribution and use, see copyright notice in "buntils.h"
 
 #include "test.h"
+#include "buntils/HighPrecisionTimer.h"
 #include "buntils/Serializer.h"
+#include <bit>
+#include <charconv>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
 
 using namespace bun;
 
@@ -35,5 +42,142 @@ TESTDEF::RETPAIR test_Serializer()
   SerializerTest test;
   s.Serialize(test, std::cout, "");
   s.Parse(test, std::cin, "");
+
+  {
+    using internal::serializer::FieldTable;
+    std::vector<std::string> names;
+    std::vector<const char*> ptrs;
+    for(int i = 0; i < 300; ++i)
+      names.push_back("field" + std::to_string(i));
+    for(auto& n : names)
+      ptrs.push_back(n.c_str());
+    ptrs.push_back("");
+    ptrs.push_back("field7"); // Duplicates can't be found, just like with the old Trie
+
+    FieldTable table(ptrs);
+    bool check = true;
+    for(size_t i = 0; i < names.size(); ++i)
+      check = check && table.Find(names[i].c_str()) == i;
+    TEST(check);
+    TEST(table.Find("") == 300);
+    TEST(table.Find("field") == FieldTable::NONE);
+    TEST(table.Find("field3000") == FieldTable::NONE);
+    TEST(table.Find("Field1") == FieldTable::NONE);
+    TEST(table.Find(nullptr) == FieldTable::NONE);
+
+    FieldTable single({ "a" });
+    TEST(single.Find("a") == 0);
+    TEST(single.Find("b") == FieldTable::NONE);
+  }
+
+  {
+    char buf[NUMBER_BUFFER_SIZE];
+    auto fmt = [&](auto v) { return std::string(buf, FormatNumber(buf, v)); };
+    TEST(fmt(INT64_MIN) == "-9223372036854775808");
+    TEST(fmt(UINT64_MAX) == "18446744073709551615");
+    TEST(fmt('A') == "65"); // char types are numbers, not characters
+    TEST(fmt(int8_t(-5)) == "-5");
+    TEST(fmt(uint16_t(65535)) == "65535");
+    TEST(fmt(0.1) == "0.1");
+    TEST(fmt(0.2f) == "0.2"); // Shortest for a float, not for the double it would be promoted to
+    TEST(fmt(1e300) == "1e+300");
+    TEST(fmt(-0.0) == "-0");
+    TEST(fmt(std::numeric_limits<double>::denorm_min()) == "5e-324");
+
+    bool check = true;
+    for(int i = 0; i < 100000; ++i) // Any finite double has to parse back to exactly the same bits
+    {
+      uint64_t bits = (uint64_t(bun_RandInt(0, INT32_MAX)) << 33) ^ (uint64_t(bun_RandInt(0, INT32_MAX)) << 2) ^ i;
+      double d      = std::bit_cast<double>(bits);
+      if(!std::isfinite(d))
+        continue;
+      double r = 0;
+      char* end = FormatNumber(buf, d);
+      auto [ptr, ec] = std::from_chars(buf, end, r);
+      check = check && ec == std::errc() && ptr == end && std::bit_cast<uint64_t>(r) == bits;
+    }
+    TEST(check);
+
+    std::ostringstream ss;
+    ss.precision(2); // Ignored, along with every other formatting flag
+    ss << std::hex;
+    WriteNumber(ss, 23.7193);
+    ss << ' ';
+    WriteNumber(ss, 255);
+    TEST(ss.str() == "23.7193 255");
+    std::string appended = "x=";
+    AppendNumber(appended, -1.5f);
+    TEST(appended == "x=-1.5");
+  }
   ENDTEST;
-}
\ No newline at end of file
+}
+
+// Compares looking up the field names of a large config struct with FieldTable against the Trie it replaced
+void profile_field_dispatch()
+{
+  std::vector<std::string> names;
+  const char* ptrs[64];
+  for(int i = 0; i < 64; ++i)
+    names.push_back("config_option_" + std::to_string(i * 7919));
+  for(int i = 0; i < 64; ++i)
+    ptrs[i] = names[i].c_str();
+  Trie<uint16_t> trie(ptrs);
+  internal::serializer::FieldTable table(ptrs);
+
+  constexpr int ROUNDS = 100000;
+  size_t sum           = 0;
+  uint64_t prof        = HighPrecisionTimer::OpenProfiler();
+  for(int k = 0; k < ROUNDS; ++k)
+    for(auto p : ptrs)
+      sum += trie[p];
+  std::cout << "Trie: " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+
+  prof = HighPrecisionTimer::OpenProfiler();
+  for(int k = 0; k < ROUNDS; ++k)
+    for(auto p : ptrs)
+      sum += table.Find(p);
+  std::cout << "FieldTable: " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+  if(sum == 1)
+    std::cout << sum;
+}
+// Formats a telemetry-sized batch of doubles and integers through an ostream with enough precision to round trip, and
+// through WriteNumber and AppendNumber
+void profile_number_format()
+{
+  std::vector<double> values;
+  for(int i = 0; i < 1000000; ++i)
+    values.push_back(i * 0.731 + (i % 97) * 1e-7);
+
+  std::ostringstream a;
+  a.precision(17);
+  uint64_t prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < values.size(); ++i)
+    a << values[i] << ',' << static_cast<int64_t>(i) << ',';
+  double stream = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::ostringstream b;
+  prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < values.size(); ++i)
+  {
+    WriteNumber(b, values[i]);
+    b.put(',');
+    WriteNumber(b, static_cast<int64_t>(i));
+    b.put(',');
+  }
+  double write = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::string c;
+  prof = HighPrecisionTimer::OpenProfiler();
+  for(size_t i = 0; i < values.size(); ++i)
+  {
+    AppendNumber(c, values[i]);
+    c += ',';
+    AppendNumber(c, static_cast<int64_t>(i));
+    c += ',';
+  }
+  double append = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+  std::cout << values.size() << " doubles and integers: ostream " << stream << " ms (" << a.str().size()
+            << " bytes), WriteNumber " << write << " ms (" << b.str().size() << " bytes), AppendNumber " << append
+            << " ms (" << c.size() << " bytes)" << std::endl;
+}
@@ -0,0 +1,82 @@
+// Copyright (c)2026 Erik McClure
+// For conditions of distribution and use, see copyright notice in "buntils.h"
+
+#include "test.h"
+#include "buntils/TaskGraph.h"
+
+using namespace bun;
+
+const size_t TG_LAYERS = 8;
+const size_t TG_WIDTH  = 16;
+std::atomic<size_t> tg_clock;
+std::atomic<size_t> tg_done;
+size_t tg_stamp[TG_LAYERS * TG_WIDTH];
+
+void tgnode(void* arg) { tg_stamp[(size_t)arg] = tg_clock.fetch_add(1, std::memory_order_relaxed) + 1; }
+void tgdone(void*) { tg_done.fetch_add(1, std::memory_order_relaxed); }
+
+TESTDEF::RETPAIR test_TASKGRAPH()
+{
+  BEGINTEST;
+  for(auto mode : { ThreadPool::MODE_SHARED, ThreadPool::MODE_STEALING })
+  {
+    ThreadPool pool(std::thread::hardware_concurrency(), mode);
+    TaskGraph graph;
+    bool added = true;
+    for(size_t i = 0; i < TG_LAYERS * TG_WIDTH; ++i)
+      added = added && graph.AddNode(tgnode, (void*)i) == i;
+    TEST(added);
+
+    // Each node depends on two nodes in the layer above it, so every layer forms a series of overlapping diamonds.
+    for(size_t l = 1; l < TG_LAYERS; ++l)
+      for(size_t w = 0; w < TG_WIDTH; ++w)
+      {
+        graph.AddEdge((l - 1) * TG_WIDTH + w, l * TG_WIDTH + w);
+        graph.AddEdge((l - 1) * TG_WIDTH + ((w + 1) % TG_WIDTH), l * TG_WIDTH + w);
+      }
+    graph.SetContinuation(tgdone, 0);
+    tg_done = 0;
+
+    for(int run = 0; run < 20; ++run)
+    {
+      tg_clock = 0;
+      bun_Fill(tg_stamp, 0);
+      pool.Run(graph).Wait();
+      TEST(!graph.Running());
+      TEST(tg_done.load() == run + 1);
+      TEST(tg_clock.load() == TG_LAYERS * TG_WIDTH);
+
+      bool check = true;
+      for(size_t l = 1; l < TG_LAYERS; ++l)
+        for(size_t w = 0; w < TG_WIDTH; ++w)
+        {
+          size_t i = l * TG_WIDTH + w;
+          check    = check && tg_stamp[i] > tg_stamp[i - TG_WIDTH] &&
+                  tg_stamp[i] > tg_stamp[(l - 1) * TG_WIDTH + ((w + 1) % TG_WIDTH)];
+        }
+      TEST(check);
+    }
+
+    // A single chain has to run strictly in order
+    TaskGraph chain;
+    for(size_t i = 0; i < TG_WIDTH; ++i)
+      chain.AddNode(tgnode, (void*)i);
+    for(size_t i = 1; i < TG_WIDTH; ++i)
+      chain.AddEdge(i - 1, i);
+    tg_clock = 0;
+    pool.Run(chain).Wait();
+    bool check = true;
+    for(size_t i = 0; i < TG_WIDTH; ++i)
+      check = check && tg_stamp[i] == i + 1;
+    TEST(check);
+
+    TaskGraph empty;
+    tg_done = 0;
+    empty.SetContinuation(tgdone, 0);
+    pool.Run(empty).Wait();
+    TEST(tg_done.load() == 1);
+    pool.Wait();
+    TEST(!pool.Busy());
+  }
+  ENDTEST;
+}
@@ -2,8 +2,10 @@
 // For conditions of distribution and use, see copyright notice in "buntils.h"
 
 #include "test.h"
+#include "buntils/HighPrecisionTimer.h"
 #include "buntils/ThreadPool.h"
 #include <algorithm>
+#include <iostream>
 
 using namespace bun;
 
@@ -19,12 +21,42 @@ void pooltest(int i)
     ;
   pq_end[pq_c.fetch_add(1, std::memory_order_relaxed)] = i;
 }
+const size_t SPAWN_DEPTH = 12;
+ThreadPool* spawnpool;
+std::atomic<size_t> spawnleaves;
+
+// Each task is a node in an implicit binary tree, and queues its two children from inside the pool, which in
+// MODE_STEALING puts them on the local worker's deque.
+void poolspawn(void* arg)
+{
+  size_t i = (size_t)arg;
+  if(i >= (size_t(1) << SPAWN_DEPTH) - 1)
+    spawnleaves.fetch_add(1, std::memory_order_relaxed);
+  else
+  {
+    spawnpool->AddTask(poolspawn, (void*)(i * 2 + 1));
+    spawnpool->AddTask(poolspawn, (void*)(i * 2 + 2));
+  }
+}
+
+// Naive recursive fibonacci that computes one branch as a Future, which forces workers to block on Futures that other
+// workers (or they themselves) still have to run.
+size_t poolfib(ThreadPool* pool, size_t n)
+{
+  if(n < 2)
+    return n;
+  Future<size_t> a(*pool, poolfib, pool, n - 1);
+  size_t b = poolfib(pool, n - 2);
+  return a.Get() + b;
+}
+
 TESTDEF::RETPAIR test_THREADPOOL()
 {
   BEGINTEST;
+  for(auto mode : { ThreadPool::MODE_SHARED, ThreadPool::MODE_STEALING })
   {
     unsigned int NUM = std::thread::hardware_concurrency();
-    ThreadPool pool(NUM);
+    ThreadPool pool(NUM, mode);
     bun_Fill(pq_end, 0);
     pq_c      = 0;
     initcount = 0;
@@ -45,7 +77,108 @@ TESTDEF::RETPAIR test_THREADPOOL()
     for(size_t i = 0; i < TESTNUM; ++i)
       check = (pq_end[i] == i) && check;
     TEST(check);
+
+    spawnpool   = &pool;
+    spawnleaves = 0;
+    pool.AddTask(poolspawn, 0);
+    pool.Wait();
+    TEST(spawnleaves.load() == (size_t(1) << SPAWN_DEPTH));
+    TEST(!pool.Busy());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TEST(pool.GetIdleStats().parks > 0); // Idle workers should have stopped spinning by now
+
+    pq_c = 0;
+    pool.AddFunc(pooltest, 0);
+    pool.AddTask([](void*) { pq_c.fetch_add(1, std::memory_order_relaxed); }, 0, 100);
+    pool.Wait();
+    TEST(pq_c == 101);
+
+    pool.SetIdlePolicy(0, ThreadPool::NEVER_PARK);
+    pq_c = 0;
+    pool.AddTask([](void*) { pq_c.fetch_add(1, std::memory_order_relaxed); }, 0, 0);
+    pool.Wait();
+    TEST(pq_c == NUM);
+
+    Future sum(pool, [](int a, int b) { return a + b; }, 2, 3);
+    TEST(sum.Get() == 5);
+    auto chain = sum.Then([](int& x) { return x * 2; }).Then([](int& x) { return (size_t)x + 1; });
+    TEST(chain.Get() == 11);
+    TEST(*chain.Result() == 11);
+    TEST(sum.Ready());
+
+    pq_c = 0;
+    Future<void> none(pool, []() { pq_c.fetch_add(1, std::memory_order_relaxed); });
+    TEST(none.Then([]() { return (int)pq_c.load(std::memory_order_relaxed); }).Get() == 1);
+
+    DynArray<Future<size_t>> fanout;
+    for(size_t i = 0; i < 100; ++i)
+      fanout.Add(Future<size_t>(pool, [](size_t x) { return x * x; }, i));
+    WhenAll(pool, std::span<const Future<size_t>>(fanout.begin(), fanout.size())).Wait();
+    size_t total = 0;
+    bool ready   = true;
+    for(auto& f : fanout)
+    {
+      ready = ready && f.Ready();
+      total += *f.Result();
+    }
+    TEST(ready);
+    TEST(total == 328350);
+    TEST(WhenAll(pool, sum, none, chain).Then([&]() { return *sum.Result() + *chain.Result(); }).Get() == 16);
+
+    Future<int> first(pool, []() { return 1; });
+    auto second = first.Then([](int& x) { return x + 1; });
+    // Both can finish before WhenAny() listens to them, so either index is valid as long as that future is ready.
+    size_t any = WhenAny(pool, second, first).Get();
+    TEST(any < 2);
+    TEST(any ? first.Ready() : second.Ready());
+    TEST(poolfib(&pool, 16) == 987);
+    pool.Wait();
+    TEST(!pool.Busy());
   }
 
   ENDTEST;
 }
+
+void poolwork(void* arg)
+{
+  volatile size_t x = 0;
+  for(size_t i = 0; i < (size_t)arg; ++i)
+    x = x + i;
+}
+
+// Compares the shared queue against work stealing, both for tasks queued from outside the pool and for tasks that
+// recursively spawn more tasks from inside it.
+void profile_threadpool()
+{
+  const size_t COUNT = 200000;
+  const char* NAMES[] = { "shared", "stealing" };
+
+  for(size_t work : { 0, 100, 1000, 10000 })
+  {
+    for(auto mode : { ThreadPool::MODE_SHARED, ThreadPool::MODE_STEALING })
+    {
+      ThreadPool pool(mode);
+      uint64_t prof = HighPrecisionTimer::OpenProfiler();
+      for(size_t i = 0; i < COUNT; ++i)
+        pool.AddTask(poolwork, (void*)work);
+      pool.Wait();
+      auto stats = pool.GetIdleStats();
+      std::cout << "ThreadPool (" << NAMES[mode] << ") " << COUNT << " external tasks of size " << work << ": "
+                << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms (spinning: " << stats.spinning / 1000000.0
+                << " ms, parked: " << stats.parked / 1000000.0 << " ms, " << stats.parks << " parks)" << std::endl;
+    }
+  }
+
+  for(auto mode : { ThreadPool::MODE_SHARED, ThreadPool::MODE_STEALING })
+  {
+    ThreadPool pool(mode);
+    spawnpool   = &pool;
+    spawnleaves = 0;
+    uint64_t prof = HighPrecisionTimer::OpenProfiler();
+    pool.AddTask(poolspawn, 0);
+    pool.Wait();
+    std::cout << "ThreadPool (" << NAMES[mode] << ") " << ((size_t(2) << SPAWN_DEPTH) - 1)
+              << " spawned tasks: " << HighPrecisionTimer::CloseProfiler(prof) / 1000000.0 << " ms" << std::endl;
+  }
+}
@@ -4,6 +4,12 @@
 #include "test.h"
 #include "buntils/algo.h"
 #include "buntils/Trie.h"
+#include "buntils/Hash.h"
+#include "buntils/HighPrecisionTimer.h"
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 using namespace bun;
 
@@ -134,5 +140,99 @@ TESTDEF::RETPAIR test_TRIE()
   }
   TEST(tins[strs[9]] == 0);
 
+  {
+    uint8_t found[std::ranges::size(strs)];
+    t.GetMany(strs, found);
+    bool check = true;
+    for(size_t i = 0; i < std::ranges::size(strs); ++i)
+      check = check && found[i] == t[strs[i]];
+    TEST(check);
+    const char* partial[] = { "o", "ontic", "ontickx", "", "t" };
+    uint8_t miss[std::ranges::size(partial)];
+    t.GetMany(partial, miss);
+    TEST((miss[0] == 255 && miss[1] == 255 && miss[2] == 255 && miss[3] == 255 && miss[4] == 255));
+    tins.GetMany(casestr, found);
+    TEST((found[3] == 3 && found[7] == 7 && found[8] == 8));
+    TEST(t.Get("tickle", 4) == 0);
+    TEST(t.Get("ro", 1) == 255);
+  }
+
+  {
+    // More than 16 siblings under one node forces the child search to span several 16 byte blocks
+    std::vector<std::string> words;
+    for(char a = '!'; a <= '~'; ++a)
+    {
+      words.push_back(std::string(1, a));
+      for(char b = 'a'; b <= 'z'; ++b)
+        words.push_back(std::string(1, a) + b);
+    }
+    std::vector<const char*> ptrs;
+    for(auto& w : words)
+      ptrs.push_back(w.c_str());
+    Trie<uint32_t> big(ptrs);
+    bool check = true;
+    for(size_t i = 0; i < ptrs.size(); ++i)
+      check = check && big[ptrs[i]] == i;
+    TEST(check);
+    std::vector<uint32_t> found(ptrs.size());
+    big.GetMany(ptrs, found);
+    TEST(std::ranges::equal(found, std::views::iota(uint32_t(0), uint32_t(ptrs.size()))));
+    TEST(big["a{"] == (uint32_t)~0);
+    TEST(big["\x7F"] == (uint32_t)~0);
+  }
+
   ENDTEST;
 }
+
+// Compares single lookups against GetMany and a Hash on random keyword sets of increasing size
+void profile_trie()
+{
+  constexpr size_t PROBES = 1 << 22;
+
+  for(size_t num : { 100, 1000, 10000, 100000 })
+  {
+    std::unordered_set<std::string> unique;
+    while(unique.size() < num)
+    {
+      std::string w;
+      for(int j = bun_RandInt(3, 12); j > 0; --j)
+        w += (char)bun_RandInt('a', 'z');
+      unique.insert(w);
+    }
+    std::vector<std::string> words;
+    for(auto& w : unique)
+      words.push_back(w);
+    std::vector<const char*> ptrs;
+    for(auto& w : words)
+      ptrs.push_back(w.c_str());
+    std::vector<const char*> probe(PROBES);
+    for(auto& p : probe)
+      p = ptrs[bun_RandInt(0, num - 1)];
+
+    Trie<uint32_t> trie(ptrs);
+    Hash<const char*, uint32_t> hash;
+    for(size_t i = 0; i < num; ++i)
+      hash.Insert(ptrs[i], (uint32_t)i);
+
+    uint64_t sum = 0;
+    uint64_t prof = HighPrecisionTimer::OpenProfiler();
+    for(auto p : probe)
+      sum += trie.Get(p);
+    double single = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+    std::vector<uint32_t> out(PROBES);
+    prof = HighPrecisionTimer::OpenProfiler();
+    trie.GetMany(probe, out);
+    double many = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+    for(auto v : out)
+      sum -= v;
+
+    prof = HighPrecisionTimer::OpenProfiler();
+    for(auto p : probe)
+      sum += hash.Get(p);
+    double hashed = HighPrecisionTimer::CloseProfiler(prof) / 1000000.0;
+
+    std::cout << num << " words: Get " << single << " ms, GetMany " << many << " ms, Hash " << hashed << " ms ("
+              << sum << ")" << std::endl;
+  }
+}
@@ -56,72 +56,6 @@ int getuniformint()
   return samples[cur++];
 }
 
-/*template<class Alloc, int MAX, int SZ>
-void profile_push(Alloc& a, std::atomic<void*>* q)
-{
-while(!startflag.load(std::memory_order_acquire));
-uint64_t c;
-while((c=lq_c.fetch_add(1, std::memory_order_acquire))<MAX) {
-void* p=a.allocate((c<<3)%SZ);
-q[c].store((!p?(void*)1:p), std::memory_order_release);
-//q[c] = p;
-}
-}
-
-std::atomic<size_t> lq_r;
-
-template<class Alloc, int MAX>
-void profile_pop(Alloc& a, std::atomic<void*>* q)
-{
-while(!startflag.load(std::memory_order_acquire));
-void* p;
-uint64_t c;
-while((c=lq_r.fetch_add(1, std::memory_order_acquire))<MAX)
-{
-while(!(p = q[c].load(std::memory_order_acquire)));
-a.deallocate((size_t*)p);
-}
-startflag.store(false, std::memory_order_release);
-}
-
-template<class Alloc, int MAX, int SZ>
-uint64_t doprofile(Alloc& a)
-{
-lq_c.store(0);
-lq_r.store(0);
-std::atomic<void*> arr[MAX];
-memset(arr, 0, sizeof(void*)*MAX);
-const int NUM = 8;
-Thread threads[NUM];
-startflag.store(false);
-for(size_t i = 0; i < NUM; ++i)
-threads[i] = Thread((i%2)?&profile_pop<Alloc, MAX>:&profile_push<Alloc, MAX, SZ>, std::ref(a), arr);
-
-auto prof = HighPrecisionTimer::OpenProfiler();
-startflag.store(true);
-
-while(startflag.load(std::memory_order_acquire));
-uint64_t diff = HighPrecisionTimer::CloseProfiler(prof);
-
-for(size_t i = 0; i < NUM; ++i)
-threads[i].join();
-
-return diff;
-}
-
-void profile_ring_alloc()
-{
-NullAllocPolicy<size_t> nalloc;
-RingPolicy<size_t> ralloc(50000);
-StandardAllocPolicy<size_t> salloc;
-//std::this_thread::sleep_for(std::chrono::duration<uint64_t>::min());
-
-std::cout << doprofile<NullAllocPolicy<size_t>, 500000, 100>(nalloc) << std::endl;
-std::cout << doprofile<StandardAllocPolicy<size_t>, 500000, 100>(salloc) << std::endl;
-std::cout << doprofile<RingPolicy<size_t>, 500000, 100>(ralloc) << std::endl;
-std::cout << doprofile<NullAllocPolicy<size_t>, 500000, 100>(nalloc) << std::endl;
-}*/
-
 /*void subleq_computer(int[] mem)
 {
 int c=0;